@@ -0,0 +1,25 @@
+{
+  "targets": [
+    {
+      "target_name": "deadlock_native",
+      "sources": [
+        "deadlock_native.c",
+        "../../src/api_commands.c",
+        "../../src/headroom.c",
+        "../../src/stats.c",
+        "../../src/json_writer.c",
+        "../../src/planner.c",
+        "../../src/step_iterator.c",
+        "../../src/deadlock_detector.c",
+        "../../src/simd_kernels.c",
+        "../../src/small_detect.c",
+        "../../src/bitset_detect.c",
+        "../../src/worklist.c",
+        "../../src/rag.c"
+      ],
+      "include_dirs": ["../../src"],
+      "cflags_c": ["-std=c99", "-O2"],
+      "defines": ["NAPI_VERSION=8"]
+    }
+  ]
+}
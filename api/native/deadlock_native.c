@@ -0,0 +1,431 @@
+/*
+ * Deadlock Detection System - Node native addon.
+ * Runs the C core in-process: every call takes the matrices as Int32Array
+ * views (available[nr], allocation[np * nr], max_need[np * nr], row-major),
+ * copies them into a padded SystemState on the libuv thread pool and
+ * resolves a Promise.
+ *
+ *   detect(np, nr, available, allocation, maxNeed)   -> DetectResponse object
+ *   rag(np, nr, available, allocation, maxNeed)      -> JSON string
+ *   resolve(np, nr, ..., victim)                     -> JSON string
+ *   simulate(np, nr, ..., processIndex, resourceIndex, amount) -> JSON string
+ *   headroom(np, nr, available, allocation, maxNeed) -> JSON string
+ *   plan(np, nr, ..., costModel, maxCandidates[, priorities]) -> JSON string
+ *     (priorities: Int32Array[np], required for cost model 1)
+ *   stepStart(np, nr, available, allocation, maxNeed) -> step session (external)
+ *   step(session)                                    -> JSON string
+ *   stepEnd(session)                                 -> boolean
+ *
+ * step() and stepEnd() run synchronously: a step only touches the resources
+ * its process releases. A session is freed by the step that reports done
+ * or deadlock, by stepEnd(), or when it is garbage collected.
+ *
+ * The JSON strings are exactly what api_worker prints for the same command.
+ * A job that runs out of memory rejects its Promise with "out of memory"
+ * instead of exiting the process (the scratch buffers it had allocated are
+ * leaked), so the caller can fall back to another backend.
+ * The typed arrays are pinned with references until the call completes and
+ * must not be modified meanwhile.
+ */
+
+#include <setjmp.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <node_api.h>
+#include "api_commands.h"
+#include "deadlock_detector.h"
+#include "step_iterator.h"
+
+#define NAPI_CALL(env, call)                                   \
+    do {                                                       \
+        if ((call) != napi_ok) {                               \
+            napi_throw_error((env), NULL, "N-API call failed");\
+            return NULL;                                       \
+        }                                                      \
+    } while (0)
+
+typedef enum {
+    JOB_DETECT,
+    JOB_RAG,
+    JOB_RESOLVE,
+    JOB_SIMULATE,
+    JOB_HEADROOM,
+    JOB_PLAN,
+    JOB_STEP_START
+} JobKind;
+
+// What a step session external points to; it is NULL once the session ended
+typedef struct {
+    StepIterator *it;
+} StepHandle;
+
+typedef struct {
+    JobKind kind;
+    int num_processes;
+    int num_resources;
+    const int32_t *matrices[4];   // available, allocation, max_need, priorities (borrowed)
+    napi_ref refs[4];
+    int args[3];
+    napi_deferred deferred;
+    napi_async_work work;
+    const char *error;
+    SystemState state;            // the job's copy of the matrices
+    DetectionResult result;       // JOB_DETECT
+    JsonWriter json;              // other jobs
+    StepIterator *step;           // JOB_STEP_START
+} Job;
+
+// Copy the caller's rows into a padded SystemState; runs off the main thread.
+// Rows that need no padding are copied too: the core writes to the state and
+// owns its storage as one aligned block.
+static const char *load_state(const Job *job, SystemState *state) {
+    int np = job->num_processes;
+    int nr = job->num_resources;
+    if (!init_system_state(state, np, nr)) {
+        return "out of memory";
+    }
+    memcpy(state->available, job->matrices[0], (size_t)nr * sizeof(int));
+    for (int i = 0; i < np; i++) {
+        memcpy(state->allocation[i], job->matrices[1] + (size_t)i * nr, (size_t)nr * sizeof(int));
+        memcpy(state->max_need[i], job->matrices[2] + (size_t)i * nr, (size_t)nr * sizeof(int));
+    }
+    return NULL;
+}
+
+// Where an allocation failure in the core leaves to on this pool thread
+static __thread jmp_buf *job_escape;
+
+// out_of_memory() handler: abandon the running job rather than exit the
+// server; off a job (e.g. step() on the main thread) the default exit runs
+static void job_out_of_memory(void) {
+    if (job_escape) longjmp(*job_escape, 1);
+}
+
+static void execute_job(napi_env env, void *data) {
+    (void)env;
+    Job *job = data;
+    SystemState *state = &job->state;
+    jmp_buf escape;
+    if (setjmp(escape)) {
+        // Only job fields are trusted here; the failed call's scratch leaks
+        job_escape = NULL;
+        job->error = "out of memory";
+        if (job->step) {
+            // The iterator owns the state from its first line; its worklist leaks
+            free_system_state(&job->step->state);
+            free(job->step);
+            job->step = NULL;
+        }
+        free_system_state(state);
+        return;
+    }
+    job->error = load_state(job, state);
+    if (job->error) {
+        return;
+    }
+    job_escape = &escape;
+
+    if (job->kind == JOB_DETECT) {
+        detect_deadlock(state, &job->result);
+    } else if (job->kind == JOB_STEP_START) {
+        job->step = malloc(sizeof(StepIterator));
+        if (!job->step) {
+            job->error = "out of memory";
+        } else if (!step_iterator_init(job->step, state)) {
+            job->error = "Step sessions need non-negative allocations.";
+        }
+    } else {
+        JsonWriter *out = &job->json;
+        if (job->kind == JOB_RAG) {
+            api_rag(out, state);
+        } else if (job->kind == JOB_RESOLVE) {
+            api_resolve(out, state, job->args[0]);
+        } else if (job->kind == JOB_SIMULATE) {
+            api_simulate(out, state, job->args[0], job->args[1], job->args[2]);
+        } else if (job->kind == JOB_HEADROOM) {
+            api_headroom(out, state);
+        } else {
+            api_plan(out, state, job->args[0], job->args[1], job->matrices[3]);
+        }
+    }
+    job_escape = NULL;
+    free_system_state(state);
+}
+
+static napi_value int_array(napi_env env, const int *values, int count) {
+    napi_value array;
+    if (napi_create_array_with_length(env, (size_t)count, &array) != napi_ok) return NULL;
+    for (int i = 0; i < count; i++) {
+        napi_value v;
+        napi_create_int32(env, values[i], &v);
+        napi_set_element(env, array, (uint32_t)i, v);
+    }
+    return array;
+}
+
+static napi_value detect_object(napi_env env, const DetectionResult *res) {
+    napi_value obj, flag, length;
+    napi_create_object(env, &obj);
+    napi_get_boolean(env, res->is_deadlocked, &flag);
+    napi_create_int32(env, res->safe_sequence_length, &length);
+    napi_set_named_property(env, obj, "is_deadlocked", flag);
+    napi_set_named_property(env, obj, "deadlocked_processes",
+                            int_array(env, res->deadlocked_processes, res->num_deadlocked));
+    napi_set_named_property(env, obj, "safe_sequence",
+                            int_array(env, res->safe_sequence, res->safe_sequence_length));
+    napi_set_named_property(env, obj, "safe_sequence_length", length);
+    return obj;
+}
+
+static void end_step(StepHandle *handle) {
+    if (handle->it) {
+        step_iterator_free(handle->it);
+        free(handle->it);
+        handle->it = NULL;
+    }
+}
+
+static void finalize_step(napi_env env, void *data, void *hint) {
+    (void)env;
+    (void)hint;
+    end_step(data);
+    free(data);
+}
+
+static void complete_job(napi_env env, napi_status status, void *data) {
+    Job *job = data;
+    for (int k = 0; k < 4; k++) {
+        if (job->refs[k]) napi_delete_reference(env, job->refs[k]);
+    }
+
+    napi_value value = NULL;
+    if (status != napi_ok && !job->error) {
+        job->error = "native job cancelled";
+    }
+    if (!job->error) {
+        if (job->kind == JOB_DETECT) {
+            value = detect_object(env, &job->result);
+        } else if (job->kind == JOB_STEP_START) {
+            StepHandle *handle = malloc(sizeof(StepHandle));
+            if (!handle) {
+                job->error = "out of memory";
+            } else {
+                handle->it = job->step;
+                job->step = NULL;
+                if (napi_create_external(env, handle, finalize_step, NULL, &value) != napi_ok) {
+                    end_step(handle);
+                    free(handle);
+                    value = NULL;
+                }
+            }
+        } else {
+            napi_create_string_utf8(env, job->json.data, job->json.length, &value);
+        }
+    }
+    if (value) {
+        napi_resolve_deferred(env, job->deferred, value);
+    } else {
+        napi_value message, error;
+        napi_create_string_utf8(env, job->error ? job->error : "native call failed",
+                                NAPI_AUTO_LENGTH, &message);
+        napi_create_error(env, NULL, message, &error);
+        napi_reject_deferred(env, job->deferred, error);
+    }
+
+    napi_delete_async_work(env, job->work);
+    free_detection_result(&job->result);
+    json_free(&job->json);
+    if (job->step) {
+        StepHandle orphan = { job->step };
+        end_step(&orphan);
+    }
+    free(job);
+}
+
+// Borrow an Int32Array's storage; false (with a pending exception) on mismatch
+static bool get_int32_view(napi_env env, napi_value value, size_t expected,
+                           const char *name, const int32_t **data) {
+    bool is_typedarray = false;
+    napi_typedarray_type type;
+    size_t length;
+    void *raw;
+    if (napi_is_typedarray(env, value, &is_typedarray) != napi_ok || !is_typedarray ||
+        napi_get_typedarray_info(env, value, &type, &length, &raw, NULL, NULL) != napi_ok ||
+        type != napi_int32_array) {
+        char message[64];
+        snprintf(message, sizeof(message), "%s must be an Int32Array", name);
+        napi_throw_type_error(env, NULL, message);
+        return false;
+    }
+    if (length != expected) {
+        char message[64];
+        snprintf(message, sizeof(message), "%s must have %zu elements", name, expected);
+        napi_throw_range_error(env, NULL, message);
+        return false;
+    }
+    *data = raw;
+    return true;
+}
+
+// Shared entry point: (np, nr, available, allocation, maxNeed, ...extra ints)
+static napi_value start_job(napi_env env, napi_callback_info info, JobKind kind, size_t extra) {
+    static const char *const names[3] = { "available", "allocation", "maxNeed" };
+    napi_value argv[8];
+    size_t argc = 8;
+    NAPI_CALL(env, napi_get_cb_info(env, info, &argc, argv, NULL, NULL));
+    if (argc < 5 + extra) {
+        napi_throw_type_error(env, NULL, "Wrong number of arguments");
+        return NULL;
+    }
+
+    int np, nr;
+    if (napi_get_value_int32(env, argv[0], &np) != napi_ok ||
+        napi_get_value_int32(env, argv[1], &nr) != napi_ok) {
+        napi_throw_type_error(env, NULL, "Dimensions must be numbers");
+        return NULL;
+    }
+    if (np < 1 || nr < 1 || np > MAX_PROCESSES || nr > MAX_RESOURCES) {
+        napi_throw_range_error(env, NULL, "invalid dimensions");
+        return NULL;
+    }
+
+    const int32_t *matrices[4] = { NULL, NULL, NULL, NULL };
+    size_t sizes[3] = { (size_t)nr, (size_t)np * nr, (size_t)np * nr };
+    for (int k = 0; k < 3; k++) {
+        if (!get_int32_view(env, argv[2 + k], sizes[k], names[k], &matrices[k])) return NULL;
+    }
+    int args[3] = { 0, 0, 0 };
+    for (size_t k = 0; k < extra; k++) {
+        if (napi_get_value_int32(env, argv[5 + k], &args[k]) != napi_ok) {
+            napi_throw_type_error(env, NULL, "Arguments must be numbers");
+            return NULL;
+        }
+    }
+
+    // PLAN with the priority cost model also borrows the priorities
+    bool priorities = kind == JOB_PLAN && args[0] == 1;
+    if (priorities &&
+        (argc < 8 || !get_int32_view(env, argv[7], (size_t)np, "priorities", &matrices[3]))) {
+        if (argc < 8) napi_throw_type_error(env, NULL, "priorities are required");
+        return NULL;
+    }
+
+    Job *job = calloc(1, sizeof(Job));
+    if (!job) {
+        napi_throw_error(env, NULL, "out of memory");
+        return NULL;
+    }
+    job->kind = kind;
+    json_init(&job->json, -1);
+    job->num_processes = np;
+    job->num_resources = nr;
+    memcpy(job->matrices, matrices, sizeof(matrices));
+    memcpy(job->args, args, sizeof(args));
+    init_detection_result(&job->result);
+    for (int k = 0; k < 3; k++) {
+        napi_create_reference(env, argv[2 + k], 1, &job->refs[k]);
+    }
+    if (priorities) {
+        napi_create_reference(env, argv[7], 1, &job->refs[3]);
+    }
+
+    napi_value promise, resource_name;
+    napi_create_promise(env, &job->deferred, &promise);
+    napi_create_string_utf8(env, "deadlock_native", NAPI_AUTO_LENGTH, &resource_name);
+    napi_create_async_work(env, NULL, resource_name, execute_job, complete_job, job, &job->work);
+    napi_queue_async_work(env, job->work);
+    return promise;
+}
+
+static napi_value detect(napi_env env, napi_callback_info info) {
+    return start_job(env, info, JOB_DETECT, 0);
+}
+
+static napi_value rag(napi_env env, napi_callback_info info) {
+    return start_job(env, info, JOB_RAG, 0);
+}
+
+static napi_value resolve(napi_env env, napi_callback_info info) {
+    return start_job(env, info, JOB_RESOLVE, 1);
+}
+
+static napi_value simulate(napi_env env, napi_callback_info info) {
+    return start_job(env, info, JOB_SIMULATE, 3);
+}
+
+static napi_value headroom(napi_env env, napi_callback_info info) {
+    return start_job(env, info, JOB_HEADROOM, 0);
+}
+
+static napi_value plan(napi_env env, napi_callback_info info) {
+    return start_job(env, info, JOB_PLAN, 2);
+}
+
+static napi_value step_start(napi_env env, napi_callback_info info) {
+    return start_job(env, info, JOB_STEP_START, 0);
+}
+
+// The live session behind an external, or NULL with a pending exception
+static StepHandle *get_step_handle(napi_env env, napi_callback_info info) {
+    napi_value argv[1];
+    size_t argc = 1;
+    napi_valuetype type;
+    void *data = NULL;
+    if (napi_get_cb_info(env, info, &argc, argv, NULL, NULL) != napi_ok || argc < 1 ||
+        napi_typeof(env, argv[0], &type) != napi_ok || type != napi_external ||
+        napi_get_value_external(env, argv[0], &data) != napi_ok) {
+        napi_throw_type_error(env, NULL, "Expected a step session");
+        return NULL;
+    }
+    return data;
+}
+
+static napi_value step(napi_env env, napi_callback_info info) {
+    StepHandle *handle = get_step_handle(env, info);
+    if (!handle) return NULL;
+    if (!handle->it) {
+        napi_throw_error(env, NULL, "step session ended");
+        return NULL;
+    }
+    JsonWriter json;
+    json_init(&json, -1);
+    api_step(&json, handle->it);
+    if (handle->it->status != STEP_FOUND) end_step(handle);
+    napi_value value;
+    napi_status status = napi_create_string_utf8(env, json.data, json.length, &value);
+    json_free(&json);
+    NAPI_CALL(env, status);
+    return value;
+}
+
+static napi_value step_end(napi_env env, napi_callback_info info) {
+    StepHandle *handle = get_step_handle(env, info);
+    if (!handle) return NULL;
+    bool live = handle->it != NULL;
+    end_step(handle);
+    napi_value value;
+    NAPI_CALL(env, napi_get_boolean(env, live, &value));
+    return value;
+}
+
+static napi_value init(napi_env env, napi_value exports) {
+    set_out_of_memory_handler(job_out_of_memory);
+    napi_property_descriptor props[] = {
+        { "detect", NULL, detect, NULL, NULL, NULL, napi_default, NULL },
+        { "rag", NULL, rag, NULL, NULL, NULL, napi_default, NULL },
+        { "resolve", NULL, resolve, NULL, NULL, NULL, napi_default, NULL },
+        { "simulate", NULL, simulate, NULL, NULL, NULL, napi_default, NULL },
+        { "headroom", NULL, headroom, NULL, NULL, NULL, napi_default, NULL },
+        { "plan", NULL, plan, NULL, NULL, NULL, napi_default, NULL },
+        { "stepStart", NULL, step_start, NULL, NULL, NULL, napi_default, NULL },
+        { "step", NULL, step, NULL, NULL, NULL, napi_default, NULL },
+        { "stepEnd", NULL, step_end, NULL, NULL, NULL, napi_default, NULL },
+    };
+    NAPI_CALL(env, napi_define_properties(env, exports, sizeof(props) / sizeof(props[0]), props));
+    return exports;
+}
+
+NAPI_MODULE(NODE_GYP_MODULE_NAME, init)
@@ -1,14 +1,38 @@
 /**
- * Runs the C api_worker binary for detect, RAG, resolve, and simulate.
- * Uses stdin text protocol and parses one JSON line from stdout.
+ * Runs the C api_worker binary for detect, batch detect, RAG, resolve, simulate,
+ * headroom, plan and step sessions.
+ * Requests go to a small pool of long-lived workers started with --serve; each
+ * request is sent as a length-prefixed frame and answered by one JSON line tagged
+ * with the request id, so several requests can be pipelined per worker.
+ * Pooled workers use the binary framing (dimensions in a fixed header, matrices
+ * as little-endian int32 arrays; see src/wire_protocol.h) so large states are
+ * neither formatted nor parsed as text. Set C_WORKER_PROTOCOL=text to use the
+ * text framing, or C_WORKER_MODE=spawn to start one process per request instead.
+ * Workers run with --stats unless C_WORKER_STATS=0; their phase timings and
+ * counters are recorded for GET /metrics (see metrics.ts).
  * If the binary is missing or fails, callers should fall back to TypeScript implementation.
+ * C_WORKER=0 makes the binary count as missing (e.g. to load-test the fallback).
  */
 
-import { spawn } from 'child_process';
+import { spawn, type ChildProcessWithoutNullStreams } from 'child_process';
+import * as os from 'os';
 import * as path from 'path';
 import * as fs from 'fs';
+import { observeWorkerSpawn, recordWorkerStats, type WorkerStats } from './metrics';
 
 const WORKER_TIMEOUT_MS = 10000;
+const POOL_SIZE = Math.max(1, Number(process.env.C_WORKER_POOL_SIZE) || Math.min(4, os.cpus().length));
+const SPAWN_PER_REQUEST = process.env.C_WORKER_MODE === 'spawn';
+// Int32Array views are host-endian; the wire format is little-endian
+const BINARY_PROTOCOL = process.env.C_WORKER_PROTOCOL !== 'text' && os.endianness() === 'LE';
+// Threads each worker uses for one DETECT (api_worker --threads)
+const DETECT_THREADS = Math.max(1, Number(process.env.C_WORKER_THREADS) || 1);
+// Phase timings and counters for /metrics (api_worker --stats); C_WORKER_STATS=0 turns them off
+const WORKER_STATS = process.env.C_WORKER_STATS !== '0';
+const WORKER_ARGS = [
+  ...(DETECT_THREADS > 1 ? ['--threads', String(DETECT_THREADS)] : []),
+  ...(WORKER_STATS ? ['--stats'] : []),
+];
 
 /** Path to api_worker binary (project root when running from api/). */
 function getWorkerPath(): string {
@@ -19,8 +43,9 @@ function getWorkerPath(): string {
   return fromApi; // prefer relative to api/
 }
 
-/** Check if the C worker binary is available. */
+/** Check if the C worker binary is available (C_WORKER=0 turns the worker off). */
 export function isCWorkerAvailable(): boolean {
+  if (process.env.C_WORKER === '0') return false;
   const p = getWorkerPath();
   try {
     return fs.existsSync(p);
@@ -37,6 +62,30 @@ interface StateLike {
   max_need: number[][];
 }
 
+export interface DetectResponse {
+  is_deadlocked: boolean;
+  deadlocked_processes: number[];
+  safe_sequence: number[];
+  safe_sequence_length: number;
+}
+
+type WorkerCommand =
+  | 'DETECT' | 'RAG' | 'RESOLVE' | 'SIMULATE' | 'BATCH_DETECT' | 'HEADROOM' | 'PLAN'
+  | 'STEP_START' | 'STEP' | 'STEP_END';
+
+/** One request to the worker; encoded as text or binary when it is sent. */
+interface WorkerRequest {
+  command: WorkerCommand;
+  states: StateLike[];   // exactly one, except for BATCH_DETECT and none for STEP / STEP_END
+  args: number[];
+  extra?: number[];      // ints after the state (PLAN priorities)
+}
+
+/** JSON text as produced by the worker, or decoded binary detect results. */
+type WorkerReply =
+  | { kind: 'json'; text: string }
+  | { kind: 'detect'; results: DetectResponse[] };
+
 function stateToStdin(state: StateLike): string {
   const { num_processes: np, num_resources: nr, available, allocation, max_need } = state;
   const lines: string[] = [];
@@ -47,16 +96,133 @@ function stateToStdin(state: StateLike): string {
   return lines.join('\n');
 }
 
-function runWorker(stdin: string): Promise<string> {
+function requestToStdin(req: WorkerRequest): string {
+  if (req.command === 'BATCH_DETECT') {
+    return `BATCH_DETECT\n${req.states.length}\n${req.states.map(stateToStdin).join('\n')}`;
+  }
+  if (req.states.length === 0) return `${req.command} ${req.args.join(' ')}`;
+  const text = `${req.command}\n${stateToStdin(req.states[0])}`;
+  const withArgs = req.args.length > 0 ? `${text}\n${req.args.join(' ')}` : text;
+  return req.extra ? `${withArgs}\n${req.extra.join(' ')}` : withArgs;
+}
+
+// Binary framing, mirroring src/wire_protocol.h
+const WIRE_REQUEST_MAGIC = 0x424c447f;   // bytes 7F 'D' 'L' 'B'
+const WIRE_RESPONSE_MAGIC = 0x524c447f;  // bytes 7F 'D' 'L' 'R'
+const WIRE_REQUEST_HEADER_WORDS = 9;
+const WIRE_RESPONSE_HEADER_SIZE = 16;
+const WIRE_COMMANDS: Record<WorkerCommand, number> = {
+  DETECT: 1, RAG: 2, RESOLVE: 3, SIMULATE: 4, BATCH_DETECT: 5, HEADROOM: 6, PLAN: 7,
+  STEP_START: 8, STEP: 9, STEP_END: 10,
+};
+const WIRE_REPLY_JSON = 0;
+const WIRE_REPLY_DETECT = 1;
+const WIRE_REPLY_BATCH = 2;
+const WIRE_REPLY_ERROR = 3;
+const WIRE_REPLY_STATS = 4;
+
+/**
+ * Copy values into the frame; throws on any that int32 cannot hold, which
+ * Int32Array.set would wrap into a different matrix.
+ */
+function putWords(words: Int32Array, values: readonly number[], o: number): void {
+  for (let k = 0; k < values.length; k++) {
+    const v = values[k];
+    if ((v | 0) !== v) throw new RangeError(`value ${v} does not fit the binary framing's int32`);
+    words[o + k] = v;
+  }
+}
+
+/** Header plus int32 matrices, written straight into one typed array. */
+function encodeBinaryRequest(id: number, req: WorkerRequest): Buffer {
+  const batch = req.command === 'BATCH_DETECT';
+  let cells = 0;
+  for (const s of req.states) {
+    cells += s.num_resources * (2 * s.num_processes + 1) + (batch ? 2 : 0);
+  }
+  cells += req.extra?.length ?? 0;
+  const words = new Int32Array(WIRE_REQUEST_HEADER_WORDS + cells);
+  words[1] = id;
+  words[2] = WIRE_COMMANDS[req.command];
+  words[3] = cells * 4;
+  if (batch) {
+    words[6] = req.states.length;
+  } else {
+    if (req.states.length > 0) {
+      words[4] = req.states[0].num_processes;
+      words[5] = req.states[0].num_resources;
+    }
+    req.args.forEach((v, k) => { words[6 + k] = v; });
+  }
+  let o = WIRE_REQUEST_HEADER_WORDS;
+  for (const s of req.states) {
+    const nr = s.num_resources;
+    if (batch) {
+      words[o++] = s.num_processes;
+      words[o++] = nr;
+    }
+    putWords(words, s.available, o);
+    o += nr;
+    for (const row of s.allocation) { putWords(words, row, o); o += nr; }
+    for (const row of s.max_need) { putWords(words, row, o); o += nr; }
+  }
+  if (req.extra) putWords(words, req.extra, o);
+  const buf = Buffer.from(words.buffer, words.byteOffset, words.byteLength);
+  buf.writeUInt32LE(WIRE_REQUEST_MAGIC, 0);
+  return buf;
+}
+
+/** Decode packed detect records (WIRE_REPLY_DETECT / WIRE_REPLY_BATCH payload). */
+function decodeDetectRecords(payload: Buffer): DetectResponse[] {
+  const results: DetectResponse[] = [];
+  let o = 0;
+  while (o < payload.length) {
+    const status = payload.readInt32LE(o);
+    const numDeadlocked = payload.readInt32LE(o + 4);
+    const sequenceLength = payload.readInt32LE(o + 8);
+    o += 12;
+    if (status < 0) throw new Error('api_worker could not read a batch entry');
+    const deadlocked: number[] = new Array(numDeadlocked);
+    for (let k = 0; k < numDeadlocked; k++, o += 4) deadlocked[k] = payload.readInt32LE(o);
+    const sequence: number[] = new Array(sequenceLength);
+    for (let k = 0; k < sequenceLength; k++, o += 4) sequence[k] = payload.readInt32LE(o);
+    results.push({
+      is_deadlocked: status === 1,
+      deadlocked_processes: deadlocked,
+      safe_sequence: sequence,
+      safe_sequence_length: sequenceLength,
+    });
+  }
+  return results;
+}
+
+/** Time from spawn() until the process has started, for /metrics. */
+function timeSpawn(proc: ChildProcessWithoutNullStreams): void {
+  const start = process.hrtime.bigint();
+  proc.once('spawn', () => observeWorkerSpawn(Number(process.hrtime.bigint() - start) / 1e9));
+}
+
+/** Record a stats object sent by the worker; malformed stats are ignored. */
+function recordStats(command: string, json: string): void {
+  try {
+    recordWorkerStats(command, JSON.parse(json) as WorkerStats);
+  } catch {
+    // Stats are best effort and never fail a request
+  }
+}
+
+/** One-shot mode: spawn a worker, write the request, read its single JSON line. */
+function runWorkerOnce(command: string, stdin: string): Promise<string> {
   return new Promise((resolve, reject) => {
     const bin = getWorkerPath();
     if (!fs.existsSync(bin)) {
       reject(new Error('api_worker binary not found. Run: make api_worker'));
       return;
     }
-    const proc = spawn(bin, [], {
+    const proc = spawn(bin, WORKER_ARGS, {
       stdio: ['pipe', 'pipe', 'pipe'],
     });
+    timeSpawn(proc);
     let out = '';
     let err = '';
     proc.stdout.setEncoding('utf8');
@@ -80,36 +246,251 @@ function runWorker(stdin: string): Promise<string> {
         reject(new Error('api_worker produced no output'));
         return;
       }
+      // With --stats the stats object is the last line on stderr
+      if (WORKER_STATS) recordStats(command, err.trim().split('\n').pop() || '');
       resolve(line);
     });
     proc.stdin.write(stdin, () => proc.stdin.end());
   });
 }
 
-export interface DetectResponse {
-  is_deadlocked: boolean;
-  deadlocked_processes: number[];
-  safe_sequence: number[];
-  safe_sequence_length: number;
+interface PendingRequest {
+  command: string;
+  resolve: (reply: WorkerReply) => void;
+  reject: (err: Error) => void;
+}
+
+/** A long-lived `api_worker --serve` process with its in-flight requests. */
+class ServeWorker {
+  private readonly proc: ChildProcessWithoutNullStreams;
+  private readonly pending = new Map<number, PendingRequest>();
+  private buffer = '';
+  private chunks: Buffer[] = [];
+  private buffered = 0;
+  private stderr = '';
+  private readonly binary: boolean;
+  private timer: NodeJS.Timeout | undefined;
+  alive = true;
+
+  constructor(bin: string, binary: boolean) {
+    this.binary = binary;
+    this.proc = spawn(bin, ['--serve', ...WORKER_ARGS], { stdio: ['pipe', 'pipe', 'pipe'] });
+    timeSpawn(this.proc);
+    if (binary) {
+      this.proc.stdout.on('data', (chunk: Buffer) => this.onBinaryData(chunk));
+    } else {
+      this.proc.stdout.setEncoding('utf8');
+      this.proc.stdout.on('data', (chunk: string) => this.onData(chunk));
+    }
+    this.proc.stderr.setEncoding('utf8');
+    this.proc.stderr.on('data', (chunk: string) => { this.stderr += chunk; });
+    this.proc.on('error', (e) => this.fail(e));
+    this.proc.on('close', (code) => {
+      this.fail(new Error(this.stderr || `api_worker exited with code ${code}`));
+    });
+    this.proc.stdin.on('error', (e) => this.fail(e));
+  }
+
+  get inFlight(): number {
+    return this.pending.size;
+  }
+
+  send(id: number, req: WorkerRequest): Promise<WorkerReply> {
+    return new Promise((resolve, reject) => {
+      // Encode first: a request the framing cannot carry rejects alone
+      let frame: Buffer | string;
+      if (this.binary) {
+        frame = encodeBinaryRequest(id, req);
+      } else {
+        const payload = requestToStdin(req);
+        frame = `${id} ${Buffer.byteLength(payload)}\n${payload}`;
+      }
+      this.pending.set(id, { command: req.command, resolve, reject });
+      if (this.pending.size === 1) this.arm();
+      this.proc.stdin.write(frame);
+    });
+  }
+
+  private onData(chunk: string): void {
+    this.buffer += chunk;
+    let nl: number;
+    while ((nl = this.buffer.indexOf('\n')) >= 0) {
+      const line = this.buffer.slice(0, nl);
+      this.buffer = this.buffer.slice(nl + 1);
+      if (line) this.onLine(line);
+    }
+  }
+
+  private onLine(line: string): void {
+    // {"id":N[,"stats":{...}],"result":<json>} — hand back <json> unparsed; callers parse it once.
+    const m = /^\{"id":(\d+),(?:"stats":(\{[^{}]*\}),)?"(result|error)":/.exec(line);
+    if (!m || !line.endsWith('}')) {
+      this.fail(new Error('api_worker produced malformed output'));
+      return;
+    }
+    const id = Number(m[1]);
+    if (m[2]) this.onStats(id, m[2]);
+    const body = line.slice(m[0].length, -1);
+    if (m[3] === 'error') this.settle(id, new Error(JSON.parse(body) as string));
+    else this.settle(id, { kind: 'json', text: body });
+  }
+
+  private onBinaryData(chunk: Buffer): void {
+    // Keep chunks as they arrive and join them once per complete frame
+    this.chunks.push(chunk);
+    this.buffered += chunk.length;
+    while (this.buffered >= WIRE_RESPONSE_HEADER_SIZE) {
+      let head = this.chunks[0];
+      if (head.length < WIRE_RESPONSE_HEADER_SIZE) {
+        head = Buffer.concat(this.chunks, this.buffered);
+        this.chunks = [head];
+      }
+      if (head.readUInt32LE(0) !== WIRE_RESPONSE_MAGIC) {
+        this.fail(new Error('api_worker produced malformed output'));
+        return;
+      }
+      const total = WIRE_RESPONSE_HEADER_SIZE + head.readUInt32LE(12);
+      if (this.buffered < total) return;
+      const all = this.chunks.length === 1 ? head : Buffer.concat(this.chunks, this.buffered);
+      const rest = all.subarray(total);
+      this.chunks = rest.length > 0 ? [rest] : [];
+      this.buffered = rest.length;
+      this.onFrame(all.readUInt32LE(4), all.readUInt32LE(8), all.subarray(WIRE_RESPONSE_HEADER_SIZE, total));
+    }
+  }
+
+  private onFrame(id: number, kind: number, payload: Buffer): void {
+    if (kind === WIRE_REPLY_ERROR) {
+      this.settle(id, new Error(payload.toString('utf8')));
+    } else if (kind === WIRE_REPLY_DETECT || kind === WIRE_REPLY_BATCH) {
+      let results: DetectResponse[];
+      try {
+        results = decodeDetectRecords(payload);
+      } catch (e) {
+        this.settle(id, e as Error);
+        return;
+      }
+      this.settle(id, { kind: 'detect', results });
+    } else if (kind === WIRE_REPLY_JSON) {
+      this.settle(id, { kind: 'json', text: payload.toString('utf8') });
+    } else if (kind === WIRE_REPLY_STATS) {
+      this.onStats(id, payload.toString('utf8'));
+    } else {
+      this.fail(new Error('api_worker produced malformed output'));
+    }
+  }
+
+  private onStats(id: number, json: string): void {
+    const req = this.pending.get(id);
+    if (req) recordStats(req.command, json);
+  }
+
+  /**
+   * Time the request at the head of the queue. Frames are answered one at a
+   * time in order, so each request gets WORKER_TIMEOUT_MS from when the
+   * worker reaches it, not from when it was queued behind others.
+   */
+  private arm(): void {
+    clearTimeout(this.timer);
+    this.timer = this.pending.size === 0 ? undefined : setTimeout(() => {
+      // A stuck worker cannot be resynchronised; drop it and everything queued on it.
+      this.fail(new Error('api_worker timed out'));
+    }, WORKER_TIMEOUT_MS);
+  }
+
+  private settle(id: number, outcome: WorkerReply | Error): void {
+    const req = this.pending.get(id);
+    if (!req) return;
+    this.pending.delete(id);
+    this.arm();
+    if (outcome instanceof Error) req.reject(outcome);
+    else req.resolve(outcome);
+  }
+
+  private fail(err: Error): void {
+    if (this.alive) {
+      this.alive = false;
+      this.proc.kill('SIGKILL');
+    }
+    clearTimeout(this.timer);
+    this.timer = undefined;
+    for (const req of this.pending.values()) req.reject(err);
+    this.pending.clear();
+  }
+}
+
+const pool: (ServeWorker | undefined)[] = [];
+let nextRequestId = 1;
+
+/** Least-loaded live worker, (re)starting dead slots lazily. */
+function pickWorker(bin: string): ServeWorker {
+  let best: ServeWorker | undefined;
+  for (let i = 0; i < POOL_SIZE; i++) {
+    let w = pool[i];
+    if (!w || !w.alive) {
+      w = new ServeWorker(bin, BINARY_PROTOCOL);
+      pool[i] = w;
+    }
+    if (!best || w.inFlight < best.inFlight) best = w;
+    if (best.inFlight === 0) break;
+  }
+  return best as ServeWorker;
+}
+
+async function runWorker(req: WorkerRequest): Promise<WorkerReply> {
+  if (SPAWN_PER_REQUEST) {
+    return { kind: 'json', text: await runWorkerOnce(req.command, requestToStdin(req)) };
+  }
+  const bin = getWorkerPath();
+  if (!fs.existsSync(bin)) {
+    throw new Error('api_worker binary not found. Run: make api_worker');
+  }
+  return pickWorker(bin).send(takeRequestId(), req);
+}
+
+function takeRequestId(): number {
+  const id = nextRequestId++;
+  if (nextRequestId > 0x7fffffff) nextRequestId = 1;
+  return id;
+}
+
+/** JSON text of a reply, for commands that always answer in JSON. */
+function replyText(reply: WorkerReply): string {
+  if (reply.kind !== 'json') throw new Error('api_worker sent an unexpected reply');
+  return reply.text;
 }
 
 export async function runDetect(state: StateLike): Promise<DetectResponse> {
-  const stdin = `DETECT\n${stateToStdin(state)}`;
-  const line = await runWorker(stdin);
-  const obj = JSON.parse(line) as DetectResponse & { error?: string };
+  const reply = await runWorker({ command: 'DETECT', states: [state], args: [] });
+  if (reply.kind === 'detect') return reply.results[0];
+  const obj = JSON.parse(reply.text) as DetectResponse & { error?: string };
   if ('error' in obj && obj.error) throw new Error(obj.error);
   return obj;
 }
 
+/**
+ * Detects many states in one worker request (BATCH_DETECT); the worker spreads
+ * them over its thread pool. Resolves to the JSON array of detect results, in
+ * input order; text replies are passed through without being parsed.
+ */
+export async function runBatchDetect(states: StateLike[]): Promise<string> {
+  const reply = await runWorker({ command: 'BATCH_DETECT', states, args: [] });
+  if (reply.kind === 'detect') return JSON.stringify(reply.results);
+  if (!reply.text.startsWith('[') || reply.text.includes('{"error":')) {
+    throw new Error('api_worker rejected batch');
+  }
+  return reply.text;
+}
+
 export interface RagResponse {
   nodes: { id: number; label: string; type: string }[];
   edges: { from: number; to: number; type: string }[];
+  cycles: { processes: number[]; resources: number[] }[];
 }
 
 export async function runRag(state: StateLike): Promise<RagResponse> {
-  const stdin = `RAG\n${stateToStdin(state)}`;
-  const line = await runWorker(stdin);
-  return JSON.parse(line) as RagResponse;
+  const reply = await runWorker({ command: 'RAG', states: [state], args: [] });
+  return JSON.parse(replyText(reply)) as RagResponse;
 }
 
 export interface ResolveResponse {
@@ -122,9 +503,8 @@ export async function runResolve(
   state: StateLike & { victim_process_index?: number }
 ): Promise<ResolveResponse> {
   const victim = state.victim_process_index ?? -1;
-  const stdin = `RESOLVE\n${stateToStdin(state)}\n${victim}`;
-  const line = await runWorker(stdin);
-  const obj = JSON.parse(line) as ResolveResponse | { error: string };
+  const reply = await runWorker({ command: 'RESOLVE', states: [state], args: [victim] });
+  const obj = JSON.parse(replyText(reply)) as ResolveResponse | { error: string };
   if ('error' in obj && obj.error) throw new Error(obj.error);
   return obj as ResolveResponse;
 }
@@ -139,7 +519,87 @@ export async function runSimulate(
   state: StateLike & { process_index: number; resource_index: number; amount: number }
 ): Promise<SimulateResponse> {
   const { process_index: pi, resource_index: rj, amount } = state;
-  const stdin = `SIMULATE\n${stateToStdin(state)}\n${pi} ${rj} ${amount}`;
-  const line = await runWorker(stdin);
-  return JSON.parse(line) as SimulateResponse;
+  const reply = await runWorker({ command: 'SIMULATE', states: [state], args: [pi, rj, amount] });
+  return JSON.parse(replyText(reply)) as SimulateResponse;
+}
+
+export interface HeadroomResponse {
+  is_safe: boolean;
+  headroom: number[][];
+}
+
+export async function runHeadroom(state: StateLike): Promise<HeadroomResponse> {
+  const reply = await runWorker({ command: 'HEADROOM', states: [state], args: [] });
+  return JSON.parse(replyText(reply)) as HeadroomResponse;
+}
+
+export interface PlanResponse {
+  plan: { process: number; cost: number; unblocked: number }[];
+  total_cost: number;
+  state: StateLike;
+  result: DetectResponse;
+}
+
+/**
+ * costModel is the CostModel code from src/planner.h (0 units held,
+ * 1 priority, 2 work lost); priorities are sent only for code 1.
+ */
+export async function runPlan(
+  state: StateLike,
+  costModel: number,
+  maxCandidates: number,
+  priorities?: number[],
+): Promise<PlanResponse> {
+  const reply = await runWorker({
+    command: 'PLAN',
+    states: [state],
+    args: [costModel, maxCandidates],
+    extra: costModel === 1 ? priorities : undefined,
+  });
+  const obj = JSON.parse(replyText(reply)) as PlanResponse | { error: string };
+  if ('error' in obj && obj.error) throw new Error(obj.error);
+  return obj as PlanResponse;
+}
+
+/** One step of a step session (see api_step() in src/api_commands.h). */
+export interface StepSessionResponse {
+  status: 'found' | 'done' | 'deadlock';
+  selected_process: number | null;
+  explanation: string;
+  work: number[];
+  steps: number;
+  deadlocked_processes?: number[];
+}
+
+/** A step session held by the pooled worker that started it. */
+export interface WorkerStepSession {
+  worker: ServeWorker;
+  id: number;
+}
+
+/** STEP_START on a pooled worker; sessions need --serve, so not in spawn mode. */
+export async function startStepSession(state: StateLike): Promise<WorkerStepSession> {
+  const bin = getWorkerPath();
+  if (SPAWN_PER_REQUEST || !fs.existsSync(bin)) {
+    throw new Error('step sessions need pooled api_worker processes');
+  }
+  const worker = pickWorker(bin);
+  const reply = await worker.send(takeRequestId(), { command: 'STEP_START', states: [state], args: [] });
+  const obj = JSON.parse(replyText(reply)) as { session: number } | { error: string };
+  if ('error' in obj) throw new Error(obj.error);
+  return { worker, id: obj.session };
+}
+
+/** Next step; the worker ends the session after a done or deadlock step. */
+export async function runStep(session: WorkerStepSession): Promise<StepSessionResponse> {
+  if (!session.worker.alive) throw new Error('step session ended');
+  const reply = await session.worker.send(takeRequestId(), { command: 'STEP', states: [], args: [session.id] });
+  const obj = JSON.parse(replyText(reply)) as StepSessionResponse | { error: string };
+  if ('error' in obj) throw new Error(obj.error);
+  return obj;
+}
+
+export async function endStepSession(session: WorkerStepSession): Promise<void> {
+  if (!session.worker.alive) return;
+  await session.worker.send(takeRequestId(), { command: 'STEP_END', states: [], args: [session.id] });
 }
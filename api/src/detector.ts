@@ -18,8 +18,17 @@ export interface DetectResponse {
   safe_sequence_length: number;
 }
 
-const MAX_PROCESSES = 10;
-const MAX_RESOURCES = 10;
+export interface BatchDetectRequest {
+  states: DetectRequest[];
+}
+
+/** Upper bounds accepted by the API; mirror MAX_PROCESSES / MAX_RESOURCES in src/deadlock_detector.h. */
+const MAX_PROCESSES = 100000;
+const MAX_RESOURCES = 1024;
+/** Mirrors MAX_BATCH_STATES in src/api_worker.c. */
+const MAX_BATCH_STATES = 1000000;
+/** Largest matrix entry: the C core, the addon and the binary frames hold int32. */
+const MAX_UNITS = 2147483647;
 
 function canSatisfy(need: number[], work: number[], numResources: number): boolean {
   for (let j = 0; j < numResources; j++) {
@@ -181,6 +190,215 @@ export function validateResolveRequest(body: unknown): string | null {
   return null;
 }
 
+/* ------------------------------------------------------------------ */
+/*  Resolution planning (terminate as many processes as needed)        */
+/* ------------------------------------------------------------------ */
+
+/** Victim costs; lower is terminated first. Mirrors CostModel in src/planner.h. */
+export const COST_MODELS = ['units_held', 'priority', 'work_lost'] as const;
+export type CostModel = (typeof COST_MODELS)[number];
+
+export interface PlanRequest extends DetectRequest {
+  /** Default units_held (the /api/resolve rule). */
+  cost_model?: CostModel;
+  /** One per process; required for cost_model "priority". */
+  priorities?: number[];
+  /** Cheapest deadlocked processes tried per step (default 8). */
+  max_candidates?: number;
+}
+
+export interface PlanStep {
+  process: number;
+  cost: number;
+  /** Processes that could finish because of this termination. */
+  unblocked: number;
+}
+
+export interface PlanResponse {
+  plan: PlanStep[];
+  total_cost: number;
+  /** State with every victim terminated. */
+  state: DetectRequest;
+  /** Detection on that state; the safe sequence lists each victim where it was terminated. */
+  result: DetectResponse;
+}
+
+export const DEFAULT_MAX_CANDIDATES = 8;
+
+function victimCost(req: PlanRequest, i: number): number {
+  const { num_resources, allocation, max_need } = req;
+  if (req.cost_model === 'priority') return req.priorities?.[i] ?? 0;
+  let held = 0;
+  let max = 0;
+  for (let j = 0; j < num_resources; j++) {
+    held += allocation[i][j];
+    max += max_need[i][j];
+  }
+  if (req.cost_model === 'work_lost') return max > 0 ? Math.floor((held * 1000) / max) : 0;
+  return held;
+}
+
+/**
+ * Plans every termination needed to end the deadlock in one call. The greedy
+ * steps share one detection; each termination releases the victim's allocation and the scan continues
+ * from there instead of restarting. At each step the max_candidates cheapest
+ * deadlocked processes are tried and the one with the least cost per process it
+ * lets finish is taken (ties: cheaper, then lower index), preferring victims that
+ * let another process finish. With max_candidates > 1, victims that later ones
+ * made unnecessary are then dropped, last first. Same plan as the C planner
+ * (src/planner.c).
+ */
+export function planResolution(req: PlanRequest): PlanResponse {
+  const { num_processes: np, num_resources: nr, available, allocation, max_need } = req;
+  const maxCandidates = Math.max(1, req.max_candidates ?? DEFAULT_MAX_CANDIDATES);
+  const need = allocation.map((row, i) => row.map((a, j) => max_need[i][j] - a));
+
+  // Pass-by-pass scan from process 0 until nothing more can finish
+  const run = (work: number[], finish: boolean[], sequence: number[] | null): number => {
+    let count = 0;
+    let found: boolean;
+    do {
+      found = false;
+      for (let i = 0; i < np; i++) {
+        if (!finish[i] && canSatisfy(need[i], work, nr)) {
+          for (let j = 0; j < nr; j++) work[j] += allocation[i][j];
+          finish[i] = true;
+          sequence?.push(i);
+          count++;
+          found = true;
+        }
+      }
+    } while (found);
+    return count;
+  };
+  const terminate = (work: number[], finish: boolean[], p: number): void => {
+    for (let j = 0; j < nr; j++) work[j] += allocation[p][j];
+    finish[p] = true;
+  };
+
+  const work = [...available];
+  const finish: boolean[] = new Array(np).fill(false);
+  run(work, finish, null);
+
+  const candidates: { cost: number; process: number }[] = [];
+  for (let i = 0; i < np; i++) {
+    if (!finish[i]) candidates.push({ cost: victimCost(req, i), process: i });
+  }
+  candidates.sort((a, b) => a.cost - b.cost || a.process - b.process);
+
+  const greedy: { cost: number; process: number }[] = [];
+  while (finish.some((f) => !f)) {
+    const tried = candidates.filter((c) => !finish[c.process]).slice(0, maxCandidates);
+    let best = tried[0];
+    if (tried.length > 1) {
+      // A victim that lets no other process finish wins only if none does
+      let bestScore = 0;
+      let bestIdle = true;
+      tried.forEach((cand, t) => {
+        const trialWork = [...work];
+        const trialFinish = [...finish];
+        terminate(trialWork, trialFinish, cand.process);
+        const others = run(trialWork, trialFinish, null);
+        const idle = others === 0;
+        const score = cand.cost / (1 + others);
+        if (t === 0 || (bestIdle && !idle) || (idle === bestIdle && score < bestScore)) {
+          best = cand;
+          bestScore = score;
+          bestIdle = idle;
+        }
+      });
+    }
+    terminate(work, finish, best.process);
+    run(work, finish, null);
+    greedy.push(best);
+  }
+
+  // Detect again with some victims terminated in plan order; with a plan,
+  // record each termination and the processes it let finish
+  const replay = (victims: { cost: number; process: number }[], plan: PlanStep[] | null,
+    sequence: number[]): boolean => {
+    const work = [...available];
+    const finish: boolean[] = new Array(np).fill(false);
+    run(work, finish, sequence);
+    for (const v of victims) {
+      if (finish[v.process]) continue;
+      terminate(work, finish, v.process);
+      sequence.push(v.process);
+      const unblocked = run(work, finish, sequence);
+      plan?.push({ process: v.process, cost: v.cost, unblocked });
+    }
+    return sequence.length === np;
+  };
+
+  // Later victims can make earlier ones unnecessary: from the last, drop each
+  // victim without which the others still end the deadlock (width 1 keeps
+  // them all, as repeated resolve does)
+  let kept = greedy;
+  for (let s = greedy.length - 1; s >= 0 && kept.length > 1 && maxCandidates > 1; s--) {
+    const without = kept.filter((v) => v !== greedy[s]);
+    if (replay(without, null, [])) kept = without;
+  }
+  const plan: PlanStep[] = [];
+  const sequence: number[] = [];
+  replay(kept, plan, sequence);
+  const totalCost = plan.reduce((sum, step) => sum + step.cost, 0);
+
+  const victims = new Set(plan.map((step) => step.process));
+  const finalAvailable = [...available];
+  for (const v of victims) {
+    for (let j = 0; j < nr; j++) finalAvailable[j] += allocation[v][j];
+  }
+  return {
+    plan,
+    total_cost: totalCost,
+    state: {
+      num_processes: np,
+      num_resources: nr,
+      available: finalAvailable,
+      allocation: allocation.map((row, i) => (victims.has(i) ? row.map(() => 0) : [...row])),
+      max_need: max_need.map((row, i) => (victims.has(i) ? row.map(() => 0) : [...row])),
+    },
+    result: {
+      is_deadlocked: false,
+      deadlocked_processes: [],
+      safe_sequence: sequence,
+      safe_sequence_length: sequence.length,
+    },
+  };
+}
+
+/**
+ * Validates request body for POST /api/resolve/plan.
+ */
+export function validatePlanRequest(body: unknown): string | null {
+  const baseError = validateDetectRequest(body);
+  if (baseError) return baseError;
+
+  const b = body as Record<string, unknown>;
+  const np = b.num_processes as number;
+  if (b.cost_model !== undefined && !COST_MODELS.includes(b.cost_model as CostModel)) {
+    return `cost_model must be one of ${COST_MODELS.join(', ')}`;
+  }
+  if (b.cost_model === 'priority' || b.priorities !== undefined) {
+    if (!Array.isArray(b.priorities) || b.priorities.length !== np) {
+      return `priorities must be an array of ${np} integers`;
+    }
+    for (let i = 0; i < np; i++) {
+      const v = b.priorities[i];
+      if (typeof v !== 'number' || !Number.isInteger(v) || Math.abs(v) > 2147483647) {
+        return `priorities[${i}] must be a 32-bit integer`;
+      }
+    }
+  }
+  if (b.max_candidates !== undefined) {
+    const v = b.max_candidates;
+    if (typeof v !== 'number' || !Number.isInteger(v) || v < 1 || v > MAX_PROCESSES) {
+      return `max_candidates must be an integer between 1 and ${MAX_PROCESSES}`;
+    }
+  }
+  return null;
+}
+
 /* ------------------------------------------------------------------ */
 /*  Step-by-step Banker's Algorithm                                    */
 /* ------------------------------------------------------------------ */
@@ -202,6 +420,12 @@ export interface StepRequest {
     finish: boolean[];
     safe_sequence: number[];
   } | null;
+
+  /**
+   * Start a server-side step session instead (see stepSessions.ts); the
+   * response carries a session_id to send in place of the state from then on.
+   */
+  session?: boolean;
 }
 
 export interface StepResponse {
@@ -322,8 +546,15 @@ export function validateStepRequest(body: unknown): string | null {
   const np = b.num_processes as number;
   const nr = b.num_resources as number;
 
+  if (b.session !== undefined && typeof b.session !== 'boolean') {
+    return 'session must be a boolean';
+  }
+
   // step_state is optional — if absent or null, that's fine (start from scratch)
   if (b.step_state === undefined || b.step_state === null) return null;
+  if (b.session === true) {
+    return 'a step session starts from the beginning; omit step_state';
+  }
 
   if (typeof b.step_state !== 'object') {
     return 'step_state must be an object or null';
@@ -439,6 +670,56 @@ export function simulateRequest(req: SimulateRequest): SimulateResponse {
   };
 }
 
+/* ------------------------------------------------------------------ */
+/*  Safe-grant headroom                                                */
+/* ------------------------------------------------------------------ */
+
+export interface HeadroomResponse {
+  is_safe: boolean;
+  headroom: number[][];
+}
+
+/**
+ * For every process and resource, the largest amount that simulateRequest would
+ * grant. Granting more never makes a state safer, so each cell is a binary search.
+ * All zero when the state is already unsafe. (The C core shares work across cells;
+ * this is the straightforward fallback.)
+ */
+export function computeHeadroom(req: DetectRequest): HeadroomResponse {
+  const { num_processes, num_resources, available, allocation, max_need } = req;
+  const headroom = allocation.map((row) => row.map(() => 0));
+  if (detectDeadlock(req).is_deadlocked) {
+    return { is_safe: false, headroom };
+  }
+
+  const staysSafe = (pi: number, rj: number, amount: number): boolean => {
+    const state: DetectRequest = {
+      num_processes,
+      num_resources,
+      available: available.map((a, j) => (j === rj ? a - amount : a)),
+      allocation: allocation.map((row, i) =>
+        i === pi ? row.map((v, j) => (j === rj ? v + amount : v)) : row
+      ),
+      max_need,
+    };
+    return !detectDeadlock(state).is_deadlocked;
+  };
+
+  for (let i = 0; i < num_processes; i++) {
+    for (let j = 0; j < num_resources; j++) {
+      let lo = 0;
+      let hi = Math.max(0, Math.min(max_need[i][j] - allocation[i][j], available[j]));
+      while (lo < hi) {
+        const mid = lo + Math.ceil((hi - lo) / 2);
+        if (staysSafe(i, j, mid)) lo = mid;
+        else hi = mid - 1;
+      }
+      headroom[i][j] = lo;
+    }
+  }
+  return { is_safe: true, headroom };
+}
+
 /**
  * Validates request body for POST /api/simulate-request.
  */
@@ -482,8 +763,8 @@ export function validateSimulateRequest(body: unknown): string | null {
  */
 /**
  * Validates request body for POST /api/detect (and other state-accepting endpoints).
- * Rules: types correct, array lengths match dimensions, all values non-negative integers,
- * allocation[i][j] <= max_need[i][j]. Returns an error message or null if valid.
+ * Rules: types correct, array lengths match dimensions, all values integers in
+ * 0..MAX_UNITS (int32, as the C backends hold them), allocation[i][j] <= max_need[i][j]. Returns an error message or null if valid.
  */
 export function validateDetectRequest(body: unknown): string | null {
   if (body === null || typeof body !== 'object') return 'Request body must be a JSON object';
@@ -504,8 +785,8 @@ export function validateDetectRequest(body: unknown): string | null {
   }
   for (let j = 0; j < nr; j++) {
     const v = b.available[j];
-    if (typeof v !== 'number' || !Number.isInteger(v) || v < 0) {
-      return `available[${j}] must be a non-negative integer`;
+    if (typeof v !== 'number' || !Number.isInteger(v) || v < 0 || v > MAX_UNITS) {
+      return `available[${j}] must be an integer between 0 and ${MAX_UNITS}`;
     }
   }
 
@@ -518,8 +799,8 @@ export function validateDetectRequest(body: unknown): string | null {
     }
     for (let j = 0; j < nr; j++) {
       const v = b.allocation[i][j];
-      if (typeof v !== 'number' || !Number.isInteger(v) || v < 0) {
-        return `allocation[${i}][${j}] must be a non-negative integer`;
+      if (typeof v !== 'number' || !Number.isInteger(v) || v < 0 || v > MAX_UNITS) {
+        return `allocation[${i}][${j}] must be an integer between 0 and ${MAX_UNITS}`;
       }
     }
   }
@@ -533,8 +814,8 @@ export function validateDetectRequest(body: unknown): string | null {
     }
     for (let j = 0; j < nr; j++) {
       const v = b.max_need[i][j];
-      if (typeof v !== 'number' || !Number.isInteger(v) || v < 0) {
-        return `max_need[${i}][${j}] must be a non-negative integer`;
+      if (typeof v !== 'number' || !Number.isInteger(v) || v < 0 || v > MAX_UNITS) {
+        return `max_need[${i}][${j}] must be an integer between 0 and ${MAX_UNITS}`;
       }
       if ((b.allocation as number[][])[i][j] > v) {
         return `allocation[${i}][${j}] cannot exceed max_need[${i}][${j}]`;
@@ -544,3 +825,21 @@ export function validateDetectRequest(body: unknown): string | null {
 
   return null;
 }
+
+/**
+ * Validates request body for POST /api/detect/batch: { states: DetectRequest[] }.
+ * Each state follows the validateDetectRequest rules; errors name the offending index.
+ */
+export function validateBatchDetectRequest(body: unknown): string | null {
+  if (body === null || typeof body !== 'object') return 'Request body must be a JSON object';
+
+  const states = (body as Record<string, unknown>).states;
+  if (!Array.isArray(states) || states.length < 1 || states.length > MAX_BATCH_STATES) {
+    return `states must be an array of 1 to ${MAX_BATCH_STATES} system states`;
+  }
+  for (let k = 0; k < states.length; k++) {
+    const err = validateDetectRequest(states[k]);
+    if (err) return `states[${k}]: ${err}`;
+  }
+  return null;
+}
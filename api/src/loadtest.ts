@@ -0,0 +1,468 @@
+/**
+ * HTTP load generator for the detection endpoints (npm run loadtest).
+ * For each backend it starts the server with the backends above it switched
+ * off (DEADLOCK_NATIVE=0, C_WORKER=0) and the result cache disabled, then
+ * keeps --concurrency requests in flight against /api/detect, /api/rag,
+ * /api/resolve and /api/simulate-request for --duration seconds per endpoint
+ * and state size. States are built like the frontend's sample scenarios (a
+ * Banker's safe state and a circular wait), scaled to each size. The server's
+ * X-Backend header names the backend that answered; an answer from any other
+ * one counts as a fallback. With --url the running server is measured as is.
+ * The report (throughput, latency percentiles, error and fallback rates) is
+ * written as JSON to --out or stdout; progress goes to stderr.
+ *
+ *   npm run loadtest -- [--backends native,worker,ts] [--endpoints detect,rag,resolve,simulate]
+ *                       [--sizes 5x3,100x16,1000x32] [--concurrency 8] [--duration 5]
+ *                       [--warmup 1] [--seed 1] [--cache] [--url http://host:port] [--out FILE]
+ */
+
+import { spawn, type ChildProcess } from 'child_process';
+import * as fs from 'fs';
+import * as http from 'http';
+import * as net from 'net';
+import * as path from 'path';
+
+type Target = 'native' | 'worker' | 'ts';
+type Endpoint = 'detect' | 'rag' | 'resolve' | 'simulate';
+
+const TARGETS: Target[] = ['native', 'worker', 'ts'];
+const ENDPOINTS: Endpoint[] = ['detect', 'rag', 'resolve', 'simulate'];
+const ROUTES: Record<Endpoint, string> = {
+  detect: '/api/detect',
+  rag: '/api/rag',
+  resolve: '/api/resolve',
+  simulate: '/api/simulate-request',
+};
+/** Environment that leaves the target as the first backend the server tries. */
+const TARGET_ENV: Record<Target, Record<string, string>> = {
+  native: {},
+  worker: { DEADLOCK_NATIVE: '0' },
+  ts: { DEADLOCK_NATIVE: '0', C_WORKER: '0' },
+};
+/** Distinct states per endpoint and size, sent round robin. */
+const POOL_SIZE = 8;
+const STARTUP_TIMEOUT_MS = 30000;
+
+interface Options {
+  targets: Target[];
+  endpoints: Endpoint[];
+  sizes: [number, number][];
+  concurrency: number;
+  duration: number;
+  warmup: number;
+  seed: number;
+  cache: boolean;
+  url: string | null;
+  out: string | null;
+}
+
+interface State {
+  num_processes: number;
+  num_resources: number;
+  available: number[];
+  allocation: number[][];
+  max_need: number[][];
+}
+
+/** One endpoint and size against one backend. */
+interface PhaseResult {
+  backend: string;
+  endpoint: Endpoint;
+  size: string;
+  requests: number;
+  ok: number;
+  duration_s: number;
+  throughput_rps: number;
+  latency_ms: { mean: number; p50: number; p99: number; p999: number; max: number };
+  errors: number;
+  error_rate: number;
+  /** Null when the expected backend is unknown (--url). */
+  fallbacks: number | null;
+  fallback_rate: number | null;
+  answered_by: Record<string, number>;
+  statuses: Record<string, number>;
+}
+
+const USAGE = 'usage: loadtest [--backends native,worker,ts] [--endpoints detect,rag,resolve,simulate] '
+  + '[--sizes NPxNR,...] [--concurrency N] [--duration S] [--warmup S] [--seed N] [--cache] '
+  + '[--url URL] [--out FILE]';
+
+function fail(message: string): never {
+  console.error(message);
+  process.exit(1);
+}
+
+function parseList<T extends string>(value: string, allowed: readonly T[], flag: string): T[] {
+  const items = value.split(',').filter((s) => s !== '');
+  for (const item of items) {
+    if (!allowed.includes(item as T)) fail(`${flag}: unknown value ${item} (one of ${allowed.join(', ')})`);
+  }
+  if (items.length === 0) fail(`${flag}: empty list`);
+  return items as T[];
+}
+
+function parseSizes(value: string): [number, number][] {
+  return value.split(',').map((item): [number, number] => {
+    const m = /^(\d+)x(\d+)$/.exec(item);
+    const np = m ? Number(m[1]) : 0;
+    const nr = m ? Number(m[2]) : 0;
+    if (np < 2 || nr < 1 || np > 100000 || nr > 1024) fail(`--sizes: invalid size ${item}`);
+    return [np, nr];
+  });
+}
+
+function positive(value: string, flag: string, allowZero = false): number {
+  const n = Number(value);
+  if (!Number.isFinite(n) || n < 0 || (!allowZero && n === 0)) fail(`${flag}: invalid number ${value}`);
+  return n;
+}
+
+function parseOptions(argv: string[]): Options {
+  const options: Options = {
+    targets: ['worker', 'ts'],
+    endpoints: [...ENDPOINTS],
+    sizes: [[5, 3], [100, 16], [1000, 32]],
+    concurrency: 8,
+    duration: 5,
+    warmup: 1,
+    seed: 1,
+    cache: false,
+    url: null,
+    out: null,
+  };
+  for (let a = 0; a < argv.length; a++) {
+    const flag = argv[a];
+    if (flag === '--cache') {
+      options.cache = true;
+      continue;
+    }
+    const value = argv[++a];
+    if (value === undefined) fail(USAGE);
+    switch (flag) {
+      case '--backends': options.targets = parseList(value, TARGETS, flag); break;
+      case '--endpoints': options.endpoints = parseList(value, ENDPOINTS, flag); break;
+      case '--sizes': options.sizes = parseSizes(value); break;
+      case '--concurrency': options.concurrency = Math.floor(positive(value, flag)); break;
+      case '--duration': options.duration = positive(value, flag); break;
+      case '--warmup': options.warmup = positive(value, flag, true); break;
+      case '--seed': options.seed = Math.floor(positive(value, flag, true)); break;
+      case '--url': options.url = value.replace(/\/+$/, ''); break;
+      case '--out': options.out = value; break;
+      default: fail(USAGE);
+    }
+  }
+  return options;
+}
+
+/** Small seeded PRNG (mulberry32), so a seed always gives the same states. */
+function makeRng(seed: number): (limit: number) => number {
+  let s = seed >>> 0;
+  return (limit) => {
+    s = (s + 0x6d2b79f5) >>> 0;
+    let t = s;
+    t = Math.imul(t ^ (t >>> 15), t | 1);
+    t ^= t + Math.imul(t ^ (t >>> 7), t | 61);
+    return Math.floor((((t ^ (t >>> 14)) >>> 0) / 4294967296) * limit);
+  };
+}
+
+/**
+ * The sample safe scenario scaled up: random claims and holdings, and just
+ * enough available (plus one unit of slack per resource) for a random order
+ * of the processes to finish.
+ */
+function safeState(np: number, nr: number, rand: (limit: number) => number): State {
+  const max_need: number[][] = [];
+  const allocation: number[][] = [];
+  for (let i = 0; i < np; i++) {
+    const max = Array.from({ length: nr }, () => rand(10));
+    max_need.push(max);
+    allocation.push(max.map((m) => rand(m + 1)));
+  }
+  const order = Array.from({ length: np }, (_, i) => i);
+  for (let i = np - 1; i > 0; i--) {
+    const j = rand(i + 1);
+    [order[i], order[j]] = [order[j], order[i]];
+  }
+  const available = new Array<number>(nr).fill(1);
+  const work = available.slice();
+  for (const p of order) {
+    for (let j = 0; j < nr; j++) {
+      const short = max_need[p][j] - allocation[p][j] - work[j];
+      if (short > 0) {
+        available[j] += short;
+        work[j] += short;
+      }
+      work[j] += allocation[p][j];
+    }
+  }
+  return { num_processes: np, num_resources: nr, available, allocation, max_need };
+}
+
+/**
+ * The sample circular wait scaled up: nothing available, and process i holds
+ * a unit of resource i mod nr while it needs one more of resource i + 1.
+ */
+function deadlockState(np: number, nr: number, rand: (limit: number) => number): State {
+  const allocation: number[][] = [];
+  const max_need: number[][] = [];
+  for (let i = 0; i < np; i++) {
+    const held = new Array<number>(nr).fill(0);
+    held[i % nr] = 1 + rand(2);
+    const max = held.slice();
+    max[(i + 1) % nr] += 1;
+    allocation.push(held);
+    max_need.push(max);
+  }
+  return { num_processes: np, num_resources: nr, available: new Array<number>(nr).fill(0), allocation, max_need };
+}
+
+/**
+ * A one-unit request that passes validateSimulateRequest (every resource has
+ * a unit available; the claim is raised if the process is already at it).
+ */
+function simulateBody(state: State, rand: (limit: number) => number): object {
+  const p = rand(state.num_processes);
+  const r = rand(state.num_resources);
+  if (state.allocation[p][r] === state.max_need[p][r]) state.max_need[p][r]++;
+  return { ...state, process_index: p, resource_index: r, amount: 1 };
+}
+
+/** Request bodies for one endpoint and size, serialized once up front. */
+function buildBodies(endpoint: Endpoint, np: number, nr: number, seed: number): Buffer[] {
+  const rand = makeRng(seed * 1000003 + np * 1031 + nr);
+  const bodies: Buffer[] = [];
+  for (let k = 0; k < POOL_SIZE; k++) {
+    let body: object;
+    if (endpoint === 'resolve') {
+      body = deadlockState(np, nr, rand);
+    } else if (endpoint === 'simulate') {
+      body = simulateBody(safeState(np, nr, rand), rand);
+    } else {
+      body = k % 2 === 0 ? safeState(np, nr, rand) : deadlockState(np, nr, rand);
+    }
+    bodies.push(Buffer.from(JSON.stringify(body)));
+  }
+  return bodies;
+}
+
+interface Reply {
+  status: number;
+  backend: string;
+}
+
+function post(agent: http.Agent, base: URL, route: string, body: Buffer): Promise<Reply> {
+  return new Promise((resolve, reject) => {
+    const req = http.request({
+      host: base.hostname,
+      port: base.port,
+      path: route,
+      method: 'POST',
+      agent,
+      headers: { 'Content-Type': 'application/json', 'Content-Length': body.length },
+    }, (res) => {
+      res.on('data', () => {});
+      res.on('error', reject);
+      res.on('end', () => {
+        const backend = res.headers['x-backend'];
+        resolve({ status: res.statusCode ?? 0, backend: typeof backend === 'string' ? backend : 'unknown' });
+      });
+    });
+    req.on('error', reject);
+    req.end(body);
+  });
+}
+
+/** Nearest-rank percentile of ascending values. */
+function percentile(sorted: number[], q: number): number {
+  if (sorted.length === 0) return 0;
+  return sorted[Math.min(sorted.length - 1, Math.max(0, Math.ceil(q * sorted.length) - 1))];
+}
+
+function round3(x: number): number {
+  return Math.round(x * 1000) / 1000;
+}
+
+/**
+ * Closed loop: each of concurrency clients sends its next request as soon as
+ * the last one is answered, until the time is up.
+ */
+async function runPhase(
+  base: URL,
+  route: string,
+  bodies: Buffer[],
+  concurrency: number,
+  seconds: number,
+  expected: Target | null,
+): Promise<Omit<PhaseResult, 'backend' | 'endpoint' | 'size'>> {
+  const agent = new http.Agent({ keepAlive: true, maxSockets: concurrency });
+  const latencies: number[] = [];
+  const answered: Record<string, number> = {};
+  const statuses: Record<string, number> = {};
+  let requests = 0;
+  let ok = 0;
+  let errors = 0;
+  let fallbacks = 0;
+  const start = process.hrtime.bigint();
+  const deadline = start + BigInt(Math.round(seconds * 1e9));
+
+  const client = async (first: number): Promise<void> => {
+    for (let k = first; process.hrtime.bigint() < deadline; k++) {
+      const sent = process.hrtime.bigint();
+      requests++;
+      try {
+        const reply = await post(agent, base, route, bodies[k % bodies.length]);
+        latencies.push(Number(process.hrtime.bigint() - sent) / 1e6);
+        statuses[reply.status] = (statuses[reply.status] ?? 0) + 1;
+        answered[reply.backend] = (answered[reply.backend] ?? 0) + 1;
+        if (reply.status >= 200 && reply.status < 300) ok++;
+        else errors++;
+        if (expected && reply.backend !== expected && reply.backend !== 'cache') fallbacks++;
+      } catch (_e) {
+        errors++;
+        statuses.network = (statuses.network ?? 0) + 1;
+      }
+    }
+  };
+  await Promise.all(Array.from({ length: concurrency }, (_, c) => client(c)));
+  const elapsed = Number(process.hrtime.bigint() - start) / 1e9;
+  agent.destroy();
+
+  latencies.sort((a, b) => a - b);
+  const mean = latencies.length ? latencies.reduce((s, x) => s + x, 0) / latencies.length : 0;
+  return {
+    requests,
+    ok,
+    duration_s: round3(elapsed),
+    throughput_rps: round3(ok / elapsed),
+    latency_ms: {
+      mean: round3(mean),
+      p50: round3(percentile(latencies, 0.5)),
+      p99: round3(percentile(latencies, 0.99)),
+      p999: round3(percentile(latencies, 0.999)),
+      max: round3(latencies.length ? latencies[latencies.length - 1] : 0),
+    },
+    errors,
+    error_rate: requests ? round3(errors / requests) : 0,
+    fallbacks: expected ? fallbacks : null,
+    fallback_rate: expected ? (requests ? round3(fallbacks / requests) : 0) : null,
+    answered_by: answered,
+    statuses,
+  };
+}
+
+function freePort(): Promise<number> {
+  return new Promise((resolve, reject) => {
+    const server = net.createServer();
+    server.on('error', reject);
+    server.listen(0, '127.0.0.1', () => {
+      const { port } = server.address() as net.AddressInfo;
+      server.close(() => resolve(port));
+    });
+  });
+}
+
+function healthy(port: number): Promise<boolean> {
+  return new Promise((resolve) => {
+    const req = http.get({ host: '127.0.0.1', port, path: '/health' }, (res) => {
+      res.resume();
+      resolve(res.statusCode === 200);
+    });
+    req.on('error', () => resolve(false));
+  });
+}
+
+/** Start server.ts (or the compiled server.js next to this file) for one backend. */
+async function startServer(target: Target, cache: boolean): Promise<{ child: ChildProcess; base: URL }> {
+  const port = await freePort();
+  const ext = path.extname(__filename);
+  const entry = path.join(__dirname, `server${ext}`);
+  const args = ext === '.ts' ? ['-r', 'ts-node/register', entry] : [entry];
+  const env = {
+    ...process.env,
+    ...TARGET_ENV[target],
+    ...(cache ? {} : { RESULT_CACHE_MAX_ENTRIES: '0' }),
+    PORT: String(port),
+  };
+  // From api/, where the server looks for ../api_worker
+  const child = spawn(process.execPath, args, { cwd: path.resolve(__dirname, '..'), env, stdio: ['ignore', 'ignore', 'inherit'] });
+  let exited = false;
+  child.on('exit', () => { exited = true; });
+  const started = Date.now();
+  while (!(await healthy(port))) {
+    if (exited) fail(`server for backend ${target} exited during startup`);
+    if (Date.now() - started > STARTUP_TIMEOUT_MS) {
+      child.kill();
+      fail(`server for backend ${target} did not answer /health within ${STARTUP_TIMEOUT_MS} ms`);
+    }
+    await new Promise((r) => setTimeout(r, 100));
+  }
+  return { child, base: new URL(`http://127.0.0.1:${port}`) };
+}
+
+function stopServer(child: ChildProcess): Promise<void> {
+  return new Promise((resolve) => {
+    if (child.exitCode !== null || child.signalCode !== null) {
+      resolve();
+      return;
+    }
+    child.on('exit', () => resolve());
+    child.kill('SIGTERM');
+  });
+}
+
+async function measure(options: Options, label: string, base: URL, expected: Target | null): Promise<PhaseResult[]> {
+  const results: PhaseResult[] = [];
+  for (const [np, nr] of options.sizes) {
+    for (const endpoint of options.endpoints) {
+      const bodies = buildBodies(endpoint, np, nr, options.seed);
+      const route = ROUTES[endpoint];
+      if (options.warmup > 0) await runPhase(base, route, bodies, options.concurrency, options.warmup, expected);
+      const phase = await runPhase(base, route, bodies, options.concurrency, options.duration, expected);
+      const result: PhaseResult = { backend: label, endpoint, size: `${np}x${nr}`, ...phase };
+      console.error(`${label} ${endpoint} ${result.size}: ${result.throughput_rps} req/s, `
+        + `p50 ${result.latency_ms.p50} ms, p99 ${result.latency_ms.p99} ms, `
+        + `errors ${result.errors}, fallbacks ${result.fallbacks ?? '-'}`);
+      results.push(result);
+    }
+  }
+  return results;
+}
+
+async function main(): Promise<void> {
+  const options = parseOptions(process.argv.slice(2));
+  const results: PhaseResult[] = [];
+  if (options.url) {
+    results.push(...await measure(options, 'url', new URL(options.url), null));
+  } else {
+    for (const target of options.targets) {
+      const { child, base } = await startServer(target, options.cache);
+      try {
+        results.push(...await measure(options, target, base, target));
+      } finally {
+        await stopServer(child);
+      }
+    }
+  }
+  const report = {
+    generated_at: new Date().toISOString(),
+    node: process.version,
+    config: {
+      backends: options.url ? null : options.targets,
+      url: options.url,
+      endpoints: options.endpoints,
+      sizes: options.sizes.map(([np, nr]) => `${np}x${nr}`),
+      concurrency: options.concurrency,
+      duration_s: options.duration,
+      warmup_s: options.warmup,
+      seed: options.seed,
+      result_cache: options.url ? null : options.cache,
+    },
+    results,
+  };
+  const text = `${JSON.stringify(report, null, 2)}\n`;
+  if (options.out) fs.writeFileSync(options.out, text);
+  else process.stdout.write(text);
+}
+
+main().catch((err) => fail(err instanceof Error ? err.stack ?? err.message : String(err)));
@@ -0,0 +1,164 @@
+/**
+ * In-memory request metrics, rendered in the Prometheus text exposition format
+ * for GET /metrics. Route latencies are labelled with the backend that answered
+ * (native addon, C worker, the TypeScript fallback, or the result cache); C
+ * worker phase timings and work counters come from api_worker --stats.
+ */
+
+/** Histogram bucket upper bounds, in seconds. */
+const LATENCY_BUCKETS = [0.0005, 0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1, 2.5, 5, 10];
+
+export type Backend = 'native' | 'worker' | 'ts' | 'cache';
+
+/** Stats object of one api_worker response (see src/stats.h). */
+export interface WorkerStats {
+  parse_ns: number;
+  need_ns: number;
+  detect_ns: number;
+  rag_ns: number;
+  emit_ns: number;
+  total_ns: number;
+  passes: number;
+  comparisons: number;
+  edges: number;
+}
+
+const WORKER_PHASES = ['parse', 'need', 'detect', 'rag', 'emit'] as const;
+
+interface Histogram {
+  labels: string;
+  counts: number[];   // per bucket, not cumulative
+  sum: number;
+  count: number;
+}
+
+const requestLatency = new Map<string, Histogram>();
+const requestTotals = new Map<string, number>();
+const workerSpawn: Histogram = newHistogram('');
+const workerRequests = new Map<string, number>();
+const workerPhaseSeconds = new Map<string, number>();
+const workerPasses = new Map<string, number>();
+const workerComparisons = new Map<string, number>();
+const workerEdges = new Map<string, number>();
+const cacheLookups = new Map<string, number>();
+let cacheEvictions = 0;
+let cacheEntries = 0;
+let cacheBytes = 0;
+
+function newHistogram(labels: string): Histogram {
+  return { labels, counts: new Array(LATENCY_BUCKETS.length).fill(0), sum: 0, count: 0 };
+}
+
+function observe(h: Histogram, seconds: number): void {
+  const i = LATENCY_BUCKETS.findIndex((le) => seconds <= le);
+  if (i >= 0) h.counts[i]++;
+  h.sum += seconds;
+  h.count++;
+}
+
+function escapeLabel(value: string): string {
+  return value.replace(/\\/g, '\\\\').replace(/"/g, '\\"').replace(/\n/g, '\\n');
+}
+
+function labelSet(labels: Record<string, string | number>): string {
+  return Object.entries(labels).map(([k, v]) => `${k}="${escapeLabel(String(v))}"`).join(',');
+}
+
+function add(map: Map<string, number>, labels: string, value: number): void {
+  map.set(labels, (map.get(labels) ?? 0) + value);
+}
+
+/** Record one finished HTTP request. */
+export function observeRequest(route: string, backend: Backend, status: number, seconds: number): void {
+  const labels = labelSet({ route, backend });
+  let h = requestLatency.get(labels);
+  if (!h) {
+    h = newHistogram(labels);
+    requestLatency.set(labels, h);
+  }
+  observe(h, seconds);
+  add(requestTotals, labelSet({ route, backend, status }), 1);
+}
+
+/** Record the time from spawning an api_worker process until it started. */
+export function observeWorkerSpawn(seconds: number): void {
+  observe(workerSpawn, seconds);
+}
+
+/** Record the stats of one api_worker response. */
+export function recordWorkerStats(command: string, stats: WorkerStats): void {
+  const cmd = labelSet({ command });
+  add(workerRequests, cmd, 1);
+  for (const phase of WORKER_PHASES) {
+    add(workerPhaseSeconds, labelSet({ command, phase }), (stats[`${phase}_ns`] ?? 0) / 1e9);
+  }
+  add(workerPasses, cmd, stats.passes ?? 0);
+  add(workerComparisons, cmd, stats.comparisons ?? 0);
+  add(workerEdges, cmd, stats.edges ?? 0);
+}
+
+/** Record a result cache lookup: found, joined an identical request in flight, or computed. */
+export function recordCacheLookup(kind: string, result: 'hit' | 'shared' | 'miss'): void {
+  add(cacheLookups, labelSet({ kind, result }), 1);
+}
+
+export function recordCacheEviction(): void {
+  cacheEvictions++;
+}
+
+export function setCacheUsage(entries: number, bytes: number): void {
+  cacheEntries = entries;
+  cacheBytes = bytes;
+}
+
+function renderHistogram(lines: string[], name: string, h: Histogram): void {
+  const sep = h.labels ? ',' : '';
+  let cumulative = 0;
+  for (let i = 0; i < LATENCY_BUCKETS.length; i++) {
+    cumulative += h.counts[i];
+    lines.push(`${name}_bucket{${h.labels}${sep}le="${LATENCY_BUCKETS[i]}"} ${cumulative}`);
+  }
+  lines.push(`${name}_bucket{${h.labels}${sep}le="+Inf"} ${h.count}`);
+  const braces = h.labels ? `{${h.labels}}` : '';
+  lines.push(`${name}_sum${braces} ${h.sum}`);
+  lines.push(`${name}_count${braces} ${h.count}`);
+}
+
+function renderCounter(lines: string[], name: string, help: string, map: Map<string, number>): void {
+  lines.push(`# HELP ${name} ${help}`, `# TYPE ${name} counter`);
+  for (const [labels, value] of map) lines.push(`${name}{${labels}} ${value}`);
+}
+
+/** All metrics in the Prometheus text format (version 0.0.4). */
+export function renderMetrics(): string {
+  const lines: string[] = [];
+  lines.push(
+    '# HELP deadlock_http_request_duration_seconds HTTP request latency by route and backend.',
+    '# TYPE deadlock_http_request_duration_seconds histogram',
+  );
+  for (const h of requestLatency.values()) renderHistogram(lines, 'deadlock_http_request_duration_seconds', h);
+  renderCounter(lines, 'deadlock_http_requests_total', 'HTTP requests by route, backend and status.', requestTotals);
+  lines.push(
+    '# HELP deadlock_worker_spawn_seconds Time from spawning an api_worker process until it started.',
+    '# TYPE deadlock_worker_spawn_seconds histogram',
+  );
+  renderHistogram(lines, 'deadlock_worker_spawn_seconds', workerSpawn);
+  renderCounter(lines, 'deadlock_worker_requests_total', 'api_worker responses that carried stats.', workerRequests);
+  renderCounter(lines, 'deadlock_worker_phase_seconds_total', 'api_worker time per command and phase.', workerPhaseSeconds);
+  renderCounter(lines, 'deadlock_worker_detection_passes_total', 'Detection passes run by api_worker.', workerPasses);
+  renderCounter(lines, 'deadlock_worker_comparisons_total', 'Need-vs-Work row checks made by api_worker.', workerComparisons);
+  renderCounter(lines, 'deadlock_worker_rag_edges_total', 'Resource allocation graph edges built by api_worker.', workerEdges);
+  renderCounter(lines, 'deadlock_result_cache_lookups_total', 'Result cache lookups by kind and result.', cacheLookups);
+  lines.push(
+    '# HELP deadlock_result_cache_evictions_total Result cache entries evicted to stay within its limits.',
+    '# TYPE deadlock_result_cache_evictions_total counter',
+    `deadlock_result_cache_evictions_total ${cacheEvictions}`,
+    '# HELP deadlock_result_cache_entries Responses held by the result cache.',
+    '# TYPE deadlock_result_cache_entries gauge',
+    `deadlock_result_cache_entries ${cacheEntries}`,
+    '# HELP deadlock_result_cache_bytes Approximate size of the result cache.',
+    '# TYPE deadlock_result_cache_bytes gauge',
+    `deadlock_result_cache_bytes ${cacheBytes}`,
+  );
+  return lines.join('\n') + '\n';
+}
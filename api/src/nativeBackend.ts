@@ -0,0 +1,150 @@
+/**
+ * In-process C backend: the N-API addon built from api/native (npm run build:native)
+ * links the C core into the server. toMatrices() flattens the rows into Int32Arrays
+ * and the addon copies those into the core's padded SystemState, and each call runs
+ * on the libuv thread pool, so there is neither a process hop nor JSON text on the way in.
+ * Set DEADLOCK_NATIVE=0 to ignore the addon. When it is missing, callers fall back
+ * to the api_worker pool (cBackend) and then to the TypeScript implementation.
+ */
+
+import * as fs from 'fs';
+import * as path from 'path';
+import type {
+  DetectResponse,
+  HeadroomResponse,
+  PlanResponse,
+  RagResponse,
+  ResolveResponse,
+  SimulateResponse,
+  StepSessionResponse,
+} from './cBackend';
+
+interface StateLike {
+  num_processes: number;
+  num_resources: number;
+  available: number[];
+  allocation: number[][];
+  max_need: number[][];
+}
+
+type Matrices = [Int32Array, Int32Array, Int32Array];
+
+interface NativeAddon {
+  detect(np: number, nr: number, ...m: Matrices): Promise<DetectResponse>;
+  rag(np: number, nr: number, ...m: Matrices): Promise<string>;
+  resolve(np: number, nr: number, ...rest: [...Matrices, number]): Promise<string>;
+  simulate(np: number, nr: number, ...rest: [...Matrices, number, number, number]): Promise<string>;
+  headroom(np: number, nr: number, ...m: Matrices): Promise<string>;
+  plan(np: number, nr: number, ...rest: [...Matrices, number, number, Int32Array?]): Promise<string>;
+  stepStart(np: number, nr: number, ...m: Matrices): Promise<NativeStepSession>;
+  step(session: NativeStepSession): string;
+  stepEnd(session: NativeStepSession): boolean;
+}
+
+/** Opaque handle to a C step iterator owned by the addon. */
+export type NativeStepSession = { readonly __brand: 'NativeStepSession' };
+
+/** Path to the built addon (api/native/build/Release when running from api/). */
+function getAddonPath(): string {
+  const fromApi = path.resolve(process.cwd(), 'native', 'build', 'Release', 'deadlock_native.node');
+  const fromRoot = path.resolve(process.cwd(), 'api', 'native', 'build', 'Release', 'deadlock_native.node');
+  if (fs.existsSync(fromApi)) return fromApi;
+  if (fs.existsSync(fromRoot)) return fromRoot;
+  return fromApi;
+}
+
+function loadAddon(): NativeAddon | null {
+  if (process.env.DEADLOCK_NATIVE === '0') return null;
+  const p = getAddonPath();
+  if (!fs.existsSync(p)) return null;
+  try {
+    return require(p) as NativeAddon;
+  } catch {
+    return null;
+  }
+}
+
+const addon = loadAddon();
+
+/** Check if the native addon is built and loadable. */
+export function isNativeAvailable(): boolean {
+  return addon !== null;
+}
+
+function nativeAddon(): NativeAddon {
+  if (!addon) throw new Error('deadlock_native addon not built. Run: npm run build:native');
+  return addon;
+}
+
+/** available, allocation and max_need as flat row-major Int32Arrays. */
+function toMatrices(state: StateLike): Matrices {
+  const { num_processes: np, num_resources: nr } = state;
+  const allocation = new Int32Array(np * nr);
+  const maxNeed = new Int32Array(np * nr);
+  for (let i = 0; i < np; i++) {
+    allocation.set(state.allocation[i], i * nr);
+    maxNeed.set(state.max_need[i], i * nr);
+  }
+  return [Int32Array.from(state.available), allocation, maxNeed];
+}
+
+export function nativeDetect(state: StateLike): Promise<DetectResponse> {
+  return nativeAddon().detect(state.num_processes, state.num_resources, ...toMatrices(state));
+}
+
+export async function nativeRag(state: StateLike): Promise<RagResponse> {
+  const text = await nativeAddon().rag(state.num_processes, state.num_resources, ...toMatrices(state));
+  return JSON.parse(text) as RagResponse;
+}
+
+export async function nativeResolve(
+  state: StateLike & { victim_process_index?: number }
+): Promise<ResolveResponse> {
+  const victim = state.victim_process_index ?? -1;
+  const text = await nativeAddon().resolve(state.num_processes, state.num_resources, ...toMatrices(state), victim);
+  const obj = JSON.parse(text) as ResolveResponse | { error: string };
+  if ('error' in obj && obj.error) throw new Error(obj.error);
+  return obj as ResolveResponse;
+}
+
+export async function nativeSimulate(
+  state: StateLike & { process_index: number; resource_index: number; amount: number }
+): Promise<SimulateResponse> {
+  const { process_index: pi, resource_index: rj, amount } = state;
+  const text = await nativeAddon().simulate(
+    state.num_processes, state.num_resources, ...toMatrices(state), pi, rj, amount);
+  return JSON.parse(text) as SimulateResponse;
+}
+
+export async function nativeHeadroom(state: StateLike): Promise<HeadroomResponse> {
+  const text = await nativeAddon().headroom(state.num_processes, state.num_resources, ...toMatrices(state));
+  return JSON.parse(text) as HeadroomResponse;
+}
+
+/** costModel is the CostModel code from src/planner.h, as for runPlan. */
+export async function nativePlan(
+  state: StateLike,
+  costModel: number,
+  maxCandidates: number,
+  priorities?: number[],
+): Promise<PlanResponse> {
+  const text = await nativeAddon().plan(
+    state.num_processes, state.num_resources, ...toMatrices(state), costModel, maxCandidates,
+    costModel === 1 && priorities ? Int32Array.from(priorities) : undefined);
+  const obj = JSON.parse(text) as PlanResponse | { error: string };
+  if ('error' in obj && obj.error) throw new Error(obj.error);
+  return obj as PlanResponse;
+}
+
+export function nativeStepStart(state: StateLike): Promise<NativeStepSession> {
+  return nativeAddon().stepStart(state.num_processes, state.num_resources, ...toMatrices(state));
+}
+
+/** Synchronous: a step only touches the resources its process releases. */
+export function nativeStep(session: NativeStepSession): StepSessionResponse {
+  return JSON.parse(nativeAddon().step(session)) as StepSessionResponse;
+}
+
+export function nativeStepEnd(session: NativeStepSession): boolean {
+  return nativeAddon().stepEnd(session);
+}
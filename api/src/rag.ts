@@ -23,9 +23,16 @@ export interface RagEdge {
   type: 'request' | 'assignment';
 }
 
+/** One non-trivial strongly connected component of the RAG (node ids). */
+export interface RagCycle {
+  processes: number[];
+  resources: number[];
+}
+
 export interface RagResponse {
   nodes: RagNode[];
   edges: RagEdge[];
+  cycles: RagCycle[];
 }
 
 /**
@@ -83,5 +90,89 @@ export function buildRag(req: RagRequest): RagResponse {
     }
   }
 
-  return { nodes, edges };
+  return { nodes, edges, cycles: findCycles(num_processes + num_resources, num_processes, edges) };
+}
+
+/**
+ * Every cycle of the graph as a strongly connected component with more than
+ * one node (iterative Tarjan, same output order as find_rag_cycles in C):
+ * cycles ordered by lowest process id, members ascending.
+ */
+export function findCycles(totalNodes: number, numProcesses: number, edges: RagEdge[]): RagCycle[] {
+  // CSR adjacency, out-edges in edge-list order
+  const offsets = new Int32Array(totalNodes + 1);
+  for (const e of edges) offsets[e.from + 1]++;
+  for (let v = 0; v < totalNodes; v++) offsets[v + 1] += offsets[v];
+  const targets = new Int32Array(edges.length);
+  const fill = offsets.slice(0, totalNodes);
+  for (const e of edges) targets[fill[e.from]++] = e.to;
+
+  const index = new Int32Array(totalNodes).fill(-1);
+  const low = new Int32Array(totalNodes);
+  const component = new Int32Array(totalNodes).fill(-1);
+  const frameNode = new Int32Array(totalNodes);
+  const frameEdge = new Int32Array(totalNodes);
+  const sccStack = new Int32Array(totalNodes);
+  const componentSize: number[] = [];
+  let nextIndex = 0;
+  let sccTop = 0;
+
+  for (let root = 0; root < totalNodes; root++) {
+    if (index[root] >= 0) continue;
+    let depth = 0;
+    frameNode[0] = root;
+    frameEdge[0] = offsets[root];
+    index[root] = low[root] = nextIndex++;
+    sccStack[sccTop++] = root;
+
+    while (depth >= 0) {
+      const node = frameNode[depth];
+      const k = frameEdge[depth];
+      if (k < offsets[node + 1]) {
+        frameEdge[depth] = k + 1;
+        const next = targets[k];
+        if (index[next] < 0) {
+          depth++;
+          frameNode[depth] = next;
+          frameEdge[depth] = offsets[next];
+          index[next] = low[next] = nextIndex++;
+          sccStack[sccTop++] = next;
+        } else if (component[next] < 0 && index[next] < low[node]) {
+          low[node] = index[next];
+        }
+        continue;
+      }
+      if (low[node] === index[node]) {
+        let size = 0;
+        let member;
+        do {
+          member = sccStack[--sccTop];
+          component[member] = componentSize.length;
+          size++;
+        } while (member !== node);
+        componentSize.push(size);
+      }
+      depth--;
+      if (depth >= 0 && low[node] < low[frameNode[depth]]) {
+        low[frameNode[depth]] = low[node];
+      }
+    }
+  }
+
+  // Scanning node ids upwards orders cycles by lowest process id and keeps
+  // members ascending (processes have lower ids than resources)
+  const cycles: RagCycle[] = [];
+  const renumber = new Int32Array(componentSize.length).fill(-1);
+  for (let v = 0; v < totalNodes; v++) {
+    const c = component[v];
+    if (componentSize[c] < 2) continue;
+    if (renumber[c] < 0) {
+      renumber[c] = cycles.length;
+      cycles.push({ processes: [], resources: [] });
+    }
+    const cycle = cycles[renumber[c]];
+    if (v < numProcesses) cycle.processes.push(v);
+    else cycle.resources.push(v);
+  }
+  return cycles;
 }
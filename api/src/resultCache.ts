@@ -0,0 +1,87 @@
+/**
+ * Bounded LRU of JSON responses, keyed on the canonical state hash
+ * (stateHash.ts) plus the request's own arguments, for dashboards that poll
+ * the same snapshot. Identical requests that arrive while one is being
+ * computed share that computation. The cache holds at most
+ * RESULT_CACHE_MAX_ENTRIES responses and about RESULT_CACHE_MAX_BYTES of
+ * key and response text (UTF-16); either set to 0 disables it.
+ */
+
+import { recordCacheLookup, recordCacheEviction, setCacheUsage, type Backend } from './metrics';
+
+const MAX_BYTES = envLimit('RESULT_CACHE_MAX_BYTES', 64 * 1024 * 1024);
+const MAX_ENTRIES = envLimit('RESULT_CACHE_MAX_ENTRIES', 4096);
+const ENTRY_OVERHEAD_BYTES = 64;
+
+function envLimit(name: string, fallback: number): number {
+  const v = Number(process.env[name]);
+  return process.env[name] !== undefined && Number.isFinite(v) && v >= 0 ? v : fallback;
+}
+
+/** A response as JSON text, with the backend that computed it. */
+export interface CachedResult {
+  text: string;
+  backend: Backend;
+}
+
+interface Entry {
+  result: CachedResult;
+  bytes: number;
+}
+
+// Map order is least recently used first: an entry is re-inserted on every hit
+const entries = new Map<string, Entry>();
+const inFlight = new Map<string, Promise<CachedResult>>();
+let totalBytes = 0;
+
+function store(key: string, result: CachedResult): void {
+  const bytes = 2 * (key.length + result.text.length) + ENTRY_OVERHEAD_BYTES;
+  if (bytes > MAX_BYTES) return;
+  entries.set(key, { result, bytes });
+  totalBytes += bytes;
+  while (totalBytes > MAX_BYTES || entries.size > MAX_ENTRIES) {
+    const [oldest, entry] = entries.entries().next().value as [string, Entry];
+    entries.delete(oldest);
+    totalBytes -= entry.bytes;
+    recordCacheEviction();
+  }
+  setCacheUsage(entries.size, totalBytes);
+}
+
+/**
+ * The cached response for key, or compute() once and cache it. A null key
+ * (state that cannot be hashed) or a disabled cache always computes. A
+ * response that was not computed for this request reports backend "cache".
+ * Failed computations are not cached.
+ * @param kind Route label for the hit/miss counters
+ */
+export async function cachedResult(
+  kind: string,
+  key: string | null,
+  compute: () => Promise<CachedResult>,
+): Promise<CachedResult> {
+  if (key === null || MAX_BYTES === 0 || MAX_ENTRIES === 0) return compute();
+  const entry = entries.get(key);
+  if (entry) {
+    entries.delete(key);
+    entries.set(key, entry);
+    recordCacheLookup(kind, 'hit');
+    return { text: entry.result.text, backend: 'cache' };
+  }
+  const pending = inFlight.get(key);
+  if (pending) {
+    recordCacheLookup(kind, 'shared');
+    const result = await pending;
+    return { text: result.text, backend: 'cache' };
+  }
+  recordCacheLookup(kind, 'miss');
+  const promise = compute();
+  inFlight.set(key, promise);
+  try {
+    const result = await promise;
+    store(key, result);
+    return result;
+  } finally {
+    inFlight.delete(key);
+  }
+}
@@ -6,22 +6,46 @@ import {
   validateStepRequest,
   validateResolveRequest,
   validateSimulateRequest,
+  validateBatchDetectRequest,
+  validatePlanRequest,
   detectDeadlockStep,
   resolveDeadlock,
   simulateRequest,
+  computeHeadroom,
+  planResolution,
+  COST_MODELS,
+  DEFAULT_MAX_CANDIDATES,
   type DetectRequest,
   type StepRequest,
   type ResolveRequest,
   type SimulateRequest,
+  type BatchDetectRequest,
+  type PlanRequest,
 } from './detector';
 import { buildRag, type RagRequest } from './rag';
 import {
   isCWorkerAvailable,
   runDetect as cRunDetect,
+  runBatchDetect as cRunBatchDetect,
   runRag as cRunRag,
   runResolve as cRunResolve,
   runSimulate as cRunSimulate,
+  runHeadroom as cRunHeadroom,
+  runPlan as cRunPlan,
 } from './cBackend';
+import {
+  isNativeAvailable,
+  nativeDetect,
+  nativeRag,
+  nativeResolve,
+  nativeSimulate,
+  nativeHeadroom,
+  nativePlan,
+} from './nativeBackend';
+import { observeRequest, renderMetrics, type Backend } from './metrics';
+import { openStepSession, stepSession, closeStepSession } from './stepSessions';
+import { cachedResult } from './resultCache';
+import { stateHash } from './stateHash';
 
 const app = express();
 const PORT = process.env.PORT || 3001;
@@ -33,7 +57,28 @@ app.use(cors({
   allowedHeaders: ['Content-Type'],
 }));
 
-app.use(express.json({ strict: true }));
+// Large states (up to 100k processes x 1k resources) exceed express's 100kb default
+app.use(express.json({ strict: true, limit: process.env.JSON_BODY_LIMIT || '256mb' }));
+
+// Latency per route and per backend for /metrics. Routes that answer from C
+// call setBackend(); everything else counts as the TypeScript implementation.
+// The X-Backend response header names the same backend for load tests.
+app.use((req, res, next) => {
+  const start = process.hrtime.bigint();
+  res.setHeader('X-Backend', 'ts');
+  res.on('finish', () => {
+    const route = req.route ? String(req.route.path) : 'unmatched';
+    const backend: Backend = res.locals.backend ?? 'ts';
+    observeRequest(route, backend, res.statusCode, Number(process.hrtime.bigint() - start) / 1e9);
+  });
+  next();
+});
+
+/** Record the backend that answered, for /metrics and the X-Backend header. */
+function setBackend(res: express.Response, backend: Backend): void {
+  res.locals.backend = backend;
+  res.setHeader('X-Backend', backend);
+}
 
 // Invalid JSON body → 400 with clear message
 app.use((err: unknown, _req: express.Request, res: express.Response, next: express.NextFunction) => {
@@ -52,16 +97,44 @@ app.get('/health', (_req, res) => {
   });
 });
 
+/**
+ * Send a route's response through the result cache (resultCache.ts). compute
+ * tries the backends in order and reports which one answered.
+ */
+async function sendCached(
+  res: express.Response,
+  kind: string,
+  key: string | null,
+  compute: () => Promise<{ value: unknown; backend: Backend }>,
+): Promise<void> {
+  const result = await cachedResult(kind, key, async () => {
+    const { value, backend } = await compute();
+    return { text: JSON.stringify(value), backend };
+  });
+  if (result.backend !== 'ts') setBackend(res, result.backend);
+  res.type('application/json').send(result.text);
+}
+
+/**
+ * GET /metrics
+ * Prometheus text format: request latency histograms per route and backend,
+ * api_worker spawn latency, the C worker's phase timings and counters, and
+ * result cache lookups.
+ */
+app.get('/metrics', (_req, res) => {
+  res.type('text/plain; version=0.0.4').send(renderMetrics());
+});
+
 /**
  * POST /api/detect
  * Runs deadlock detection (Banker's Algorithm) on the given system state.
  *
  * Request body (JSON):
- *   - num_processes: number (1..10)
- *   - num_resources: number (1..10)
- *   - available: number[] (length = num_resources, non-negative)
- *   - allocation: number[][] (num_processes x num_resources, non-negative, allocation[i][j] <= max_need[i][j])
- *   - max_need: number[][] (num_processes x num_resources, non-negative)
+ *   - num_processes: number (1..100000)
+ *   - num_resources: number (1..1024)
+ *   - available: number[] (length = num_resources, 0..2147483647)
+ *   - allocation: number[][] (num_processes x num_resources, 0..2147483647, allocation[i][j] <= max_need[i][j])
+ *   - max_need: number[][] (num_processes x num_resources, 0..2147483647)
  *
  * Response (JSON):
  *   - is_deadlocked: boolean
@@ -76,17 +149,55 @@ app.post('/api/detect', async (req, res) => {
     return;
   }
   const body = req.body as DetectRequest;
+  const hash = stateHash(body);
+  await sendCached(res, 'detect', hash && `detect:${hash}`, async () => {
+    if (isNativeAvailable()) {
+      try {
+        return { value: await nativeDetect(body), backend: 'native' };
+      } catch (_e) {
+        /* fall back to the worker pool */
+      }
+    }
+    if (isCWorkerAvailable()) {
+      try {
+        return { value: await cRunDetect(body), backend: 'worker' };
+      } catch (_e) {
+        /* fall back to TypeScript */
+      }
+    }
+    return { value: detectDeadlock(body), backend: 'ts' };
+  });
+});
+
+/**
+ * POST /api/detect/batch
+ * Runs deadlock detection on many system states in one call. The C worker
+ * detects them in parallel on its thread pool.
+ *
+ * Request body (JSON):
+ *   - states: DetectRequest[] (each validated as for /api/detect)
+ *
+ * Response (JSON):
+ *   - results: DetectResponse[] (same order as states)
+ */
+app.post('/api/detect/batch', async (req, res) => {
+  const validationError = validateBatchDetectRequest(req.body);
+  if (validationError) {
+    res.status(400).json({ error: validationError });
+    return;
+  }
+  const body = req.body as BatchDetectRequest;
   if (isCWorkerAvailable()) {
     try {
-      const result = await cRunDetect(body);
-      res.json(result);
+      const results = await cRunBatchDetect(body.states);
+      setBackend(res, 'worker');
+      res.type('application/json').send(`{"results":${results}}`);
       return;
     } catch (_e) {
       /* fall back to TypeScript */
     }
   }
-  const result = detectDeadlock(body);
-  res.json(result);
+  res.json({ results: body.states.map((state) => detectDeadlock(state)) });
 });
 
 /**
@@ -121,17 +232,59 @@ app.post('/api/export', (req, res) => {
  *   - explanation: string
  *   - step_state: { work, finish, safe_sequence }   (pass back in the next call)
  *   - deadlocked_processes?: number[]                (only when status = "deadlock")
+ *
+ * Step sessions: send the state with "session": true (and no step_state) to
+ * keep the iteration on the server, then only { "session_id": "..." } for
+ * each following step. Each step then costs the resources its process
+ * releases rather than a replay from the start. Session responses carry
+ * session_id, work and steps (processes finished so far) in place of
+ * step_state; the session ends with the done or deadlock step. 404 if the
+ * session is unknown, has ended or expired.
  */
-app.post('/api/detect/step', (req, res) => {
+app.post('/api/detect/step', async (req, res) => {
+  const sessionId = (req.body as { session_id?: unknown } | undefined)?.session_id;
+  if (sessionId !== undefined) {
+    if (typeof sessionId !== 'string') {
+      res.status(400).json({ error: 'session_id must be a string' });
+      return;
+    }
+    await sendSessionStep(res, sessionId);
+    return;
+  }
   const validationError = validateStepRequest(req.body);
   if (validationError) {
     res.status(400).json({ error: validationError });
     return;
   }
-  const result = detectDeadlockStep(req.body as StepRequest);
+  const body = req.body as StepRequest;
+  if (body.session) {
+    const { id } = await openStepSession(body);
+    await sendSessionStep(res, id);
+    return;
+  }
+  const result = detectDeadlockStep(body);
   res.json(result);
 });
 
+async function sendSessionStep(res: express.Response, id: string): Promise<void> {
+  // A session whose backend failed is gone as well
+  const outcome = await stepSession(id).catch(() => null);
+  if (!outcome) {
+    res.status(404).json({ error: 'Unknown or expired step session' });
+    return;
+  }
+  if (outcome.backend !== 'ts') setBackend(res, outcome.backend);
+  res.json({ session_id: id, ...outcome.step });
+}
+
+/**
+ * DELETE /api/detect/step/:session_id
+ * Ends a step session early. Response: { closed: boolean } (false if it had already ended).
+ */
+app.delete('/api/detect/step/:session_id', (req, res) => {
+  res.json({ closed: closeStepSession(req.params.session_id) });
+});
+
 /**
  * POST /api/resolve
  * Resolves deadlock by terminating one process (victim). Returns updated state and detection result.
@@ -155,9 +308,20 @@ app.post('/api/resolve', async (req, res) => {
     return;
   }
   const body = req.body as ResolveRequest;
+  if (isNativeAvailable()) {
+    try {
+      const result = await nativeResolve(body);
+      setBackend(res, 'native');
+      res.json(result);
+      return;
+    } catch (_e) {
+      /* fall back to the worker pool */
+    }
+  }
   if (isCWorkerAvailable()) {
     try {
       const result = await cRunResolve(body);
+      setBackend(res, 'worker');
       res.json(result);
       return;
     } catch (_e) {
@@ -173,6 +337,55 @@ app.post('/api/resolve', async (req, res) => {
   }
 });
 
+/**
+ * POST /api/resolve/plan
+ * Plans every termination needed to end the deadlock, where /api/resolve takes one.
+ *
+ * Request body (JSON):
+ *   - Same as /api/detect
+ *   - cost_model (optional): "units_held" (default), "priority" or "work_lost"
+ *   - priorities (required for "priority"): one integer per process, lower is terminated first
+ *   - max_candidates (optional, default 8): cheapest deadlocked processes tried per step
+ *
+ * Response (JSON):
+ *   - plan: { process, cost, unblocked }[] in termination order (empty if not deadlocked)
+ *   - total_cost: sum of the victims' costs
+ *   - state: state with every victim terminated
+ *   - result: detection on that state (safe_sequence lists each victim where it was terminated)
+ */
+app.post('/api/resolve/plan', async (req, res) => {
+  const validationError = validatePlanRequest(req.body);
+  if (validationError) {
+    res.status(400).json({ error: validationError });
+    return;
+  }
+  const body = req.body as PlanRequest;
+  const costModel = COST_MODELS.indexOf(body.cost_model ?? 'units_held');
+  const maxCandidates = body.max_candidates ?? DEFAULT_MAX_CANDIDATES;
+  if (isNativeAvailable()) {
+    try {
+      const result = await nativePlan(body, costModel, maxCandidates, body.priorities);
+      setBackend(res, 'native');
+      res.json(result);
+      return;
+    } catch (_e) {
+      /* fall back to the worker pool */
+    }
+  }
+  if (isCWorkerAvailable()) {
+    try {
+      const result = await cRunPlan(body, costModel, maxCandidates, body.priorities);
+      setBackend(res, 'worker');
+      res.json(result);
+      return;
+    } catch (_e) {
+      /* fall back to TypeScript */
+    }
+  }
+  const result = planResolution(body);
+  res.json(result);
+});
+
 /**
  * POST /api/simulate-request
  * Deadlock avoidance: simulates granting a resource request without changing state.
@@ -186,16 +399,62 @@ app.post('/api/simulate-request', async (req, res) => {
     return;
   }
   const body = req.body as SimulateRequest;
+  const hash = stateHash(body);
+  const key = hash && `simulate:${hash}:${body.process_index}:${body.resource_index}:${body.amount}`;
+  await sendCached(res, 'simulate', key, async () => {
+    if (isNativeAvailable()) {
+      try {
+        return { value: await nativeSimulate(body), backend: 'native' };
+      } catch (_e) {
+        /* fall back to the worker pool */
+      }
+    }
+    if (isCWorkerAvailable()) {
+      try {
+        return { value: await cRunSimulate(body), backend: 'worker' };
+      } catch (_e) {
+        /* fall back to TypeScript */
+      }
+    }
+    return { value: simulateRequest(body), backend: 'ts' };
+  });
+});
+
+/**
+ * POST /api/headroom
+ * For every process and resource, the largest request /api/simulate-request would
+ * grant, so a client can answer any what-if from one call.
+ * Request body: same as /api/detect.
+ * Response: is_safe, headroom[process][resource] (all zero when unsafe).
+ */
+app.post('/api/headroom', async (req, res) => {
+  const validationError = validateDetectRequest(req.body);
+  if (validationError) {
+    res.status(400).json({ error: validationError });
+    return;
+  }
+  const body = req.body as DetectRequest;
+  if (isNativeAvailable()) {
+    try {
+      const result = await nativeHeadroom(body);
+      setBackend(res, 'native');
+      res.json(result);
+      return;
+    } catch (_e) {
+      /* fall back to the worker pool */
+    }
+  }
   if (isCWorkerAvailable()) {
     try {
-      const result = await cRunSimulate(body);
+      const result = await cRunHeadroom(body);
+      setBackend(res, 'worker');
       res.json(result);
       return;
     } catch (_e) {
       /* fall back to TypeScript */
     }
   }
-  const result = simulateRequest(body);
+  const result = computeHeadroom(body);
   res.json(result);
 });
 
@@ -208,6 +467,8 @@ app.post('/api/simulate-request', async (req, res) => {
  * Response (JSON):
  *   - nodes: { id, label, type: "process"|"resource" }[]
  *   - edges: { from, to, type: "request"|"assignment" }[]
+ *   - cycles: { processes, resources }[] (node ids of each strongly
+ *     connected component; with single-instance resources, each is a deadlock)
  */
 app.post('/api/rag', async (req, res) => {
   const validationError = validateDetectRequest(req.body);
@@ -216,17 +477,24 @@ app.post('/api/rag', async (req, res) => {
     return;
   }
   const body = req.body as RagRequest;
-  if (isCWorkerAvailable()) {
-    try {
-      const result = await cRunRag(body);
-      res.json(result);
-      return;
-    } catch (_e) {
-      /* fall back to TypeScript */
+  const hash = stateHash(body);
+  await sendCached(res, 'rag', hash && `rag:${hash}`, async () => {
+    if (isNativeAvailable()) {
+      try {
+        return { value: await nativeRag(body), backend: 'native' };
+      } catch (_e) {
+        /* fall back to the worker pool */
+      }
     }
-  }
-  const result = buildRag(body);
-  res.json(result);
+    if (isCWorkerAvailable()) {
+      try {
+        return { value: await cRunRag(body), backend: 'worker' };
+      } catch (_e) {
+        /* fall back to TypeScript */
+      }
+    }
+    return { value: buildRag(body), backend: 'ts' };
+  });
 });
 
 // Catch-all error handler: 500 with consistent { error } shape
@@ -239,8 +507,11 @@ app.use((err: unknown, _req: express.Request, res: express.Response, _next: expr
 app.listen(PORT, () => {
   console.log(`Deadlock Detection API running on http://localhost:${PORT}`);
   console.log(`Health check: http://localhost:${PORT}/health`);
-  if (isCWorkerAvailable()) {
-    console.log('C api_worker binary found — detect, RAG, resolve, simulate use C core.');
+  console.log(`Metrics: http://localhost:${PORT}/metrics`);
+  if (isNativeAvailable()) {
+    console.log('Native addon loaded — detect, RAG, resolve, plan, simulate, headroom run the C core in-process.');
+  } else if (isCWorkerAvailable()) {
+    console.log('C api_worker binary found — detect, RAG, resolve, plan, simulate, headroom use C core.');
   } else {
     console.log('C api_worker not found — using TypeScript implementation. Build with: make api_worker');
   }
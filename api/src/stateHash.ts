@@ -0,0 +1,78 @@
+/**
+ * Canonical 64-bit state hash, bit for bit the same as state_hash() in
+ * src/state_hash.c: two 32-bit MurmurHash3-style lanes over num_processes,
+ * num_resources, available, then allocation and max_need row by row.
+ */
+
+interface StateLike {
+  num_processes: number;
+  num_resources: number;
+  available: number[];
+  allocation: number[][];
+  max_need: number[][];
+}
+
+const INT32_MAX = 0x7fffffff;
+const INT32_MIN = -0x80000000;
+
+/**
+ * The hash as 16 hex digits, or null if a value does not fit the C core's
+ * int32 (such states are not hashed, so they cannot alias smaller values).
+ */
+export function stateHash(state: StateLike): string | null {
+  const np = state.num_processes;
+  const nr = state.num_resources;
+  let h1 = 0x9e3779b9 | 0;
+  let h2 = 0x632be5ab | 0;
+  let ok = true;
+
+  // mix_word() of state_hash.c, inlined into the row loop
+  const mixRow = (row: ArrayLike<number>, n: number): void => {
+    let a = h1;
+    let b = h2;
+    for (let j = 0; j < n; j++) {
+      const v = row[j];
+      if (v > INT32_MAX || v < INT32_MIN) ok = false;
+      let k1 = Math.imul(v | 0, 0xcc9e2d51);
+      k1 = Math.imul((k1 << 15) | (k1 >>> 17), 0x1b873593);
+      a ^= k1;
+      a = (Math.imul((a << 13) | (a >>> 19), 5) + 0xe6546b64) | 0;
+      let k2 = Math.imul(v | 0, 0x85ebca6b);
+      k2 = Math.imul((k2 << 16) | (k2 >>> 16), 0xc2b2ae35);
+      b ^= k2;
+      b = (Math.imul((b << 17) | (b >>> 15), 9) + 0x7feb352d) | 0;
+    }
+    h1 = a;
+    h2 = b;
+  };
+
+  mixRow([np, nr], 2);
+  mixRow(state.available, nr);
+  for (let i = 0; i < np; i++) mixRow(state.allocation[i], nr);
+  for (let i = 0; i < np; i++) mixRow(state.max_need[i], nr);
+  if (!ok) return null;
+
+  const words = (2 + nr + 2 * np * nr) | 0;
+  h1 ^= words;
+  h2 ^= words;
+  h1 = (h1 + h2) | 0;
+  h2 = (h2 + h1) | 0;
+  h1 = fmix32(h1);
+  h2 = fmix32(h2);
+  h1 = (h1 + h2) | 0;
+  h2 = (h2 + h1) | 0;
+  return hex8(h1) + hex8(h2);
+}
+
+function fmix32(h: number): number {
+  h ^= h >>> 16;
+  h = Math.imul(h, 0x85ebca6b);
+  h ^= h >>> 13;
+  h = Math.imul(h, 0xc2b2ae35);
+  h ^= h >>> 16;
+  return h;
+}
+
+function hex8(h: number): string {
+  return (h >>> 0).toString(16).padStart(8, '0');
+}
@@ -0,0 +1,146 @@
+/**
+ * Server-side sessions for POST /api/detect/step. A session holds a C step
+ * iterator (in the native addon, or in the pooled api_worker that started
+ * it), so each step resumes where the last one stopped instead of replaying
+ * the algorithm from the start. Without the C core it holds the TypeScript
+ * step_state and replays one step per call.
+ * A session ends with the step that reports done or deadlock, when it is
+ * closed, or after STEP_SESSION_TTL_MS without a step; at most
+ * STEP_SESSION_LIMIT are kept, the least recently used being dropped first.
+ */
+
+import { randomUUID } from 'crypto';
+import { detectDeadlockStep, type DetectRequest, type StepRequest } from './detector';
+import {
+  isCWorkerAvailable,
+  startStepSession as cStartStepSession,
+  runStep as cRunStep,
+  endStepSession as cEndStepSession,
+  type StepSessionResponse,
+  type WorkerStepSession,
+} from './cBackend';
+import {
+  isNativeAvailable,
+  nativeStepStart,
+  nativeStep,
+  nativeStepEnd,
+  type NativeStepSession,
+} from './nativeBackend';
+import type { Backend } from './metrics';
+
+const SESSION_TTL_MS = Number(process.env.STEP_SESSION_TTL_MS) || 5 * 60 * 1000;
+const SESSION_LIMIT = Math.max(1, Number(process.env.STEP_SESSION_LIMIT) || 256);
+
+type Holder =
+  | { backend: 'native'; handle: NativeStepSession }
+  | { backend: 'worker'; session: WorkerStepSession }
+  | { backend: 'ts'; request: StepRequest };
+
+interface Session {
+  holder: Holder;
+  lastUsed: number;
+}
+
+// Map order is least recently used first: a session is re-inserted on every step
+const sessions = new Map<string, Session>();
+
+function release(holder: Holder): void {
+  if (holder.backend === 'native') {
+    nativeStepEnd(holder.handle);
+  } else if (holder.backend === 'worker') {
+    cEndStepSession(holder.session).catch(() => { /* the worker is gone, and the session with it */ });
+  }
+}
+
+function drop(id: string): void {
+  const s = sessions.get(id);
+  if (!s) return;
+  sessions.delete(id);
+  release(s.holder);
+}
+
+function sweep(now: number): void {
+  for (const [id, s] of sessions) {
+    if (now - s.lastUsed < SESSION_TTL_MS) break;
+    drop(id);
+  }
+}
+
+setInterval(() => sweep(Date.now()), 60 * 1000).unref();
+
+async function openHolder(state: DetectRequest): Promise<Holder> {
+  if (isNativeAvailable()) {
+    try {
+      return { backend: 'native', handle: await nativeStepStart(state) };
+    } catch (_e) {
+      /* fall back to the worker pool */
+    }
+  }
+  if (isCWorkerAvailable()) {
+    try {
+      return { backend: 'worker', session: await cStartStepSession(state) };
+    } catch (_e) {
+      /* fall back to TypeScript */
+    }
+  }
+  return { backend: 'ts', request: { ...state, step_state: null } };
+}
+
+async function stepHolder(holder: Holder): Promise<StepSessionResponse> {
+  if (holder.backend === 'native') return nativeStep(holder.handle);
+  if (holder.backend === 'worker') return cRunStep(holder.session);
+  const res = detectDeadlockStep(holder.request);
+  holder.request.step_state = res.step_state;
+  return {
+    status: res.status,
+    selected_process: res.selected_process,
+    explanation: res.explanation,
+    work: res.step_state.work,
+    steps: res.step_state.safe_sequence.length,
+    ...(res.deadlocked_processes ? { deadlocked_processes: res.deadlocked_processes } : {}),
+  };
+}
+
+/** Start a session on the first backend that accepts the state. */
+export async function openStepSession(state: DetectRequest): Promise<{ id: string; backend: Backend }> {
+  const now = Date.now();
+  sweep(now);
+  const holder = await openHolder(state);
+  while (sessions.size >= SESSION_LIMIT) {
+    drop(sessions.keys().next().value as string);
+  }
+  const id = randomUUID();
+  sessions.set(id, { holder, lastUsed: now });
+  return { id, backend: holder.backend };
+}
+
+/**
+ * Run the next step of a session; null if it is unknown or has ended.
+ * A backend failure (e.g. its worker died) ends the session and throws.
+ */
+export async function stepSession(
+  id: string,
+): Promise<{ step: StepSessionResponse; backend: Backend } | null> {
+  const s = sessions.get(id);
+  if (!s) return null;
+  s.lastUsed = Date.now();
+  sessions.delete(id);
+  sessions.set(id, s);
+  let step: StepSessionResponse;
+  try {
+    step = await stepHolder(s.holder);
+  } catch (err) {
+    if (sessions.get(id) === s) drop(id);
+    throw err;
+  }
+  // The C iterators free themselves after the last step
+  if (step.status !== 'found' && sessions.get(id) === s) sessions.delete(id);
+  return { step, backend: s.holder.backend };
+}
+
+/** End a session early; false if it is unknown or has already ended. */
+export function closeStepSession(id: string): boolean {
+  if (!sessions.has(id)) return false;
+  drop(id);
+  return true;
+}
@@ -1,8 +1,8 @@
-import { useState } from 'react'
+import { useEffect, useState } from 'react'
 import { Link } from 'react-router-dom'
 import { useAppState } from '../context/AppContext'
-import { simulateResourceRequest } from '../services/api'
-import type { SimulateResponse } from '../types/detection'
+import { fetchHeadroom, simulateResourceRequest } from '../services/api'
+import type { HeadroomResponse, SimulateResponse } from '../types/detection'
 import './SimulatePage.css'
 
 function SimulatePage() {
@@ -14,6 +14,18 @@ function SimulatePage() {
   const [loading, setLoading] = useState(false)
   const [error, setError] = useState<string | null>(null)
   const [result, setResult] = useState<SimulateResponse | null>(null)
+  const [headroom, setHeadroom] = useState<HeadroomResponse | null>(null)
+
+  // One call answers every (process, resource) question; the hint is best-effort
+  useEffect(() => {
+    if (!config) return
+    let cancelled = false
+    setHeadroom(null)
+    fetchHeadroom(config)
+      .then((res) => { if (!cancelled) setHeadroom(res) })
+      .catch(() => { /* hint only */ })
+    return () => { cancelled = true }
+  }, [config])
 
   if (!config) {
     return (
@@ -91,6 +103,14 @@ function SimulatePage() {
         </button>
       </div>
 
+      {headroom && (
+        <p className="simulate-headroom">
+          {headroom.is_safe
+            ? `Largest safe grant of R${resourceIndex} to P${processIndex}: ${headroom.headroom[processIndex]?.[resourceIndex] ?? 0} unit(s)`
+            : 'The current state is unsafe, so no request can be granted safely.'}
+        </p>
+      )}
+
       {error && <p className="simulate-error">{error}</p>}
 
       {result && (
@@ -1,5 +1,5 @@
 import type { SystemConfig } from '../types/system'
-import type { DetectionResult, StepState, StepResponse, ResolveResponse, SimulateResponse } from '../types/detection'
+import type { DetectionResult, StepState, StepResponse, ResolveResponse, SimulateResponse, HeadroomResponse } from '../types/detection'
 import type { RagData } from '../types/rag'
 
 const API_BASE = import.meta.env.VITE_API_URL || 'http://localhost:3001'
@@ -202,6 +202,15 @@ export async function simulateResourceRequest(
   })
 }
 
+/** Largest safe grant for every (process, resource) in one call. */
+export async function fetchHeadroom(config: SystemConfig): Promise<HeadroomResponse> {
+  return apiRequest<HeadroomResponse>(`${API_BASE}/api/headroom`, {
+    method: 'POST',
+    headers: { 'Content-Type': 'application/json' },
+    body: JSON.stringify(configToPayload(config)),
+  })
+}
+
 export async function fetchRag(config: SystemConfig): Promise<RagData> {
   return apiRequest<RagData>(`${API_BASE}/api/rag`, {
     method: 'POST',
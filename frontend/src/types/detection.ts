@@ -25,6 +25,12 @@ export interface SimulateResponse {
   message: string
 }
 
+export interface HeadroomResponse {
+  is_safe: boolean
+  /** headroom[i][j]: largest safe single grant of Rj to Pi */
+  headroom: number[][]
+}
+
 export interface ResolveResponse {
   state: {
     num_processes: number
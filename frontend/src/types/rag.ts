@@ -10,7 +10,13 @@ export interface RagEdge {
   type: 'request' | 'assignment'
 }
 
+export interface RagCycle {
+  processes: number[]
+  resources: number[]
+}
+
 export interface RagData {
   nodes: RagNode[]
   edges: RagEdge[]
+  cycles?: RagCycle[]
 }
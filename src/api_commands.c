@@ -0,0 +1,347 @@
+/*
+ * Deadlock Detection System
+ * JSON responses shared by api_worker and the Node native addon
+ */
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include "api_commands.h"
+#include "headroom.h"
+#include "planner.h"
+#include "rag.h"
+
+// Detection result as a JSON object (no newline; for embedding)
+void api_detect_json(JsonWriter *out, const DetectionResult *res) {
+    if (res->is_deadlocked) {
+        json_lit(out, "{\"is_deadlocked\":true,\"deadlocked_processes\":[");
+    } else {
+        json_lit(out, "{\"is_deadlocked\":false,\"deadlocked_processes\":[");
+    }
+    json_ints(out, res->deadlocked_processes, res->num_deadlocked, ",", "");
+    json_lit(out, "],\"safe_sequence\":[");
+    json_ints(out, res->safe_sequence, res->safe_sequence_length, ",", "");
+    json_lit(out, "],\"safe_sequence_length\":");
+    json_int(out, res->safe_sequence_length);
+    json_char(out, '}');
+}
+
+void api_rag(JsonWriter *out, SystemState *state) {
+    calculate_need_matrix(state);
+    RAG rag;
+    init_rag(&rag);
+    build_rag(state, &rag);
+
+    json_lit(out, "{\"nodes\":[");
+    int first = 1;
+    for (int i = 0; i < state->num_processes; i++) {
+        if (!first) json_char(out, ',');
+        json_lit(out, "{\"id\":");
+        json_int(out, i);
+        json_lit(out, ",\"label\":\"P");
+        json_int(out, i);
+        json_lit(out, "\",\"type\":\"process\"}");
+        first = 0;
+    }
+    for (int j = 0; j < state->num_resources; j++) {
+        if (!first) json_char(out, ',');
+        json_lit(out, "{\"id\":");
+        json_int(out, state->num_processes + j);
+        json_lit(out, ",\"label\":\"R");
+        json_int(out, j);
+        json_lit(out, "\",\"type\":\"resource\"}");
+        first = 0;
+    }
+    json_lit(out, "],\"edges\":[");
+    first = 1;
+    for (int e = 0; e < rag.num_edges; e++) {
+        if (!first) json_char(out, ',');
+        json_lit(out, "{\"from\":");
+        json_int(out, rag.edges[e].from);
+        json_lit(out, ",\"to\":");
+        json_int(out, rag.edges[e].to);
+        if (rag.edges[e].type == REQUEST) {
+            json_lit(out, ",\"type\":\"request\"}");
+        } else {
+            json_lit(out, ",\"type\":\"assignment\"}");
+        }
+        first = 0;
+    }
+
+    // Each cycle: its processes, and the resources linking them (node ids)
+    RagCycles cycles;
+    init_rag_cycles(&cycles);
+    find_rag_cycles(&rag, &cycles);
+    json_lit(out, "],\"cycles\":[");
+    for (int c = 0; c < cycles.num_cycles; c++) {
+        if (c > 0) json_char(out, ',');
+        json_lit(out, "{\"processes\":[");
+        first = 1;
+        for (int k = cycles.offsets[c]; k < cycles.offsets[c + 1]; k++) {
+            int v = cycles.nodes[k];
+            if (v >= state->num_processes) continue;
+            if (!first) json_char(out, ',');
+            json_int(out, v);
+            first = 0;
+        }
+        json_lit(out, "],\"resources\":[");
+        first = 1;
+        for (int k = cycles.offsets[c]; k < cycles.offsets[c + 1]; k++) {
+            int v = cycles.nodes[k];
+            if (v < state->num_processes) continue;
+            if (!first) json_char(out, ',');
+            json_int(out, v);
+            first = 0;
+        }
+        json_lit(out, "]}");
+    }
+    json_lit(out, "]}");
+    free_rag_cycles(&cycles);
+    free_rag(&rag);
+}
+
+int api_pick_victim(const SystemState *state, const DetectionResult *res) {
+    int victim = res->deadlocked_processes[0];
+    int min_total = 0;
+    for (int j = 0; j < state->num_resources; j++)
+        min_total += state->allocation[victim][j];
+
+    for (int i = 1; i < res->num_deadlocked; i++) {
+        int p = res->deadlocked_processes[i];
+        int total = 0;
+        for (int j = 0; j < state->num_resources; j++)
+            total += state->allocation[p][j];
+        if (total < min_total) {
+            min_total = total;
+            victim = p;
+        }
+    }
+    return victim;
+}
+
+static void apply_victim(SystemState *state, int victim) {
+    for (int j = 0; j < state->num_resources; j++) {
+        state->available[j] += state->allocation[victim][j];
+        state->allocation[victim][j] = 0;
+        state->max_need[victim][j] = 0;
+    }
+}
+
+// Rows of a matrix as nested JSON arrays
+static void output_matrix(JsonWriter *out, int *const *rows, int num_rows, int num_columns) {
+    for (int i = 0; i < num_rows; i++) {
+        if (i) json_char(out, ',');
+        json_char(out, '[');
+        json_ints(out, rows[i], num_columns, ",", "");
+        json_char(out, ']');
+    }
+}
+
+static void output_state(JsonWriter *out, const SystemState *state) {
+    json_lit(out, "\"num_processes\":");
+    json_int(out, state->num_processes);
+    json_lit(out, ",\"num_resources\":");
+    json_int(out, state->num_resources);
+    json_lit(out, ",\"available\":[");
+    json_ints(out, state->available, state->num_resources, ",", "");
+    json_lit(out, "],\"allocation\":[");
+    output_matrix(out, state->allocation, state->num_processes, state->num_resources);
+    json_lit(out, "],\"max_need\":[");
+    output_matrix(out, state->max_need, state->num_processes, state->num_resources);
+    json_char(out, ']');
+}
+
+void api_resolve(JsonWriter *out, SystemState *state, int victim_override) {
+    calculate_need_matrix(state);
+    DetectionResult res;
+    init_detection_result(&res);
+    detect_deadlock(state, &res);
+    if (!res.is_deadlocked || res.num_deadlocked == 0) {
+        json_lit(out, "{\"error\":\"State is not deadlocked; resolution not applicable.\"}");
+        free_detection_result(&res);
+        return;
+    }
+    int victim = victim_override;
+    if (victim < 0) {
+        victim = api_pick_victim(state, &res);
+    } else {
+        bool ok = false;
+        for (int i = 0; i < res.num_deadlocked; i++) {
+            if (res.deadlocked_processes[i] == victim) { ok = true; break; }
+        }
+        if (!ok || victim < 0 || victim >= state->num_processes) {
+            json_lit(out, "{\"error\":\"Invalid or non-deadlocked victim_process_index.\"}");
+            free_detection_result(&res);
+            return;
+        }
+    }
+    apply_victim(state, victim);
+    detect_deadlock(state, &res);
+
+    json_lit(out, "{\"state\":{");
+    output_state(out, state);
+    json_lit(out, "},\"result\":");
+    api_detect_json(out, &res);
+    json_lit(out, ",\"victim_process\":");
+    json_int(out, victim);
+    json_char(out, '}');
+    free_detection_result(&res);
+}
+
+void api_plan(JsonWriter *out, SystemState *state, int cost_model, int max_candidates,
+              const int *priorities) {
+    PlanOptions options = { cost_units_held, NULL, max_candidates };
+    if (cost_model == COST_PRIORITY) {
+        options.cost = cost_priority;
+        options.cost_ctx = priorities;
+    } else if (cost_model == COST_WORK_LOST) {
+        options.cost = cost_work_lost;
+    } else if (cost_model != COST_UNITS_HELD) {
+        json_lit(out, "{\"error\":\"Unknown cost model.\"}");
+        return;
+    }
+
+    ResolutionPlan plan;
+    DetectionResult res;
+    init_resolution_plan(&plan);
+    init_detection_result(&res);
+    if (!plan_resolution(state, &options, &plan, &res)) {
+        json_lit(out, "{\"error\":\"Planning needs non-negative allocations.\"}");
+        free_detection_result(&res);
+        return;
+    }
+    json_lit(out, "{\"plan\":[");
+    for (int s = 0; s < plan.num_steps; s++) {
+        if (s) json_char(out, ',');
+        json_lit(out, "{\"process\":");
+        json_int(out, plan.steps[s].process);
+        json_lit(out, ",\"cost\":");
+        json_ll(out, plan.steps[s].cost);
+        json_lit(out, ",\"unblocked\":");
+        json_int(out, plan.steps[s].unblocked);
+        json_char(out, '}');
+    }
+    json_lit(out, "],\"total_cost\":");
+    json_ll(out, plan.total_cost);
+    json_lit(out, ",\"state\":{");
+    output_state(out, state);
+    json_lit(out, "},\"result\":");
+    api_detect_json(out, &res);
+    json_char(out, '}');
+    free_resolution_plan(&plan);
+    free_detection_result(&res);
+}
+
+void api_simulate(JsonWriter *out, SystemState *state, int pi, int rj, int amount) {
+    if (amount <= 0 || pi < 0 || pi >= state->num_processes ||
+        rj < 0 || rj >= state->num_resources) {
+        json_lit(out, "{\"granted\":false,\"is_safe\":false,\"message\":\"Invalid process_index, resource_index, or amount.\"}");
+        return;
+    }
+    if ((unsigned)amount > (unsigned)state->available[rj]) {
+        json_lit(out, "{\"granted\":false,\"is_safe\":false,\"message\":\"Request exceeds available resources.\"}");
+        return;
+    }
+    calculate_need_matrix(state);
+    int need_val = state->need[pi][rj];
+    if (amount > need_val) {
+        json_lit(out, "{\"granted\":false,\"is_safe\":false,\"message\":\"Request exceeds remaining need.\"}");
+        return;
+    }
+    state->available[rj] -= amount;
+    state->allocation[pi][rj] += amount;
+    calculate_need_matrix(state);
+    DetectionResult res;
+    init_detection_result(&res);
+    detect_deadlock(state, &res);
+    state->available[rj] += amount;
+    state->allocation[pi][rj] -= amount;
+
+    bool safe = !res.is_deadlocked;
+    free_detection_result(&res);
+    if (safe) {
+        json_lit(out, "{\"granted\":true,\"is_safe\":true,\"message\":\"Granting would keep the system safe.\"}");
+    } else {
+        json_lit(out, "{\"granted\":false,\"is_safe\":false,\"message\":\"Granting would lead to unsafe state.\"}");
+    }
+}
+
+void api_headroom(JsonWriter *out, SystemState *state) {
+    int np = state->num_processes;
+    int nr = state->num_resources;
+    int *headroom = checked_malloc((size_t)np * nr * sizeof(int));
+    bool safe = compute_headroom(state, headroom);
+    if (safe) {
+        json_lit(out, "{\"is_safe\":true,\"headroom\":[");
+    } else {
+        json_lit(out, "{\"is_safe\":false,\"headroom\":[");
+    }
+    for (int i = 0; i < np; i++) {
+        if (i) json_char(out, ',');
+        json_char(out, '[');
+        json_ints(out, headroom + (size_t)i * nr, nr, ",", "");
+        json_char(out, ']');
+    }
+    json_lit(out, "]}");
+    free(headroom);
+}
+
+void api_step(JsonWriter *out, StepIterator *it) {
+    const SystemState *state = &it->state;
+    const Worklist *wl = &it->wl;
+    int nr = state->num_resources;
+    StepStatus status = step_iterator_next(it);
+    int *blocked = NULL;
+    int num_blocked = 0;
+
+    if (status == STEP_FOUND) {
+        int p = it->last;
+        int *before = checked_malloc((size_t)nr * sizeof(int));
+        for (int j = 0; j < nr; j++) {
+            before[j] = wl->work[j] - state->allocation[p][j];
+        }
+        json_lit(out, "{\"status\":\"found\",\"selected_process\":");
+        json_int(out, p);
+        json_lit(out, ",\"explanation\":\"Selected P");
+        json_int(out, p);
+        json_lit(out, ": Need(P");
+        json_int(out, p);
+        json_lit(out, ") [");
+        json_ints(out, state->need[p], nr, ", ", "");
+        json_lit(out, "] \\u2264 Work [");
+        json_ints(out, before, nr, ", ", "");
+        json_lit(out, "]; allocate resources, then release \\u2192 Work = [");
+        json_ints(out, wl->work, nr, ", ", "");
+        json_lit(out, "]. Add P");
+        json_int(out, p);
+        json_lit(out, " to safe sequence.\"");
+        free(before);
+    } else if (status == STEP_DONE) {
+        json_lit(out, "{\"status\":\"done\",\"selected_process\":null,"
+                 "\"explanation\":\"All processes finished. Safe sequence: [");
+        json_ints(out, wl->sequence, wl->sequence_length, ", ", "P");
+        json_lit(out, "].\"");
+    } else {
+        int np = state->num_processes;
+        blocked = checked_malloc((size_t)np * sizeof(int));
+        for (int i = 0; i < np; i++) {
+            if (!wl->finish[i]) blocked[num_blocked++] = i;
+        }
+        json_lit(out, "{\"status\":\"deadlock\",\"selected_process\":null,"
+                 "\"explanation\":\"No process can be satisfied. Deadlocked processes: [");
+        json_ints(out, blocked, num_blocked, ", ", "P");
+        json_lit(out, "]. Work = [");
+        json_ints(out, wl->work, nr, ", ", "");
+        json_lit(out, "].\"");
+    }
+    json_lit(out, ",\"work\":[");
+    json_ints(out, wl->work, nr, ",", "");
+    json_lit(out, "],\"steps\":");
+    json_int(out, wl->sequence_length);
+    if (blocked) {
+        json_lit(out, ",\"deadlocked_processes\":[");
+        json_ints(out, blocked, num_blocked, ",", "");
+        json_char(out, ']');
+        free(blocked);
+    }
+    json_char(out, '}');
+}
@@ -0,0 +1,63 @@
+/*
+ * Deadlock Detection System
+ * JSON responses shared by api_worker and the Node native addon
+ */
+
+#ifndef API_COMMANDS_H
+#define API_COMMANDS_H
+
+#include "deadlock_detector.h"
+#include "json_writer.h"
+#include "step_iterator.h"
+
+// Each function writes one JSON value, without a trailing newline, in the
+// format of the matching api_worker command. State arguments have their
+// need matrix recalculated; RESOLVE also applies the termination.
+
+/**
+ * Detection result: is_deadlocked, deadlocked_processes, safe_sequence
+ */
+void api_detect_json(JsonWriter *out, const DetectionResult *res);
+
+/**
+ * RAG command: nodes, edges and cycles
+ */
+void api_rag(JsonWriter *out, SystemState *state);
+
+/**
+ * Victim used by RESOLVE: the deadlocked process holding the fewest units
+ * @param res Detection result with at least one deadlocked process
+ */
+int api_pick_victim(const SystemState *state, const DetectionResult *res);
+
+/**
+ * RESOLVE command: terminate a victim (-1 = fewest held units) and re-detect
+ */
+void api_resolve(JsonWriter *out, SystemState *state, int victim_override);
+
+/**
+ * PLAN command: every termination needed to end the deadlock (see planner.h)
+ * @param cost_model A CostModel value
+ * @param priorities One per process for COST_PRIORITY, otherwise unused
+ */
+void api_plan(JsonWriter *out, SystemState *state, int cost_model, int max_candidates,
+              const int *priorities);
+
+/**
+ * SIMULATE command: would granting amount of rj to pi keep the state safe
+ */
+void api_simulate(JsonWriter *out, SystemState *state, int pi, int rj, int amount);
+
+/**
+ * HEADROOM command: largest safe single grant for every (process, resource)
+ */
+void api_headroom(JsonWriter *out, SystemState *state);
+
+/**
+ * STEP command: run one step of a session and describe it as /api/detect/step
+ * does, with Work and the number of finished processes ("steps") in place
+ * of the full step_state
+ */
+void api_step(JsonWriter *out, StepIterator *it);
+
+#endif // API_COMMANDS_H
@@ -1,268 +1,1145 @@
 /*
  * Deadlock Detection System - API worker (non-interactive).
  * Reads a simple text protocol from stdin, outputs one JSON line to stdout.
- * Uses existing deadlock_detector and rag logic. Does not modify original .c files.
+ * Uses the deadlock_detector and rag logic.
  *
- * Protocol:
- *   Line 1: DETECT | RAG | RESOLVE | SIMULATE
+ * Protocol (one request per process, or one per frame with --serve):
+ *   Line 1: DETECT | RAG | RESOLVE | SIMULATE | HEADROOM | PLAN | HASH
  *   Line 2: num_processes num_resources
  *   Line 3: available[0] ... available[nr-1]
  *   Next num_processes lines: allocation[i][0] ... allocation[i][nr-1]
  *   Next num_processes lines: max_need[i][0] ... max_need[i][nr-1]
  *   RESOLVE: next line = victim_process_index (-1 for auto)
  *   SIMULATE: next line = process_index resource_index amount
+ *   PLAN: next line = cost_model max_candidates (see planner.h; cost_model
+ *     1 is followed by num_processes priorities)
+ *   HASH: answers {"hash":"<16 hex digits>"}, the state's key (state_hash.h)
+ *   Line breaks are not significant and '#' starts a comment. The state may
+ *   also use the labelled format of the test fixtures (see text_reader.h).
+ *   Parse errors give the line and column where the input went wrong.
+ *
+ * Step sessions (useful with --serve): STEP_START followed by a state as
+ *   above answers {"session":<sid>}, or {"error":...} for a state with
+ *   negative allocations. "STEP <sid>" runs the session's next step (see
+ *   api_step()); the session ends with the step that reports done or
+ *   deadlock. "STEP_END <sid>" ends it early and answers {"closed":<bool>}.
+ *   Sessions live in the worker process that started them and belong to
+ *   the stream (under --daemon, the connection) that started them: other
+ *   streams see them as unknown, and they end when it closes. A <sid> is
+ *   a table slot plus random bits, so it is found without a search and
+ *   cannot be guessed from another one.
+ *
+ * Batch detection: line 1 is BATCH_DETECT, line 2 is the number of states N,
+ *   followed by N states in the format of lines 2.. above. States are
+ *   detected in parallel on a pthread pool (one thread per online CPU) and
+ *   the response is a JSON array of N detect results in input order,
+ *   written as they complete. If a state cannot be parsed, its entry is
+ *   {"error":"<message>"} and the array ends there. Under --daemon, a state
+ *   whose detection runs out of memory gets {"error":"Out of memory."} and
+ *   the rest go on. If threads cannot be started, fewer run (or none, and
+ *   the parsing thread detects each state itself).
+ *
+ * Serve mode (api_worker --serve): the worker stays alive and reads frames
+ *   "<id> <length>\n" followed by <length> bytes holding one request in the
+ *   format above. Each frame is answered, in order, with one JSON line:
+ *   {"id":<id>,"result":<response>} or {"id":<id>,"error":"<message>"}.
+ *   Frames may be pipelined; the worker exits on EOF. A length that is
+ *   negative or over MAX_FRAME_BYTES is answered with an error and ends the
+ *   stream (under --daemon, only that connection).
+ *
+ * Threads (api_worker --threads N, with or without --serve): DETECT splits
+ *   one state's scan across N threads (see parallel_detect.h). The default
+ *   is 1, which keeps the sequential engine and its safe sequence order.
+ *
+ * Stats (api_worker --stats): each response also carries phase timings and
+ *   work counters (see stats.h). Serve text frames become
+ *   {"id":<id>,"stats":{...},"result":<response>}; a binary reply is
+ *   preceded by a WIRE_REPLY_STATS frame with the same id; a one-shot
+ *   request writes the stats object as one line on stderr. BATCH_DETECT
+ *   counts only parsing and emission (detection runs on pool threads).
+ *
+ * Domains (see domain_store.h): "PUT <domain>" followed by a state stores
+ *   it under that name; "UPDATE <domain> <count>" followed by <count>
+ *   replay events (<kind> <process> <resource> <amount>, see replay.h)
+ *   applies all of them or none; "DROP <domain>" removes it. Writes answer
+ *   {"domain":..,"version":N} or {"error":..}. Any state-taking command
+ *   accepts "@<domain>" in place of the state and reads the domain's latest
+ *   snapshot without locking. DETECT answers from the snapshot, whose safe
+ *   sequence is the writer's incremental witness (see incremental.h). The
+ *   other commands run on a copy and leave the domain unchanged. Text
+ *   framing only.
+ *
+ * Daemon mode (api_worker --daemon SOCKET): serve mode on every connection
+ *   to a Unix socket, one thread per connection, all sharing the domains.
+ *   A socket left at SOCKET by an earlier run is replaced; any other file
+ *   there is refused. Running out of memory answers the frame with
+ *   {"id":<id>,"error":"out of memory"} instead of ending the process (an
+ *   UPDATE that fails this way drops its domain); if the frame cannot be
+ *   answered cleanly, only its connection closes.
+ *
+ * Binary framing (see wire_protocol.h): a request starting with byte 0x7F
+ *   carries its dimensions in a fixed header and the matrices as
+ *   little-endian int32 arrays, and is answered with a binary frame. The
+ *   worker detects the framing per request in both modes.
  */
 
+#define _POSIX_C_SOURCE 200809L  /* write, fdopen */
+
+#include <errno.h>
+#include <signal.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdbool.h>
+#include <pthread.h>
+#include <setjmp.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
 #include "deadlock_detector.h"
-#include "rag.h"
+#include "api_commands.h"
+#include "domain_store.h"
+#include "json_writer.h"
+#include "parallel_detect.h"
+#include "planner.h"
+#include "state_hash.h"
+#include "stats.h"
+#include "step_iterator.h"
+#include "text_reader.h"
+#include "wire_protocol.h"
 
 #define MAX_LINE 2048
 #define CMD_DETECT   "DETECT"
 #define CMD_RAG      "RAG"
 #define CMD_RESOLVE  "RESOLVE"
 #define CMD_SIMULATE "SIMULATE"
+#define CMD_BATCH_DETECT "BATCH_DETECT"
+#define CMD_HEADROOM "HEADROOM"
+#define CMD_PLAN     "PLAN"
+#define CMD_STEP_START "STEP_START"
+#define CMD_STEP     "STEP"
+#define CMD_STEP_END "STEP_END"
+#define CMD_HASH     "HASH"
+#define CMD_PUT      "PUT"
+#define CMD_UPDATE   "UPDATE"
+#define CMD_DROP     "DROP"
+
+#define MAX_BATCH_STATES 1000000
+#define BATCH_SLOTS_PER_THREAD 4   /* states parsed ahead of the oldest unwritten one */
+#define STEP_SLOT_BITS 12
+#define MAX_STEP_SESSIONS (1 << STEP_SLOT_BITS)
+#define MAX_DOMAIN_EVENTS 1000000
+#define MAX_FRAME_BYTES (1LL << 30)  /* text frame payload; larger frames close the stream */
+
+static int detect_threads = 1;     /* --threads: threads per DETECT */
+
+typedef struct {
+    char cmd[32];
+    SystemState state;
+    int args[3];
+    int num_args;
+    int *priorities;    /* PLAN with COST_PRIORITY: one per process */
+    bool binary;        /* arrived as a binary frame; answer in kind */
+    char domain[DOMAIN_NAME_LEN];  /* "@name" instead of a state, or PUT/UPDATE/DROP */
+    ReplayEvent *events;           /* UPDATE: args[0] events */
+} Request;
+
+/* Named states shared by every connection (see domain_store.h) */
+static DomainStore domains;
+
+/* --daemon: where an allocation failure leaves to on this thread (see
+ * daemon_out_of_memory()), and what it must let go of on the way */
+static __thread jmp_buf *oom_escape;
+static __thread int stepping = -1;  /* step session slot cmd_step() runs under step_lock */
+static __thread int reading = -1;   /* domain reader slot inside a read */
+
+static void free_request(Request *req) {
+    free_system_state(&req->state);
+    free(req->priorities);
+    free(req->events);
+    req->priorities = NULL;
+    req->events = NULL;
+}
+
+/* Read a domain name, with or without its '@' */
+static const char *read_domain_name(TextReader *in, Request *req) {
+    char word[DOMAIN_NAME_LEN + 1];
+    if (!text_read_word(in, word, sizeof(word))) return text_reader_error(in, "missing domain");
+    const char *name = word[0] == '@' ? word + 1 : word;
+    if (!domain_name_valid(name)) return text_reader_error(in, "invalid domain name");
+    strcpy(req->domain, name);
+    return NULL;
+}
+
+/* PUT <domain> <state> | UPDATE <domain> <count> <events> | DROP <domain> */
+static const char *read_domain_request(TextReader *in, Request *req) {
+    const char *err = read_domain_name(in, req);
+    if (err) return err;
+    if (strcmp(req->cmd, CMD_PUT) == 0) return text_read_state(in, &req->state);
+    if (strcmp(req->cmd, CMD_DROP) == 0) return NULL;
 
-static void read_state(SystemState *state) {
-    int np, nr;
-    if (scanf("%d %d", &np, &nr) != 2 || np < 1 || nr < 1 ||
-        np > MAX_PROCESSES || nr > MAX_RESOURCES) {
-        fprintf(stderr, "invalid dimensions\n");
-        exit(1);
+    int count;
+    if (!text_read_int(in, &count) || count < 0 || count > MAX_DOMAIN_EVENTS) {
+        return text_reader_error(in, "invalid event count");
     }
-    state->num_processes = np;
-    state->num_resources = nr;
+    req->args[0] = count;
+    req->num_args = 1;
+    req->events = malloc(((size_t)count + 1) * sizeof(ReplayEvent));
+    if (!req->events) return "out of memory";
+    for (int k = 0; k < count; k++) {
+        ReplayEvent *event = &req->events[k];
+        char word[16];
+        if (!text_read_word(in, word, sizeof(word)) ||
+            !event_kind_parse(word, strlen(word), &event->kind)) {
+            return text_reader_error(in, "expected alloc, release, request or max");
+        }
+        if (!text_read_int(in, &event->process) || !text_read_int(in, &event->resource) ||
+            !text_read_int(in, &event->amount)) {
+            return text_reader_error(in, "expected <event> <process> <resource> <amount>");
+        }
+    }
+    return NULL;
+}
 
-    for (int j = 0; j < nr; j++) {
-        if (scanf("%d", &state->available[j]) != 1) exit(1);
+/* Read command, state and trailing arguments; returns an error message or NULL. */
+static const char *read_request(TextReader *in, Request *req) {
+    memset(req, 0, sizeof(*req));
+    if (!text_read_word(in, req->cmd, sizeof(req->cmd))) {
+        return "missing command";
     }
-    for (int i = 0; i < np; i++) {
-        for (int j = 0; j < nr; j++) {
-            if (scanf("%d", &state->allocation[i][j]) != 1) exit(1);
+    if (strcmp(req->cmd, CMD_BATCH_DETECT) == 0) {
+        // The states are read while the batch runs, see run_batch_detect()
+        if (!text_read_int(in, &req->args[0]) ||
+            req->args[0] < 0 || req->args[0] > MAX_BATCH_STATES) {
+            return text_reader_error(in, "invalid batch size");
         }
+        req->num_args = 1;
+        return NULL;
+    }
+    if (strcmp(req->cmd, CMD_STEP) == 0 || strcmp(req->cmd, CMD_STEP_END) == 0) {
+        if (!text_read_int(in, &req->args[0])) return text_reader_error(in, "missing session");
+        req->num_args = 1;
+        return NULL;
+    }
+    if (strcmp(req->cmd, CMD_PUT) == 0 || strcmp(req->cmd, CMD_UPDATE) == 0 ||
+        strcmp(req->cmd, CMD_DROP) == 0) {
+        return read_domain_request(in, req);
     }
-    for (int i = 0; i < np; i++) {
-        for (int j = 0; j < nr; j++) {
-            if (scanf("%d", &state->max_need[i][j]) != 1) exit(1);
+    // "@name" in place of the state reads that domain's latest snapshot
+    const char *err = text_peek(in) == '@' ? read_domain_name(in, req)
+                                           : text_read_state(in, &req->state);
+    if (err) return err;
+
+    int want = 0;
+    if (strcmp(req->cmd, CMD_RESOLVE) == 0) want = 1;
+    else if (strcmp(req->cmd, CMD_SIMULATE) == 0) want = 3;
+    else if (strcmp(req->cmd, CMD_PLAN) == 0) want = 2;
+    else if (strcmp(req->cmd, CMD_DETECT) != 0 && strcmp(req->cmd, CMD_RAG) != 0 &&
+             strcmp(req->cmd, CMD_HEADROOM) != 0 && strcmp(req->cmd, CMD_STEP_START) != 0 &&
+             strcmp(req->cmd, CMD_HASH) != 0)
+        return "unknown command";
+
+    while (req->num_args < want && text_read_int(in, &req->args[req->num_args])) {
+        req->num_args++;
+    }
+    if (want == 2 && req->num_args == 2 && req->args[0] == COST_PRIORITY) {
+        if (req->domain[0]) return "priorities need an inline state";
+        int np = req->state.num_processes;
+        req->priorities = malloc(((size_t)np + 1) * sizeof(int));
+        if (!req->priorities) return "out of memory";
+        for (int i = 0; i < np; i++) {
+            if (!text_read_int(in, &req->priorities[i])) {
+                return text_reader_error(in, "truncated priorities");
+            }
         }
     }
+    return NULL;
 }
 
-/* Print detection result as JSON fragment (no newline; for embedding). */
-static void output_detect_inline(const DetectionResult *res) {
-    printf("{\"is_deadlocked\":%s,\"deadlocked_processes\":[",
-           res->is_deadlocked ? "true" : "false");
-    for (int i = 0; i < res->num_deadlocked; i++) {
-        if (i) printf(",");
-        printf("%d", res->deadlocked_processes[i]);
-    }
-    printf("],\"safe_sequence\":[");
-    for (int i = 0; i < res->safe_sequence_length; i++) {
-        if (i) printf(",");
-        printf("%d", res->safe_sequence[i]);
-    }
-    printf("],\"safe_sequence_length\":%d}", res->safe_sequence_length);
-}
-
-/* Print detection result as full JSON line (with newline). */
-static void output_detect(const DetectionResult *res) {
-    output_detect_inline(res);
-    printf("\n");
-}
-
-static void cmd_detect(SystemState *state) {
-    (void)state;
-    calculate_need_matrix(state);
-    DetectionResult res = detect_deadlock(state);
-    output_detect(&res);
-}
-
-static void cmd_rag(SystemState *state) {
-    calculate_need_matrix(state);
-    RAG rag;
-    build_rag(state, &rag);
-
-    printf("{\"nodes\":[");
-    int first = 1;
-    for (int i = 0; i < state->num_processes; i++) {
-        if (!first) printf(",");
-        printf("{\"id\":%d,\"label\":\"P%d\",\"type\":\"process\"}", i, i);
-        first = 0;
-    }
-    for (int j = 0; j < state->num_resources; j++) {
-        if (!first) printf(",");
-        printf("{\"id\":%d,\"label\":\"R%d\",\"type\":\"resource\"}",
-               state->num_processes + j, j);
-        first = 0;
-    }
-    printf("],\"edges\":[");
-    first = 1;
-    for (int e = 0; e < rag.num_edges; e++) {
-        if (!first) printf(",");
-        printf("{\"from\":%d,\"to\":%d,\"type\":\"%s\"}",
-               rag.edges[e].from, rag.edges[e].to,
-               rag.edges[e].type == REQUEST ? "request" : "assignment");
-        first = 0;
-    }
-    printf("]}\n");
-}
-
-static int pick_victim(const SystemState *state, const DetectionResult *res) {
-    int victim = res->deadlocked_processes[0];
-    int min_total = 0;
-    for (int j = 0; j < state->num_resources; j++)
-        min_total += state->allocation[victim][j];
-
-    for (int i = 1; i < res->num_deadlocked; i++) {
-        int p = res->deadlocked_processes[i];
-        int total = 0;
-        for (int j = 0; j < state->num_resources; j++)
-            total += state->allocation[p][j];
-        if (total < min_total) {
-            min_total = total;
-            victim = p;
-        }
+static void cmd_detect(JsonWriter *out, SystemState *state, bool binary) {
+    DetectionResult res;
+    init_detection_result(&res);
+    detect_deadlock_parallel(state, &res, detect_threads);
+    if (binary) {
+        wire_write_detect(out, &res);
+    } else {
+        api_detect_json(out, &res);
     }
-    return victim;
+    free_detection_result(&res);
 }
 
-static void apply_victim(SystemState *state, int victim) {
-    for (int j = 0; j < state->num_resources; j++) {
-        state->available[j] += state->allocation[victim][j];
-        state->allocation[victim][j] = 0;
-        state->max_need[victim][j] = 0;
+/* Step sessions of this worker, one per slot. A session id is the slot
+ * in its low STEP_SLOT_BITS and random bits above, so a lookup is one
+ * index and an id does not tell which other ids are live. */
+typedef struct {
+    int id;                     /* 0 while the slot is free */
+    unsigned long stream;       /* serve() stream that started it */
+    StepIterator *it;
+} StepSession;
+
+static StepSession step_sessions[MAX_STEP_SESSIONS];
+static int free_step_slots[MAX_STEP_SESSIONS];
+static int num_free_step_slots = -1;    /* -1 until the free list is built */
+static FILE *step_random;               /* /dev/urandom, NULL if unavailable */
+static unsigned step_counter;           /* tag source without /dev/urandom */
+static pthread_mutex_t step_lock = PTHREAD_MUTEX_INITIALIZER;  /* --daemon connections share the table */
+static unsigned long num_streams;       /* serve() streams started, under step_lock */
+static __thread unsigned long current_stream;  /* this thread's serve() stream, 0 outside one */
+
+/* The live session `id` of the calling stream, or -1 */
+static int find_step_session(int id) {
+    int slot = id & (MAX_STEP_SESSIONS - 1);
+    if (id <= 0 || step_sessions[slot].id != id ||
+        step_sessions[slot].stream != current_stream) {
+        return -1;
     }
+    return slot;
 }
 
-static void output_state(const SystemState *state) {
-    printf("\"num_processes\":%d,\"num_resources\":%d,\"available\":[",
-           state->num_processes, state->num_resources);
-    for (int j = 0; j < state->num_resources; j++) {
-        if (j) printf(",");
-        printf("%d", state->available[j]);
+static void end_step_session(int slot) {
+    step_iterator_free(step_sessions[slot].it);
+    free(step_sessions[slot].it);
+    step_sessions[slot].id = 0;
+    step_sessions[slot].it = NULL;
+    free_step_slots[num_free_step_slots++] = slot;
+}
+
+/* Random non-zero bits above the slot (31-bit ids, as the wire args are int32) */
+static int step_session_tag(void) {
+    unsigned bits = 0;
+    if (!step_random || fread(&bits, sizeof(bits), 1, step_random) != 1) {
+        bits = ++step_counter * 2654435761u;
     }
-    printf("],\"allocation\":[");
-    for (int i = 0; i < state->num_processes; i++) {
-        if (i) printf(",");
-        printf("[");
-        for (int j = 0; j < state->num_resources; j++) {
-            if (j) printf(",");
-            printf("%d", state->allocation[i][j]);
-        }
-        printf("]");
-    }
-    printf("],\"max_need\":[");
-    for (int i = 0; i < state->num_processes; i++) {
-        if (i) printf(",");
-        printf("[");
-        for (int j = 0; j < state->num_resources; j++) {
-            if (j) printf(",");
-            printf("%d", state->max_need[i][j]);
+    bits &= (1u << (31 - STEP_SLOT_BITS)) - 1;
+    return (int)(bits ? bits : 1) << STEP_SLOT_BITS;
+}
+
+/* serve() start and end: give the stream an owner tag; end what it left */
+static void step_stream_begin(void) {
+    pthread_mutex_lock(&step_lock);
+    current_stream = ++num_streams;
+    pthread_mutex_unlock(&step_lock);
+}
+
+static void step_stream_end(void) {
+    pthread_mutex_lock(&step_lock);
+    for (int slot = 0; slot < MAX_STEP_SESSIONS && num_free_step_slots >= 0; slot++) {
+        if (step_sessions[slot].id && step_sessions[slot].stream == current_stream) {
+            end_step_session(slot);
         }
-        printf("]");
     }
-    printf("]");
+    pthread_mutex_unlock(&step_lock);
+    current_stream = 0;
 }
 
-static void cmd_resolve(SystemState *state, int victim_override) {
-    calculate_need_matrix(state);
-    DetectionResult res = detect_deadlock(state);
-    if (!res.is_deadlocked || res.num_deadlocked == 0) {
-        printf("{\"error\":\"State is not deadlocked; resolution not applicable.\"}\n");
+/* STEP_START: the session takes over the request's state */
+static void cmd_step_start(JsonWriter *out, SystemState *state) {
+    StepIterator *it = malloc(sizeof(StepIterator));
+    if (!it) {
+        json_lit(out, "{\"error\":\"Out of memory.\"}");
+        return;
+    }
+    if (!step_iterator_init(it, state)) {
+        step_iterator_free(it);
+        free(it);
+        json_lit(out, "{\"error\":\"Step sessions need non-negative allocations.\"}");
+        return;
+    }
+    pthread_mutex_lock(&step_lock);
+    if (num_free_step_slots < 0) {
+        for (int k = 0; k < MAX_STEP_SESSIONS; k++) {
+            free_step_slots[k] = MAX_STEP_SESSIONS - 1 - k;
+        }
+        num_free_step_slots = MAX_STEP_SESSIONS;
+        step_random = fopen("/dev/urandom", "rb");
+    }
+    if (num_free_step_slots == 0) {
+        pthread_mutex_unlock(&step_lock);
+        step_iterator_free(it);
+        free(it);
+        json_lit(out, "{\"error\":\"Too many step sessions.\"}");
         return;
     }
-    int victim = victim_override;
-    if (victim < 0) {
-        victim = pick_victim(state, &res);
+    int slot = free_step_slots[--num_free_step_slots];
+    int id = step_session_tag() | slot;
+    step_sessions[slot].id = id;
+    step_sessions[slot].stream = current_stream;
+    step_sessions[slot].it = it;
+    pthread_mutex_unlock(&step_lock);
+    json_lit(out, "{\"session\":");
+    json_int(out, id);
+    json_char(out, '}');
+}
+
+static void cmd_step(JsonWriter *out, int id) {
+    pthread_mutex_lock(&step_lock);
+    int slot = find_step_session(id);
+    if (slot < 0) {
+        json_lit(out, "{\"error\":\"Unknown step session.\"}");
+    } else {
+        stepping = slot;
+        api_step(out, step_sessions[slot].it);
+        stepping = -1;
+        if (step_sessions[slot].it->status != STEP_FOUND) end_step_session(slot);
+    }
+    pthread_mutex_unlock(&step_lock);
+}
+
+static void cmd_step_end(JsonWriter *out, int id) {
+    pthread_mutex_lock(&step_lock);
+    int k = find_step_session(id);
+    if (k >= 0) end_step_session(k);
+    pthread_mutex_unlock(&step_lock);
+    if (k >= 0) {
+        json_lit(out, "{\"closed\":true}");
+    } else {
+        json_lit(out, "{\"closed\":false}");
+    }
+}
+
+/* Where a request's states come from: text stream or binary frame payload */
+typedef struct {
+    TextReader *text;
+    WireReader *wire;
+} StateSource;
+
+static const char *next_state(StateSource *src, SystemState *state) {
+    if (src->text) {
+        return text_read_state(src->text, state);
+    }
+    int dims[2];
+    if (!wire_read_ints(src->wire, dims, 2)) {
+        return "truncated state";
+    }
+    return wire_read_state(src->wire, dims[0], dims[1], state);
+}
+
+/*
+ * BATCH_DETECT: the calling thread parses states into a ring of slots and
+ * writes finished results in input order; pool threads run the detections.
+ * At most `window` states are held at once, so memory stays bounded however
+ * long the batch is.
+ */
+typedef struct {
+    SystemState state;
+    const char *error;      /* reported instead of a result */
+    JsonWriter output;      /* encoded entry, written by a pool thread */
+    bool done;
+} BatchSlot;
+
+typedef struct {
+    BatchSlot *slots;
+    int window;
+    bool binary;            /* packed records instead of a JSON array */
+    JsonWriter *out;
+    int parsed;             /* slots filled so far (absolute index) */
+    int taken;              /* slots handed to pool threads */
+    int emitted;            /* slots written to out */
+    bool closed;            /* no more states will be parsed */
+    DetectionResult inline_result;  /* the calling thread's, if no pool thread started */
+    pthread_mutex_t lock;
+    pthread_cond_t job_ready;
+    pthread_cond_t slot_done;
+} Batch;
+
+/* Detect one slot's state into its output. Under --daemon, running out of
+ * memory turns the entry into an error instead of ending the process. */
+static void batch_run_slot(Batch *b, BatchSlot *slot, DetectionResult *res) {
+    if (slot->error) return;
+    JsonWriter *out = &slot->output;
+    json_init(out, -1);
+    jmp_buf *outer = oom_escape;
+    jmp_buf escape;
+    oom_escape = &escape;
+    if (setjmp(escape)) {
+        json_free(out);
+        free_detection_result(res);
+        slot->error = "Out of memory.";
     } else {
-        bool ok = false;
-        for (int i = 0; i < res.num_deadlocked; i++) {
-            if (res.deadlocked_processes[i] == victim) { ok = true; break; }
+        detect_deadlock(&slot->state, res);
+        if (b->binary) wire_write_detect(out, res);
+        else api_detect_json(out, res);
+    }
+    oom_escape = outer;
+}
+
+/* Run the oldest state no thread has taken; lock held, released meanwhile */
+static void batch_run_next(Batch *b, DetectionResult *res) {
+    BatchSlot *slot = &b->slots[b->taken++ % b->window];
+    pthread_mutex_unlock(&b->lock);
+    batch_run_slot(b, slot, res);
+    pthread_mutex_lock(&b->lock);
+    slot->done = true;
+    pthread_cond_broadcast(&b->slot_done);
+}
+
+static void *batch_thread(void *arg) {
+    Batch *b = arg;
+    DetectionResult res;
+    init_detection_result(&res);
+    pthread_mutex_lock(&b->lock);
+    for (;;) {
+        while (b->taken == b->parsed && !b->closed) {
+            pthread_cond_wait(&b->job_ready, &b->lock);
         }
-        if (!ok || victim < 0 || victim >= state->num_processes) {
-            printf("{\"error\":\"Invalid or non-deadlocked victim_process_index.\"}\n");
-            return;
+        if (b->taken == b->parsed) break;
+        batch_run_next(b, &res);
+    }
+    pthread_mutex_unlock(&b->lock);
+    free_detection_result(&res);
+    return NULL;
+}
+
+/* Write finished slots in order until at least `until` are out; lock held.
+ * The lock is released around every write, so this thread never
+ * allocates while holding it. */
+static void batch_emit(Batch *b, int until) {
+    while (b->emitted < b->parsed) {
+        BatchSlot *slot = &b->slots[b->emitted % b->window];
+        if (!slot->done) {
+            if (b->emitted >= until) return;
+            pthread_cond_wait(&b->slot_done, &b->lock);
+            continue;
+        }
+        pthread_mutex_unlock(&b->lock);
+        if (b->emitted > 0 && !b->binary) json_char(b->out, ',');
+        if (!slot->error) {
+            json_raw(b->out, slot->output.data, slot->output.length);
+        } else if (b->binary) {
+            wire_write_detect_error(b->out);
+        } else {
+            json_lit(b->out, "{\"error\":\"");
+            json_str(b->out, slot->error);
+            json_lit(b->out, "\"}");
         }
+        json_drain(b->out);
+        json_free(&slot->output);
+        free_system_state(&slot->state);
+        memset(slot, 0, sizeof(*slot));
+        pthread_mutex_lock(&b->lock);
+        b->emitted++;
+    }
+}
+
+/* Stop the pool and release the batch, including slots never written out
+ * (a batch cut short); lock not held */
+static void batch_finish(Batch *b, pthread_t *pool, int started) {
+    pthread_mutex_lock(&b->lock);
+    b->closed = true;
+    pthread_cond_broadcast(&b->job_ready);
+    pthread_mutex_unlock(&b->lock);
+    for (int t = 0; t < started; t++) {
+        pthread_join(pool[t], NULL);
+    }
+    for (int k = 0; k < b->window; k++) {
+        json_free(&b->slots[k].output);
+        free_system_state(&b->slots[k].state);
+    }
+    free(pool);
+    free(b->slots);
+    free_detection_result(&b->inline_result);
+    pthread_mutex_destroy(&b->lock);
+    pthread_cond_destroy(&b->job_ready);
+    pthread_cond_destroy(&b->slot_done);
+    free(b);
+}
+
+static void run_batch_detect(JsonWriter *out, StateSource *src, int count, bool binary) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    int threads = cpus < 1 ? 1 : (int)cpus;
+    if (threads > count) threads = count;
+
+    Batch *b = checked_calloc(1, sizeof(Batch));
+    b->window = threads * BATCH_SLOTS_PER_THREAD;
+    if (b->window < 1) b->window = 1;
+    b->binary = binary;
+    b->out = out;
+    b->slots = checked_calloc((size_t)b->window, sizeof(BatchSlot));
+    pthread_mutex_init(&b->lock, NULL);
+    pthread_cond_init(&b->job_ready, NULL);
+    pthread_cond_init(&b->slot_done, NULL);
+
+    // If a thread cannot be started, the ones that were share the states;
+    // with none, this thread detects each state after parsing it
+    pthread_t *pool = checked_malloc(((size_t)threads + 1) * sizeof(pthread_t));
+    int started = 0;
+    while (started < threads && pthread_create(&pool[started], NULL, batch_thread, b) == 0) {
+        started++;
+    }
+
+    // Under --daemon, running out of memory here must not leave the pool
+    // running on a batch that is gone: stop it, then fail the request
+    jmp_buf *outer = oom_escape;
+    jmp_buf escape;
+    oom_escape = &escape;
+    if (setjmp(escape)) {
+        oom_escape = outer;
+        batch_finish(b, pool, started);
+        out_of_memory();
     }
-    apply_victim(state, victim);
-    DetectionResult new_res = detect_deadlock(state);
 
-    printf("{\"state\":{");
-    output_state(state);
-    printf("},\"result\":");
-    output_detect_inline(&new_res);
-    printf(",\"victim_process\":%d}\n", victim);
+    if (!binary) json_char(out, '[');
+    pthread_mutex_lock(&b->lock);
+    for (int k = 0; k < count; k++) {
+        // Wait for the oldest slot to be written before reusing it
+        if (b->parsed - b->emitted == b->window) batch_emit(b, b->emitted + 1);
+        BatchSlot *slot = &b->slots[k % b->window];
+        pthread_mutex_unlock(&b->lock);
+        const char *err = next_state(src, &slot->state);
+        slot->error = err;
+        pthread_mutex_lock(&b->lock);
+
+        b->parsed++;
+        pthread_cond_signal(&b->job_ready);
+        if (started == 0) batch_run_next(b, &b->inline_result);
+        // A bad state leaves the rest of the input unaligned; stop here
+        if (err) break;
+        batch_emit(b, b->emitted);
+    }
+    b->closed = true;
+    pthread_cond_broadcast(&b->job_ready);
+    batch_emit(b, b->parsed);
+    pthread_mutex_unlock(&b->lock);
+    if (!binary) json_char(out, ']');
+    oom_escape = outer;
+    batch_finish(b, pool, started);
 }
 
-static void cmd_simulate(SystemState *state, int pi, int rj, int amount) {
-    if (amount <= 0 || pi < 0 || pi >= state->num_processes ||
-        rj < 0 || rj >= state->num_resources) {
-        printf("{\"granted\":false,\"is_safe\":false,\"message\":\"Invalid process_index, resource_index, or amount.\"}\n");
+/* PUT / UPDATE / DROP: publish a new snapshot of the domain (or none) */
+static void cmd_domain_write(JsonWriter *out, Request *req) {
+    long version = 0;
+    int rejected = 0;
+    DomainStatus status;
+    if (strcmp(req->cmd, CMD_DROP) == 0) {
+        json_lit(out, "{\"dropped\":");
+        json_str(out, domain_drop(&domains, req->domain) ? "true}" : "false}");
         return;
     }
-    if ((unsigned)amount > (unsigned)state->available[rj]) {
-        printf("{\"granted\":false,\"is_safe\":false,\"message\":\"Request exceeds available resources.\"}\n");
+    if (strcmp(req->cmd, CMD_PUT) == 0) {
+        status = domain_put(&domains, req->domain, &req->state, &version);
+    } else {
+        status = domain_update(&domains, req->domain, req->events, req->args[0], &version,
+                               &rejected);
+    }
+    switch (status) {
+        case DOMAIN_OK:
+            json_lit(out, "{\"domain\":\"");
+            json_str(out, req->domain);
+            json_lit(out, "\",\"version\":");
+            json_ll(out, version);
+            json_char(out, '}');
+            break;
+        case DOMAIN_UNKNOWN:
+            json_lit(out, "{\"error\":\"Unknown domain.\"}");
+            break;
+        case DOMAIN_REJECTED:
+            json_lit(out, "{\"error\":\"Event does not fit the current state.\",\"event\":");
+            json_int(out, rejected);
+            json_char(out, '}');
+            break;
+        default:
+            json_lit(out, "{\"error\":\"Out of memory.\"}");
+    }
+}
+
+/* A request naming a domain reads its latest snapshot without locking.
+ * DETECT and HASH answer from the snapshot itself; the other commands
+ * modify their state, so they get a copy. Returns true when req->state
+ * holds that copy and the command still has to run. */
+static bool read_domain(Request *req, JsonWriter *out, int reader) {
+    if (reader < 0) {
+        json_lit(out, "{\"error\":\"Too many connections.\"}");
+        return false;
+    }
+    const DomainSnapshot *snapshot = domain_read_begin(&domains, reader, req->domain);
+    reading = reader;
+    bool copied = false;
+    if (!snapshot) {
+        json_lit(out, "{\"error\":\"Unknown domain.\"}");
+    } else if (strcmp(req->cmd, CMD_DETECT) == 0) {
+        api_detect_json(out, &snapshot->result);
+    } else if (strcmp(req->cmd, CMD_HASH) == 0) {
+        json_lit(out, "{\"hash\":\"");
+        json_hex64(out, snapshot->hash);
+        json_lit(out, "\"}");
+    } else if (!(copied = domain_snapshot_copy(snapshot, &req->state))) {
+        json_lit(out, "{\"error\":\"Out of memory.\"}");
+    }
+    reading = -1;
+    domain_read_end(&domains, reader);
+    return copied;
+}
+
+/* Run a parsed request, writing one response value (JSON without newline,
+ * or for binary DETECT / BATCH_DETECT the packed payload) to `out`.
+ * BATCH_DETECT reads its states from `src` as it goes. `reader` is the
+ * calling thread's domain reader slot. */
+static void execute_request(Request *req, StateSource *src, JsonWriter *out, int reader) {
+    if (strcmp(req->cmd, CMD_PUT) == 0 || strcmp(req->cmd, CMD_UPDATE) == 0 ||
+        strcmp(req->cmd, CMD_DROP) == 0) {
+        cmd_domain_write(out, req);
         return;
     }
-    calculate_need_matrix(state);
-    int need_val = state->need[pi][rj];
-    if (amount > need_val) {
-        printf("{\"granted\":false,\"is_safe\":false,\"message\":\"Request exceeds remaining need.\"}\n");
+    if (req->domain[0] && !read_domain(req, out, reader)) {
         return;
     }
-    state->available[rj] -= amount;
-    state->allocation[pi][rj] += amount;
-    calculate_need_matrix(state);
-    DetectionResult res = detect_deadlock(state);
-    state->available[rj] += amount;
-    state->allocation[pi][rj] -= amount;
+    if (strcmp(req->cmd, CMD_BATCH_DETECT) == 0) {
+        run_batch_detect(out, src, req->args[0], req->binary);
+    } else if (strcmp(req->cmd, CMD_DETECT) == 0) {
+        cmd_detect(out, &req->state, req->binary);
+    } else if (strcmp(req->cmd, CMD_RAG) == 0) {
+        api_rag(out, &req->state);
+    } else if (strcmp(req->cmd, CMD_RESOLVE) == 0) {
+        api_resolve(out, &req->state, req->num_args == 1 ? req->args[0] : -1);
+    } else if (strcmp(req->cmd, CMD_SIMULATE) == 0) {
+        if (req->num_args != 3) {
+            json_lit(out, "{\"granted\":false,\"is_safe\":false,\"message\":\"Missing process_index resource_index amount.\"}");
+            return;
+        }
+        api_simulate(out, &req->state, req->args[0], req->args[1], req->args[2]);
+    } else if (strcmp(req->cmd, CMD_HEADROOM) == 0) {
+        api_headroom(out, &req->state);
+    } else if (strcmp(req->cmd, CMD_PLAN) == 0) {
+        if (req->num_args != 2) {
+            json_lit(out, "{\"error\":\"Missing cost_model max_candidates.\"}");
+            return;
+        }
+        api_plan(out, &req->state, req->args[0], req->args[1], req->priorities);
+    } else if (strcmp(req->cmd, CMD_HASH) == 0) {
+        json_lit(out, "{\"hash\":\"");
+        json_hex64(out, state_hash(&req->state));
+        json_lit(out, "\"}");
+    } else if (strcmp(req->cmd, CMD_STEP_START) == 0) {
+        cmd_step_start(out, &req->state);
+    } else if (strcmp(req->cmd, CMD_STEP) == 0) {
+        cmd_step(out, req->args[0]);
+    } else if (strcmp(req->cmd, CMD_STEP_END) == 0) {
+        cmd_step_end(out, req->args[0]);
+    }
+}
+
+/* execute_request(), except that under --daemon running out of memory
+ * fails only this request: false, with `out` partly written (and what the
+ * failed call had allocated leaked) */
+static bool execute_guarded(Request *req, StateSource *src, JsonWriter *out, int reader) {
+    jmp_buf *outer = oom_escape;
+    jmp_buf escape;
+    oom_escape = &escape;
+    if (setjmp(escape)) {
+        oom_escape = outer;
+        return false;
+    }
+    execute_request(req, src, out, reader);
+    oom_escape = outer;
+    return true;
+}
+
+/* Decode a binary request header and (except for a batch) its state. */
+static const char *read_binary_request(const WireRequestHeader *header, WireReader *reader,
+                                       Request *req) {
+    static const char *const names[] = {
+        NULL, CMD_DETECT, CMD_RAG, CMD_RESOLVE, CMD_SIMULATE, CMD_BATCH_DETECT, CMD_HEADROOM,
+        CMD_PLAN, CMD_STEP_START, CMD_STEP, CMD_STEP_END, CMD_HASH
+    };
+    memset(req, 0, sizeof(*req));
+    req->binary = true;
+    if (header->command < WIRE_CMD_DETECT || header->command > WIRE_CMD_HASH) {
+        return "unknown command";
+    }
+    strcpy(req->cmd, names[header->command]);
+
+    if (header->command == WIRE_CMD_BATCH_DETECT) {
+        if (header->args[0] < 0 || header->args[0] > MAX_BATCH_STATES) {
+            return "invalid batch size";
+        }
+        req->args[0] = header->args[0];
+        req->num_args = 1;
+        return NULL;
+    }
+    if (header->command == WIRE_CMD_STEP || header->command == WIRE_CMD_STEP_END) {
+        req->args[0] = header->args[0];
+        req->num_args = 1;
+        return NULL;
+    }
+    req->num_args = header->command == WIRE_CMD_RESOLVE ? 1 :
+                    header->command == WIRE_CMD_SIMULATE ? 3 :
+                    header->command == WIRE_CMD_PLAN ? 2 : 0;
+    memcpy(req->args, header->args, sizeof(req->args));
+    const char *err = wire_read_state(reader, header->num_processes, header->num_resources,
+                                      &req->state);
+    if (!err && header->command == WIRE_CMD_PLAN && req->args[0] == COST_PRIORITY) {
+        size_t np = (size_t)req->state.num_processes;
+        req->priorities = malloc((np + 1) * sizeof(int));
+        if (!req->priorities) err = "out of memory";
+        else if (!wire_read_ints(reader, req->priorities, np)) err = "truncated priorities";
+    }
+    return err;
+}
 
-    bool safe = !res.is_deadlocked;
-    if (safe) {
-        printf("{\"granted\":true,\"is_safe\":true,\"message\":\"Granting would keep the system safe.\"}\n");
+/* Answer one binary frame whose marker byte was consumed, appending the
+ * reply frames to `out`; false if the stream is unusable (bad magic or EOF
+ * inside the frame). */
+static bool answer_binary_frame(FILE *in, JsonWriter *out) {
+    WireRequestHeader header;
+    if (!wire_read_request_header(in, &header)) {
+        fprintf(stderr, "malformed binary frame header\n");
+        return false;
+    }
+    WireReader reader = { in, header.length, false };
+    Request req;
+    StateSource src = { NULL, &reader };
+    stats_reset();
+    STATS_START(parse);
+    const char *err = read_binary_request(&header, &reader, &req);
+    STATS_STOP(STAT_PARSE, parse);
+
+    // The frame header carries the payload length, so the payload is built first
+    JsonWriter payload;
+    json_init(&payload, -1);
+    if (!err) {
+        long long start = stats_now_ns();
+        if (!execute_guarded(&req, &src, &payload, -1)) {
+            json_reset(&payload);
+            err = "out of memory";
+        }
+        stats_finish(stats_now_ns() - start);
+    }
+    wire_skip(&reader);
+    free_request(&req);
+    if (reader.eof) {
+        fprintf(stderr, "truncated frame %u\n", (unsigned)header.id);
+        json_free(&payload);
+        return false;
+    }
+
+    if (err) {
+        wire_write_reply(out, header.id, WIRE_REPLY_ERROR, err, strlen(err));
     } else {
-        printf("{\"granted\":false,\"is_safe\":false,\"message\":\"Granting would lead to unsafe state.\"}\n");
+        if (stats_enabled) {
+            JsonWriter json;
+            json_init(&json, -1);
+            stats_write_json(&json);
+            wire_write_reply(out, header.id, WIRE_REPLY_STATS, json.data, json.length);
+            json_free(&json);
+        }
+        WireReplyKind kind = WIRE_REPLY_JSON;
+        if (header.command == WIRE_CMD_DETECT) kind = WIRE_REPLY_DETECT;
+        else if (header.command == WIRE_CMD_BATCH_DETECT) kind = WIRE_REPLY_BATCH;
+        wire_write_reply(out, header.id, kind, payload.data, payload.length);
     }
+    json_free(&payload);
+    return true;
 }
 
-int main(void) {
-    char cmd[32];
-    if (scanf("%31s", cmd) != 1) {
-        fprintf(stderr, "missing command\n");
-        return 1;
+/* Discard `len` bytes of a frame that could not be buffered; returns the
+ * number skipped (short at EOF) */
+static size_t skip_bytes(FILE *input, long long len) {
+    char chunk[4096];
+    size_t skipped = 0;
+    while ((long long)skipped < len) {
+        size_t want = len - (long long)skipped < (long long)sizeof(chunk) ?
+                      (size_t)(len - (long long)skipped) : sizeof(chunk);
+        size_t got = fread(chunk, 1, want, input);
+        skipped += got;
+        if (got < want) break;
     }
+    return skipped;
+}
 
-    SystemState state;
-    init_system_state(&state);
-    read_state(&state);
-
-    if (strcmp(cmd, CMD_DETECT) == 0) {
-        cmd_detect(&state);
-        return 0;
-    }
-    if (strcmp(cmd, CMD_RAG) == 0) {
-        cmd_rag(&state);
-        return 0;
-    }
-    if (strcmp(cmd, CMD_RESOLVE) == 0) {
-        int victim = -1;
-        if (scanf("%d", &victim) != 1) victim = -1;
-        cmd_resolve(&state, victim);
-        return 0;
-    }
-    if (strcmp(cmd, CMD_SIMULATE) == 0) {
-        int pi, rj, amount;
-        if (scanf("%d %d %d", &pi, &rj, &amount) != 3) {
-            printf("{\"granted\":false,\"is_safe\":false,\"message\":\"Missing process_index resource_index amount.\"}\n");
-            return 0;
+/* Answer frames until EOF or a broken stream; see serve() */
+static int serve_frames(FILE *input, JsonWriter *out, int reader) {
+    long id;
+    long long len;
+    int status = 0;
+    for (;;) {
+        int c = getc(input);
+        if (c == EOF) break;
+        if (c == WIRE_MARKER) {
+            bool ok = answer_binary_frame(input, out);
+            json_flush(out);
+            if (!ok) {
+                status = 1;
+                break;
+            }
+            continue;
+        }
+        ungetc(c, input);
+        if (fscanf(input, "%ld %lld", &id, &len) != 2) break;
+        if (getc(input) != '\n') {
+            fprintf(stderr, "malformed frame header\n");
+            status = 1;
+            break;
+        }
+        // The length comes from the client: a bad one ends only this stream,
+        // and a failed allocation answers this frame instead of exiting
+        if (len < 0 || len > MAX_FRAME_BYTES) {
+            json_lit(out, "{\"id\":");
+            json_ll(out, id);
+            json_lit(out, ",\"error\":\"invalid frame length\"}\n");
+            json_flush(out);
+            status = 1;
+            break;
         }
-        cmd_simulate(&state, pi, rj, amount);
-        return 0;
+        char *buf = malloc((size_t)len + 1);
+        size_t got = buf ? fread(buf, 1, (size_t)len, input) : skip_bytes(input, len);
+        if (got != (size_t)len) {
+            fprintf(stderr, "truncated frame %ld\n", id);
+            free(buf);
+            status = 1;
+            break;
+        }
+        if (!buf) {
+            json_lit(out, "{\"id\":");
+            json_ll(out, id);
+            json_lit(out, ",\"error\":\"out of memory\"}\n");
+            if (!json_flush(out)) break;
+            continue;
+        }
+        buf[len] = '\0';
+
+        Request req;
+        const char *err = "empty frame";
+        stats_reset();
+        STATS_START(parse);
+        TextReader text;
+        TextReader *in = len > 0 ? &text : NULL;
+        if (in) {
+            text_reader_init_buffer(in, buf, len);
+            err = read_request(in, &req);
+        } else {
+            memset(&req, 0, sizeof(req));
+        }
+        STATS_STOP(STAT_PARSE, parse);
+
+        json_lit(out, "{\"id\":");
+        json_ll(out, id);
+        if (err) {
+            json_lit(out, ",\"error\":\"");
+            json_str(out, err);
+            json_lit(out, "\"}\n");
+        } else if (stats_enabled) {
+            // The stats go before the result, so the response is buffered
+            StateSource src = { in, NULL };
+            JsonWriter body;
+            json_init(&body, -1);
+            long long start = stats_now_ns();
+            bool ok = execute_guarded(&req, &src, &body, reader);
+            stats_finish(stats_now_ns() - start);
+            if (ok) {
+                json_lit(out, ",\"stats\":");
+                stats_write_json(out);
+                json_lit(out, ",\"result\":");
+                json_raw(out, body.data, body.length);
+                json_lit(out, "}\n");
+            } else {
+                json_lit(out, ",\"error\":\"out of memory\"}\n");
+            }
+            json_free(&body);
+        } else {
+            StateSource src = { in, NULL };
+            json_lit(out, ",\"result\":");
+            if (execute_guarded(&req, &src, out, reader)) {
+                json_lit(out, "}\n");
+            } else {
+                // Only a batch drains before its end; with part of its
+                // array already sent, the stream cannot be resynchronized
+                free_request(&req);
+                free(buf);
+                if (strcmp(req.cmd, CMD_BATCH_DETECT) == 0) out_of_memory();
+                json_reset(out);
+                json_lit(out, "{\"id\":");
+                json_ll(out, id);
+                json_lit(out, ",\"error\":\"out of memory\"}\n");
+                if (!json_flush(out)) break;
+                continue;
+            }
+        }
+        free_request(&req);
+        free(buf);
+        if (!json_flush(out)) break;  /* the other end went away */
     }
+    return status;
+}
 
-    fprintf(stderr, "unknown command: %s\n", cmd);
+/* Long-lived mode: answer length-prefixed frames from `input` until EOF,
+ * writing to `fd`. Each frame may use either framing; a binary request
+ * gets a binary response. Each response leaves in one write() (a long
+ * batch drains as it goes). Under --daemon, running out of memory fails
+ * the request (see execute_guarded()), or where that cannot be answered
+ * cleanly, ends this stream; the process and other streams go on. */
+static int serve(FILE *input, int fd) {
+    int reader = domain_reader_register(&domains);
+    step_stream_begin();
+    JsonWriter out;
+    json_init(&out, fd);
+    jmp_buf escape;
+    oom_escape = &escape;
+    int status = setjmp(escape) ? 1 : serve_frames(input, &out, reader);
+    oom_escape = NULL;
+    if (reader >= 0) domain_reader_unregister(&domains, reader);
+    step_stream_end();
+    json_free(&out);
+    return status;
+}
+
+/* --daemon's out-of-memory handler: let go of the step session, domain
+ * read or domain write the thread is in, then leave to the innermost
+ * escape (the batch state, the request or the stream). Off a stream, e.g.
+ * in the accept loop, it returns and the default exit runs. */
+static void daemon_out_of_memory(void) {
+    if (!oom_escape) return;
+    if (stepping >= 0) {
+        // The session's worklist may be half way through a step
+        end_step_session(stepping);
+        stepping = -1;
+        pthread_mutex_unlock(&step_lock);
+    }
+    if (reading >= 0) {
+        domain_read_end(&domains, reading);
+        reading = -1;
+    }
+    domain_write_abandon(&domains);
+    longjmp(*oom_escape, 1);
+}
+
+static void *connection_thread(void *arg) {
+    int fd = (int)(intptr_t)arg;
+    FILE *input = fdopen(fd, "r");
+    if (input) {
+        serve(input, fd);
+        fclose(input);
+    } else {
+        close(fd);
+    }
+    return NULL;
+}
+
+/* Daemon mode: serve every connection to a Unix socket on its own thread.
+ * The connections share the domain store; each owns its step sessions. */
+static int run_daemon(const char *path) {
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "socket path too long: %s\n", path);
+        return 1;
+    }
+    strcpy(addr.sun_path, path);
+    // Replace a stale socket from an earlier run, but nothing else
+    struct stat existing;
+    if (lstat(path, &existing) == 0) {
+        if (!S_ISSOCK(existing.st_mode)) {
+            fprintf(stderr, "%s exists and is not a socket\n", path);
+            return 1;
+        }
+        unlink(path);
+    } else if (errno != ENOENT) {
+        perror(path);
+        return 1;
+    }
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0 || bind(listener, (struct sockaddr *)&addr, sizeof(addr)) != 0 ||
+        listen(listener, 128) != 0) {
+        perror(path);
+        if (listener >= 0) close(listener);
+        return 1;
+    }
+    signal(SIGPIPE, SIG_IGN);  /* a client that disconnects fails its write instead */
+    set_out_of_memory_handler(daemon_out_of_memory);
+    for (;;) {
+        int fd = accept(listener, NULL, NULL);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            perror("accept");
+            break;
+        }
+        pthread_t thread;
+        if (pthread_create(&thread, NULL, connection_thread, (void *)(intptr_t)fd) != 0) {
+            close(fd);
+            continue;
+        }
+        pthread_detach(thread);
+    }
+    close(listener);
     return 1;
 }
+
+int main(int argc, char **argv) {
+    bool serving = false;
+    const char *socket_path = NULL;
+    for (int a = 1; a < argc; a++) {
+        if (strcmp(argv[a], "--serve") == 0) {
+            serving = true;
+        } else if (strcmp(argv[a], "--daemon") == 0 && a + 1 < argc) {
+            socket_path = argv[++a];
+        } else if (strcmp(argv[a], "--stats") == 0) {
+            stats_enabled = STATS_COMPILED;  /* ignored in -DDEADLOCK_NO_STATS builds */
+        } else if (strcmp(argv[a], "--threads") == 0 && a + 1 < argc && atoi(argv[a + 1]) >= 1) {
+            detect_threads = atoi(argv[++a]);
+        } else {
+            fprintf(stderr, "usage: %s [--serve | --daemon SOCKET] [--threads N] [--stats]\n",
+                    argv[0]);
+            return 1;
+        }
+    }
+    domain_store_init(&domains);
+    if (socket_path) {
+        return run_daemon(socket_path);
+    }
+    if (serving) {
+        int status = serve(stdin, STDOUT_FILENO);
+        domain_store_free(&domains);
+        return status;
+    }
+
+    // One binary frame in, one binary frame out
+    JsonWriter out;
+    json_init(&out, STDOUT_FILENO);
+    int c = getchar();
+    if (c == WIRE_MARKER) {
+        bool ok = answer_binary_frame(stdin, &out);
+        json_flush(&out);
+        json_free(&out);
+        return ok ? 0 : 1;
+    }
+    if (c != EOF) ungetc(c, stdin);
+
+    // The reader owns stdin from here on, for BATCH_DETECT's states as well
+    TextReader in;
+    text_reader_init_file(&in, stdin, false);
+    Request req;
+    stats_reset();
+    STATS_START(parse);
+    const char *err = read_request(&in, &req);
+    STATS_STOP(STAT_PARSE, parse);
+    if (err) {
+        if (strcmp(err, "unknown command") == 0)
+            fprintf(stderr, "unknown command: %s\n", req.cmd);
+        else
+            fprintf(stderr, "%s\n", err);
+        free_request(&req);
+        text_reader_free(&in);
+        json_free(&out);
+        return 1;
+    }
+    StateSource src = { &in, NULL };
+    long long start = stats_now_ns();
+    execute_request(&req, &src, &out, -1);
+    json_char(&out, '\n');
+    json_flush(&out);
+    stats_finish(stats_now_ns() - start);
+    if (stats_enabled) {
+        JsonWriter err_out;
+        json_init(&err_out, STDERR_FILENO);
+        stats_write_json(&err_out);
+        json_char(&err_out, '\n');
+        json_flush(&err_out);
+        json_free(&err_out);
+    }
+    free_request(&req);
+    text_reader_free(&in);
+    json_free(&out);
+    return 0;
+}
@@ -0,0 +1,368 @@
+/*
+ * Deadlock Detection System
+ * Microbenchmarks for the detector's hot paths (make bench)
+ *
+ * Every case runs on generated states (see workload.h) across a size sweep,
+ * once safe and once with a deadlock cycle. Results go to stdout as one JSON
+ * document: ns/op (mean), per-sample percentiles and heap allocations per op.
+ *
+ *   deadlock_bench [--seed N] [--contention PCT] [--cycle LEN]
+ *                  [--sizes NPxNR,...] [--min-time MS] [--only CASE]
+ */
+
+#define _POSIX_C_SOURCE 200809L  /* clock_gettime */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "api_commands.h"
+#include "deadlock_detector.h"
+#include "headroom.h"
+#include "state_hash.h"
+#include "text_reader.h"
+#include "parallel_detect.h"
+#include "rag.h"
+#include "simd_kernels.h"
+#include "workload.h"
+
+#define MAX_SIZES 16
+#define MAX_SAMPLES 4096
+#define MIN_SAMPLES 5
+#define MIN_SAMPLE_NS 2000.0   // batch fast ops so the timer is not the cost
+
+// Allocation counting: the Makefile links with -Wl,--wrap for these symbols
+// (GNU ld). Build without BENCH_COUNT_ALLOCS and allocs_per_op is null.
+static unsigned long long alloc_count;
+
+#ifdef BENCH_COUNT_ALLOCS
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t count, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+
+void *__wrap_malloc(size_t size) {
+    alloc_count++;
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t count, size_t size) {
+    alloc_count++;
+    return __real_calloc(count, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size) {
+    alloc_count++;
+    return __real_realloc(ptr, size);
+}
+#endif
+
+// State shared by the cases of one (size, deadlock) point
+typedef struct {
+    SystemState state;
+    DetectionResult result;
+    RAG rag;
+    JsonWriter sink;    // response buffer, emptied before each op
+    JsonWriter text;    // the state in the api_worker text format
+    SystemState parsed; // parse_state's output
+    int sim_process;    // a valid one-unit SIMULATE request, if any
+    int sim_resource;
+    int *headroom;      // np * nr
+    int threads;        // for detect_parallel
+} Fixture;
+
+typedef struct {
+    const char *name;
+    void (*run)(Fixture *f);
+    bool needs_deadlock;
+} BenchCase;
+
+static void run_need(Fixture *f) {
+    calculate_need_matrix(&f->state);
+}
+
+static void run_detect(Fixture *f) {
+    detect_deadlock(&f->state, &f->result);
+}
+
+static void run_detect_parallel(Fixture *f) {
+    detect_deadlock_parallel(&f->state, &f->result, f->threads);
+}
+
+static void run_build_rag(Fixture *f) {
+    build_rag(&f->state, &f->rag);
+}
+
+static void run_cycle_rag(Fixture *f) {
+    detect_cycle_rag(&f->rag);
+}
+
+static volatile int victim_sink;
+
+static void run_pick_victim(Fixture *f) {
+    victim_sink = api_pick_victim(&f->state, &f->result);
+}
+
+static void run_simulate(Fixture *f) {
+    json_reset(&f->sink);
+    api_simulate(&f->sink, &f->state, f->sim_process, f->sim_resource, 1);
+}
+
+static void run_rag_json(Fixture *f) {
+    json_reset(&f->sink);
+    api_rag(&f->sink, &f->state);
+}
+
+static void run_parse_state(Fixture *f) {
+    TextReader r;
+    text_reader_init_buffer(&r, f->text.data, f->text.length);
+    free_system_state(&f->parsed);
+    text_read_state(&r, &f->parsed);
+}
+
+// Write the state as api_worker reads it, one row per line
+static void format_state(JsonWriter *w, const SystemState *state) {
+    json_reset(w);
+    json_int(w, state->num_processes);
+    json_char(w, ' ');
+    json_int(w, state->num_resources);
+    json_char(w, '\n');
+    json_ints(w, state->available, state->num_resources, " ", "");
+    json_char(w, '\n');
+    for (int i = 0; i < state->num_processes; i++) {
+        json_ints(w, state->allocation[i], state->num_resources, " ", "");
+        json_char(w, '\n');
+    }
+    for (int i = 0; i < state->num_processes; i++) {
+        json_ints(w, state->max_need[i], state->num_resources, " ", "");
+        json_char(w, '\n');
+    }
+}
+
+static void run_headroom(Fixture *f) {
+    compute_headroom(&f->state, f->headroom);
+}
+
+static volatile uint64_t hash_sink;
+
+static void run_state_hash(Fixture *f) {
+    hash_sink = state_hash(&f->state);
+}
+
+static const BenchCase cases[] = {
+    { "calculate_need_matrix", run_need, false },
+    { "detect_deadlock", run_detect, false },
+    { "detect_parallel", run_detect_parallel, false },
+    { "build_rag", run_build_rag, false },
+    { "detect_cycle_rag", run_cycle_rag, false },
+    { "pick_victim", run_pick_victim, true },
+    { "simulate", run_simulate, false },
+    { "rag_json", run_rag_json, false },
+    { "parse_state", run_parse_state, false },
+    { "headroom", run_headroom, false },
+    { "state_hash", run_state_hash, false },
+};
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static int compare_doubles(const void *a, const void *b) {
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+// Nearest-rank percentile of sorted samples
+static double percentile(const double *sorted, int n, double pct) {
+    int rank = (int)(pct / 100.0 * n + 0.5);
+    if (rank < 1) rank = 1;
+    if (rank > n) rank = n;
+    return sorted[rank - 1];
+}
+
+// Time one case and print its JSON object
+static void bench_case(const BenchCase *c, Fixture *f, bool deadlock,
+                       double min_time_ns, bool first) {
+    static double samples[MAX_SAMPLES];
+
+    // Warm up, then double the batch until one sample is long enough
+    c->run(f);
+    long reps = 1;
+    for (;;) {
+        double t0 = now_ns();
+        for (long r = 0; r < reps; r++) c->run(f);
+        if (now_ns() - t0 >= MIN_SAMPLE_NS || reps >= (1L << 20)) break;
+        reps *= 2;
+    }
+
+    int n = 0;
+    double total = 0.0;
+    unsigned long long allocs_before = alloc_count;
+    while (n < MAX_SAMPLES && (n < MIN_SAMPLES || total < min_time_ns)) {
+        double t0 = now_ns();
+        for (long r = 0; r < reps; r++) c->run(f);
+        double elapsed = now_ns() - t0;
+        samples[n++] = elapsed / (double)reps;
+        total += elapsed;
+    }
+    unsigned long long allocs = alloc_count - allocs_before;
+    double ops = (double)n * (double)reps;
+    qsort(samples, (size_t)n, sizeof(double), compare_doubles);
+
+    printf("%s\n    {\"case\":\"%s\",\"np\":%d,\"nr\":%d,\"deadlock\":%s,\"ops\":%.0f,"
+           "\"ns_per_op\":%.1f,\"p50\":%.1f,\"p90\":%.1f,\"p99\":%.1f,\"min\":%.1f,\"max\":%.1f,",
+           first ? "" : ",", c->name, f->state.num_processes, f->state.num_resources,
+           deadlock ? "true" : "false", ops, total / ops,
+           percentile(samples, n, 50), percentile(samples, n, 90), percentile(samples, n, 99),
+           samples[0], samples[n - 1]);
+#ifdef BENCH_COUNT_ALLOCS
+    printf("\"allocs_per_op\":%.2f}", (double)allocs / ops);
+#else
+    (void)allocs;
+    printf("\"allocs_per_op\":null}");
+#endif
+    fflush(stdout);
+}
+
+// First (process, resource) with outstanding need and a free unit
+static void pick_simulate_request(Fixture *f) {
+    const SystemState *s = &f->state;
+    f->sim_process = 0;
+    f->sim_resource = 0;
+    for (int i = 0; i < s->num_processes; i++) {
+        for (int j = 0; j < s->num_resources; j++) {
+            if (s->need[i][j] > 0 && s->available[j] > 0) {
+                f->sim_process = i;
+                f->sim_resource = j;
+                return;
+            }
+        }
+    }
+}
+
+// Parse "64x8,4096x32"; returns the number of sizes or -1
+static int parse_sizes(const char *arg, int sizes[][2]) {
+    int count = 0;
+    const char *p = arg;
+    while (*p) {
+        char *end;
+        long np = strtol(p, &end, 10);
+        if (*end != 'x' || count == MAX_SIZES) return -1;
+        long nr = strtol(end + 1, &end, 10);
+        if (np < 2 || nr < 1 || np > MAX_PROCESSES || nr > MAX_RESOURCES) return -1;
+        sizes[count][0] = (int)np;
+        sizes[count][1] = (int)nr;
+        count++;
+        if (*end == ',') end++;
+        else if (*end) return -1;
+        p = end;
+    }
+    return count;
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr, "usage: %s [--seed N] [--contention PCT] [--cycle LEN] "
+            "[--sizes NPxNR,...] [--min-time MS] [--only CASE] [--threads N]\n", prog);
+}
+
+int main(int argc, char **argv) {
+    int sizes[MAX_SIZES][2] = { {8, 4}, {64, 8}, {512, 16}, {4096, 32}, {32768, 64} };
+    int num_sizes = 5;
+    WorkloadParams params = { 0, 0, 50, false, 4, 1 };
+    double min_time_ms = 100.0;
+    const char *only = NULL;
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    int threads = cpus < 1 ? 1 : (int)cpus;
+
+    for (int a = 1; a < argc; a++) {
+        const char *value = a + 1 < argc ? argv[a + 1] : NULL;
+        if (!value) {
+            usage(argv[0]);
+            return 1;
+        }
+        if (strcmp(argv[a], "--seed") == 0) {
+            params.seed = strtoull(value, NULL, 10);
+        } else if (strcmp(argv[a], "--contention") == 0) {
+            params.contention = atoi(value);
+        } else if (strcmp(argv[a], "--cycle") == 0) {
+            params.cycle_length = atoi(value);
+        } else if (strcmp(argv[a], "--min-time") == 0) {
+            min_time_ms = atof(value);
+        } else if (strcmp(argv[a], "--threads") == 0) {
+            threads = atoi(value);
+        } else if (strcmp(argv[a], "--only") == 0) {
+            only = value;
+        } else if (strcmp(argv[a], "--sizes") == 0) {
+            num_sizes = parse_sizes(value, sizes);
+            if (num_sizes <= 0) {
+                fprintf(stderr, "invalid --sizes: %s\n", value);
+                return 1;
+            }
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+        a++;
+    }
+
+    Fixture f;
+    f.threads = threads;
+    json_init(&f.sink, -1);
+    json_init(&f.text, -1);
+    init_system_state(&f.parsed, 0, 0);
+
+    printf("{\"simd\":\"%s\",\"threads\":%d,\"seed\":%llu,\"contention\":%d,\"cycle_length\":%d,"
+           "\"alloc_counting\":%s,\"results\":[",
+           simd_level(), threads, (unsigned long long)params.seed, params.contention, params.cycle_length,
+#ifdef BENCH_COUNT_ALLOCS
+           "true"
+#else
+           "false"
+#endif
+           );
+    bool first = true;
+    for (int s = 0; s < num_sizes; s++) {
+        for (int d = 0; d < 2; d++) {
+            params.num_processes = sizes[s][0];
+            params.num_resources = sizes[s][1];
+            params.deadlock = d == 1;
+            if (!generate_workload(&f.state, &params)) {
+                fprintf(stderr, "cannot generate %dx%d\n", sizes[s][0], sizes[s][1]);
+                return 1;
+            }
+            init_detection_result(&f.result);
+            init_rag(&f.rag);
+            detect_deadlock(&f.state, &f.result);
+            build_rag(&f.state, &f.rag);
+            pick_simulate_request(&f);
+            format_state(&f.text, &f.state);
+            f.headroom = checked_malloc((size_t)sizes[s][0] * sizes[s][1] * sizeof(int));
+            if (f.result.is_deadlocked != params.deadlock) {
+                fprintf(stderr, "generator produced the wrong kind of state at %dx%d\n",
+                        sizes[s][0], sizes[s][1]);
+                return 1;
+            }
+
+            for (size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); c++) {
+                if (only && strcmp(only, cases[c].name) != 0) continue;
+                if (cases[c].needs_deadlock && !params.deadlock) continue;
+                bench_case(&cases[c], &f, params.deadlock, min_time_ms * 1e6, first);
+                first = false;
+            }
+
+            free(f.headroom);
+            free_rag(&f.rag);
+            free_detection_result(&f.result);
+            free_system_state(&f.state);
+        }
+    }
+    printf("\n]}\n");
+    json_free(&f.sink);
+    json_free(&f.text);
+    free_system_state(&f.parsed);
+    return 0;
+}
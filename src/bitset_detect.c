@@ -0,0 +1,173 @@
+/*
+ * Deadlock Detection System
+ * Bit-parallel detection for single-instance resources
+ *
+ * Cost is O(n*m) to check and pack the matrices, O(n*m/64) for the initial checks and O(n/64) per pass to find ready
+ * processes, touching each (process, resource) wait once.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include "bitset_detect.h"
+#include "stats.h"
+
+typedef uint64_t Bits;
+
+#define BITS_PER_WORD 64
+
+static int words_for(int bits) {
+    return (bits + BITS_PER_WORD - 1) / BITS_PER_WORD;
+}
+
+// Whether every entry fits single-instance semantics; stops at the first
+// that does not, so a rejected state allocates nothing
+static bool single_instance(const SystemState *state) {
+    int nr = state->num_resources;
+    for (int j = 0; j < nr; j++) {
+        if (state->available[j] < 0) return false;
+    }
+    for (int i = 0; i < state->num_processes; i++) {
+        const int *allocation = state->allocation[i];
+        const int *need = state->need[i];
+        for (int j = 0; j < nr; j++) {
+            if (allocation[j] < 0 || need[j] > 1) return false;
+        }
+    }
+    return true;
+}
+
+// Pack Available and each row's nonzero Allocation and Need into bitsets
+static void pack_rows(const SystemState *state, Bits *need_bits, Bits *allocation_bits,
+                      Bits *work, int words) {
+    int nr = state->num_resources;
+    for (int j = 0; j < nr; j++) {
+        work[j / BITS_PER_WORD] |= (Bits)(state->available[j] > 0) << (j % BITS_PER_WORD);
+    }
+    for (int i = 0; i < state->num_processes; i++) {
+        const int *allocation = state->allocation[i];
+        const int *need = state->need[i];
+        Bits *need_row = need_bits + (size_t)i * words;
+        Bits *allocation_row = allocation_bits + (size_t)i * words;
+        for (int j = 0; j < nr; j++) {
+            need_row[j / BITS_PER_WORD] |= (Bits)(need[j] > 0) << (j % BITS_PER_WORD);
+            allocation_row[j / BITS_PER_WORD] |= (Bits)(allocation[j] > 0) << (j % BITS_PER_WORD);
+        }
+    }
+}
+
+// First set bit at or after position from, or -1
+static int next_set(const Bits *set, int words, int from) {
+    int w = from / BITS_PER_WORD;
+    if (w >= words) return -1;
+    Bits x = set[w] & (~(Bits)0 << (from % BITS_PER_WORD));
+    while (x == 0) {
+        if (++w == words) return -1;
+        x = set[w];
+    }
+    return w * BITS_PER_WORD + __builtin_ctzll(x);
+}
+
+bool detect_deadlock_bitset(const SystemState *state, DetectionResult *result) {
+    if (!single_instance(state)) {
+        return false;
+    }
+    int np = state->num_processes;
+    int nr = state->num_resources;
+    int words = words_for(nr);
+    int process_words = words_for(np);
+    STATS_START(start);
+
+    Bits *need_bits = checked_calloc((size_t)np * words + 1, sizeof(Bits));
+    Bits *allocation_bits = checked_calloc((size_t)np * words + 1, sizeof(Bits));
+    Bits *work = checked_calloc((size_t)words + 1, sizeof(Bits));
+    pack_rows(state, need_bits, allocation_bits, work, words);
+
+    // Blocked counts and wait lists (CSR by resource) from need & ~work
+    int *blocked = checked_calloc((size_t)np + 1, sizeof(int));
+    int *wait_offsets = checked_calloc((size_t)nr + 1, sizeof(int));
+    Bits *ready = checked_calloc((size_t)process_words + 1, sizeof(Bits));
+    for (int i = 0; i < np; i++) {
+        const Bits *need_row = need_bits + (size_t)i * words;
+        for (int w = 0; w < words; w++) {
+            Bits missing = need_row[w] & ~work[w];
+            blocked[i] += __builtin_popcountll(missing);
+            for (; missing; missing &= missing - 1) {
+                wait_offsets[w * BITS_PER_WORD + __builtin_ctzll(missing) + 1]++;
+            }
+        }
+        if (blocked[i] == 0) ready[i / BITS_PER_WORD] |= (Bits)1 << (i % BITS_PER_WORD);
+    }
+    for (int j = 0; j < nr; j++) {
+        wait_offsets[j + 1] += wait_offsets[j];
+    }
+    int *waits = checked_malloc((size_t)wait_offsets[nr] * sizeof(int) + sizeof(int));
+    int *fill = checked_malloc((size_t)nr * sizeof(int) + sizeof(int));
+    for (int j = 0; j < nr; j++) {
+        fill[j] = wait_offsets[j];
+    }
+    for (int i = 0; i < np; i++) {
+        if (blocked[i] == 0) continue;
+        const Bits *need_row = need_bits + (size_t)i * words;
+        for (int w = 0; w < words; w++) {
+            for (Bits missing = need_row[w] & ~work[w]; missing; missing &= missing - 1) {
+                waits[fill[w * BITS_PER_WORD + __builtin_ctzll(missing)]++] = i;
+            }
+        }
+    }
+    free(fill);
+
+    // The next process a pass-by-pass scan finishes is the first ready one
+    // after the last taken; when there is none, a new pass starts from 0
+    int length = 0;
+    long long passes = 1;
+    long long checked = np;
+    int cursor = -1;
+    for (;;) {
+        int p = next_set(ready, process_words, cursor + 1);
+        if (p < 0) {
+            p = next_set(ready, process_words, 0);
+            if (p < 0) break;
+            passes++;
+        }
+        cursor = p;
+        ready[p / BITS_PER_WORD] &= ~((Bits)1 << (p % BITS_PER_WORD));
+        result->safe_sequence[length++] = p;
+
+        // Release: only resources going from zero to available unblock anyone
+        const Bits *allocation_row = allocation_bits + (size_t)p * words;
+        for (int w = 0; w < words; w++) {
+            Bits gained = allocation_row[w] & ~work[w];
+            work[w] |= gained;
+            for (; gained; gained &= gained - 1) {
+                int j = w * BITS_PER_WORD + __builtin_ctzll(gained);
+                for (int k = wait_offsets[j]; k < wait_offsets[j + 1]; k++) {
+                    int q = waits[k];
+                    if (--blocked[q] == 0) ready[q / BITS_PER_WORD] |= (Bits)1 << (q % BITS_PER_WORD);
+                }
+                checked += wait_offsets[j + 1] - wait_offsets[j];
+            }
+        }
+    }
+
+    // Finished processes have a zero count; the rest are deadlocked
+    result->safe_sequence_length = length;
+    result->num_deadlocked = 0;
+    for (int i = 0; i < np; i++) {
+        if (blocked[i] > 0) {
+            result->deadlocked_processes[result->num_deadlocked++] = i;
+        }
+    }
+    result->is_deadlocked = result->num_deadlocked > 0;
+
+    free(need_bits);
+    free(allocation_bits);
+    free(work);
+    free(blocked);
+    free(wait_offsets);
+    free(ready);
+    free(waits);
+    STATS_ADD(passes, passes);
+    STATS_ADD(comparisons, checked);
+    STATS_STOP(STAT_DETECT, start);
+    return true;
+}
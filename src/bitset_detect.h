@@ -0,0 +1,32 @@
+/*
+ * Deadlock Detection System
+ * Bit-parallel detection for single-instance resources header file
+ */
+
+#ifndef BITSET_DETECT_H
+#define BITSET_DETECT_H
+
+#include <stdbool.h>
+#include "deadlock_detector.h"
+
+/**
+ * Detect deadlock with Need, Allocation and Work packed into 64-bit bitsets
+ * Fits mutex-only systems: when every Need entry is at most 1, only whether
+ * Work[j] is zero matters, so a process can run when (need & ~work) == 0
+ * and releasing it is work |= allocation, one word per 64 resources.
+ * Each process counts the resources it still waits for and each resource
+ * lists its waiters, so a release only touches the processes it unblocks;
+ * ready processes are a bitset scanned from the current pass position. The
+ * result is identical to detect_deadlock_rescan().
+ *
+ * Need must already be calculated, and result must have room for
+ * num_processes entries. The state is checked before anything is
+ * allocated, stopping at the first entry that does not fit.
+ * @param state Pointer to SystemState structure
+ * @param result Receives deadlock status and safe sequence
+ * @return false, writing nothing to result, if some available or
+ *   allocation is negative or some Need entry exceeds 1
+ */
+bool detect_deadlock_bitset(const SystemState *state, DetectionResult *result);
+
+#endif // BITSET_DETECT_H
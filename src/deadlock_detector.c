@@ -4,45 +4,153 @@
  */
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include "deadlock_detector.h"
+#include "bitset_detect.h"
+#include "simd_kernels.h"
+#include "small_detect.h"
+#include "stats.h"
+#include "worklist.h"
 
-// Initialize system state with default values
-void init_system_state(SystemState *state) {
-    state->num_processes = 0;
-    state->num_resources = 0;
+// Abort on allocation failure (scratch buffers are O(n + m))
+static void (*out_of_memory_handler)(void);
+
+void set_out_of_memory_handler(void (*handler)(void)) {
+    out_of_memory_handler = handler;
+}
+
+void out_of_memory(void) {
+    if (out_of_memory_handler) out_of_memory_handler();
+    fprintf(stderr, "out of memory\n");
+    exit(1);
+}
+
+void *checked_malloc(size_t size) {
+    void *p = malloc(size ? size : 1);
+    if (!p) out_of_memory();
+    return p;
+}
+
+void *checked_calloc(size_t count, size_t size) {
+    void *p = calloc(count ? count : 1, size ? size : 1);
+    if (!p) out_of_memory();
+    return p;
+}
+
+// Round a row length up to whole SIMD blocks
+int padded_row_length(int num_resources) {
+    return (num_resources + ROW_ALIGN_INTS - 1) / ROW_ALIGN_INTS * ROW_ALIGN_INTS;
+}
+
+// Allocate a zeroed system state of the given dimensions
+bool init_system_state(SystemState *state, int num_processes, int num_resources) {
+    memset(state, 0, sizeof(*state));
+    if (num_processes < 0 || num_processes > MAX_PROCESSES ||
+        num_resources < 0 || num_resources > MAX_RESOURCES) {
+        return false;
+    }
     
-    for (int i = 0; i < MAX_RESOURCES; i++) {
-        state->available[i] = 0;
+    size_t np = (size_t)num_processes;
+    size_t nr = (size_t)num_resources;
+    size_t stride = (size_t)padded_row_length(num_resources);
+    
+    // available + allocation + max_need + need in a single zeroed block,
+    // every row padded to whole 64-byte blocks and 64-byte aligned
+    state->storage = calloc(stride + 3 * np * stride + ROW_ALIGN_INTS, sizeof(int));
+    state->rows = malloc((3 * np + 1) * sizeof(int *));
+    state->process_names = malloc((np + 1) * sizeof(*state->process_names));
+    state->resource_names = malloc((nr + 1) * sizeof(*state->resource_names));
+    if (!state->storage || !state->rows ||
+        !state->process_names || !state->resource_names) {
+        free_system_state(state);
+        return false;
     }
     
-    for (int i = 0; i < MAX_PROCESSES; i++) {
-        sprintf(state->process_names[i], "P%d", i);
-        for (int j = 0; j < MAX_RESOURCES; j++) {
-            state->allocation[i][j] = 0;
-            state->max_need[i][j] = 0;
-            state->need[i][j] = 0;
-        }
+    size_t align = ROW_ALIGN_INTS * sizeof(int);
+    size_t misalign = (size_t)((uintptr_t)state->storage % align);
+    int *base = state->storage + (misalign ? (align - misalign) / sizeof(int) : 0);
+    
+    state->num_processes = num_processes;
+    state->num_resources = num_resources;
+    state->row_stride = (int)stride;
+    state->available = base;
+    state->allocation = state->rows;
+    state->max_need = state->rows + np;
+    state->need = state->rows + 2 * np;
+    
+    int *matrix = base + stride;
+    for (size_t i = 0; i < np; i++) {
+        state->allocation[i] = matrix + i * stride;
+        state->max_need[i] = matrix + (np + i) * stride;
+        state->need[i] = matrix + (2 * np + i) * stride;
+        sprintf(state->process_names[i], "P%d", (int)i);
     }
     
-    for (int i = 0; i < MAX_RESOURCES; i++) {
-        sprintf(state->resource_names[i], "R%d", i);
+    for (size_t j = 0; j < nr; j++) {
+        sprintf(state->resource_names[j], "R%d", (int)j);
+    }
+    return true;
+}
+
+// Release memory owned by a system state
+void free_system_state(SystemState *state) {
+    free(state->storage);
+    free(state->rows);
+    free(state->process_names);
+    free(state->resource_names);
+    memset(state, 0, sizeof(*state));
+}
+
+// Initialize an empty detection result
+void init_detection_result(DetectionResult *result) {
+    memset(result, 0, sizeof(*result));
+}
+
+// Release memory owned by a detection result
+void free_detection_result(DetectionResult *result) {
+    free(result->deadlocked_processes);
+    free(result->safe_sequence);
+    memset(result, 0, sizeof(*result));
+}
+
+// Make room for num_processes entries in both result arrays
+static void reserve_detection_result(DetectionResult *result, int num_processes) {
+    if (result->capacity >= num_processes && result->safe_sequence) {
+        return;
     }
+    // Cleared first: an out-of-memory handler may leave before they are set
+    free_detection_result(result);
+    result->deadlocked_processes = checked_malloc((size_t)num_processes * sizeof(int));
+    result->safe_sequence = checked_malloc((size_t)num_processes * sizeof(int));
+    result->capacity = num_processes;
 }
 
 // Calculate Need matrix (Need = Max - Allocation)
 void calculate_need_matrix(SystemState *state) {
-    for (int i = 0; i < state->num_processes; i++) {
-        for (int j = 0; j < state->num_resources; j++) {
-            state->need[i][j] = state->max_need[i][j] - state->allocation[i][j];
-        }
+    if (state->num_processes == 0) return;
+    STATS_START(start);
+    // Rows are contiguous, so this is one flat loop (padding stays 0 - 0)
+    size_t cells = (size_t)state->num_processes * (size_t)state->row_stride;
+    const int *max_need = state->max_need[0];
+    const int *allocation = state->allocation[0];
+    int *need = state->need[0];
+    for (size_t k = 0; k < cells; k++) {
+        need[k] = max_need[k] - allocation[k];
     }
+    STATS_STOP(STAT_NEED, start);
 }
 
 // Check if a process's needs can be satisfied with available work
 bool can_satisfy(int need[], int work[], int num_resources) {
-    for (int j = 0; j < num_resources; j++) {
+    // Whole 16-lane blocks go through the vector kernel
+    int blocks = num_resources / ROW_ALIGN_INTS * ROW_ALIGN_INTS;
+    if (blocks > 0 && !vec_all_le(need, work, blocks)) {
+        return false;
+    }
+    for (int j = blocks; j < num_resources; j++) {
         if (need[j] > work[j]) {
             return false;
         }
@@ -50,61 +158,103 @@ bool can_satisfy(int need[], int work[], int num_resources) {
     return true;
 }
 
-// Banker's Algorithm for Deadlock Detection
-DetectionResult detect_deadlock(SystemState *state) {
-    DetectionResult result;
-    result.is_deadlocked = false;
-    result.num_deadlocked = 0;
-    result.safe_sequence_length = 0;
+// Banker's Algorithm for Deadlock Detection (rescan every pass; reference engine)
+void detect_deadlock_rescan(SystemState *state, DetectionResult *result) {
+    reserve_detection_result(result, state->num_processes);
+    result->is_deadlocked = false;
+    result->num_deadlocked = 0;
+    result->safe_sequence_length = 0;
     
     // Calculate need matrix
     calculate_need_matrix(state);
+    STATS_START(start);
     
-    // Initialize Work = Available
-    int work[MAX_RESOURCES];
-    for (int j = 0; j < state->num_resources; j++) {
-        work[j] = state->available[j];
-    }
+    // Initialize Work = Available (padded like the matrix rows)
+    int stride = state->row_stride;
+    int *work = checked_malloc((size_t)stride * sizeof(int));
+    memcpy(work, state->available, (size_t)stride * sizeof(int));
     
     // Initialize Finish array
-    bool finish[MAX_PROCESSES];
-    for (int i = 0; i < state->num_processes; i++) {
-        finish[i] = false;
-    }
+    bool *finish = checked_calloc((size_t)state->num_processes, sizeof(bool));
     
     // Find safe sequence
     int count = 0;
+    long long passes = 0;
+    long long checks = 0;
     bool found;
     
     do {
         found = false;
+        passes++;
         for (int i = 0; i < state->num_processes; i++) {
             if (!finish[i]) {
+                checks++;
                 // Check if process i's needs can be satisfied
-                if (can_satisfy(state->need[i], work, state->num_resources)) {
+                if (can_satisfy(state->need[i], work, stride)) {
                     // Release resources
-                    for (int j = 0; j < state->num_resources; j++) {
-                        work[j] += state->allocation[i][j];
-                    }
+                    vec_add(work, state->allocation[i], stride);
                     finish[i] = true;
-                    result.safe_sequence[count++] = i;
+                    result->safe_sequence[count++] = i;
                     found = true;
                 }
             }
         }
     } while (found);
     
-    result.safe_sequence_length = count;
+    result->safe_sequence_length = count;
     
     // Check for deadlock
     for (int i = 0; i < state->num_processes; i++) {
         if (!finish[i]) {
-            result.is_deadlocked = true;
-            result.deadlocked_processes[result.num_deadlocked++] = i;
+            result->is_deadlocked = true;
+            result->deadlocked_processes[result->num_deadlocked++] = i;
+        }
+    }
+    
+    free(work);
+    free(finish);
+    STATS_ADD(passes, passes);
+    STATS_ADD(comparisons, checks);
+    STATS_STOP(STAT_DETECT, start);
+}
+
+// Banker's Algorithm for Deadlock Detection (worklist engine)
+void detect_deadlock(SystemState *state, DetectionResult *result) {
+    if (state->num_processes <= SMALL_MAX_PROCESSES) {
+        // Small states: one specialized kernel, no worklist to build
+        reserve_detection_result(result, state->num_processes);
+        if (detect_deadlock_small(state, result)) return;
+    }
+    // Mutex-only states: bitsets instead of int rows
+    calculate_need_matrix(state);
+    reserve_detection_result(result, state->num_processes);
+    if (detect_deadlock_bitset(state, result)) return;
+    if (!worklist_applicable(state)) {
+        // Negative allocations shrink Work; only the rescan handles that
+        detect_deadlock_rescan(state, result);
+        return;
+    }
+    
+    STATS_START(start);
+    reserve_detection_result(result, state->num_processes);
+    
+    Worklist wl;
+    worklist_init(&wl, state);
+    worklist_run(&wl);
+    
+    memcpy(result->safe_sequence, wl.sequence,
+           (size_t)wl.sequence_length * sizeof(int));
+    result->safe_sequence_length = wl.sequence_length;
+    result->num_deadlocked = 0;
+    for (int i = 0; i < state->num_processes; i++) {
+        if (!wl.finish[i]) {
+            result->deadlocked_processes[result->num_deadlocked++] = i;
         }
     }
+    result->is_deadlocked = result->num_deadlocked > 0;
     
-    return result;
+    worklist_free(&wl);
+    STATS_STOP(STAT_DETECT, start);
 }
 
 // Resolve deadlock by terminating processes
@@ -161,7 +311,7 @@ void resolve_deadlock(SystemState *state, DetectionResult *result) {
     printf("\n  ▶ Re-running deadlock detection...\n");
     
     // Recalculate
-    *result = detect_deadlock(state);
+    detect_deadlock(state, result);
     
     if (result->is_deadlocked) {
         printf("\n  [!] Deadlock still exists. More processes need termination.\n");
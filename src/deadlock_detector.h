@@ -7,39 +7,81 @@
 #define DEADLOCK_DETECTOR_H
 
 #include <stdbool.h>
+#include <stddef.h>
 
-// System constraints
-#define MAX_PROCESSES 10
-#define MAX_RESOURCES 10
+// System constraints (upper bounds on input; storage is sized at runtime)
+#define MAX_PROCESSES 100000
+#define MAX_RESOURCES 1024
+#define MAX_NAME_LEN 10
+
+// Rows are padded to a multiple of this many ints (one 64-byte cache line)
+// and 64-byte aligned, so SIMD kernels never need a scalar tail
+#define ROW_ALIGN_INTS 16
 
 // System State Structure
+// Matrices are row-major in one contiguous block; allocation[i], max_need[i]
+// and need[i] are row pointers into it, so state->need[i][j] indexing works.
+// Each row (and available) holds row_stride ints; entries past
+// num_resources are always zero.
 typedef struct {
     int num_processes;
     int num_resources;
-    int available[MAX_RESOURCES];
-    int allocation[MAX_PROCESSES][MAX_RESOURCES];
-    int max_need[MAX_PROCESSES][MAX_RESOURCES];
-    int need[MAX_PROCESSES][MAX_RESOURCES];
-    char process_names[MAX_PROCESSES][10];
-    char resource_names[MAX_RESOURCES][10];
+    int row_stride;
+    int *available;
+    int **allocation;
+    int **max_need;
+    int **need;
+    char (*process_names)[MAX_NAME_LEN];
+    char (*resource_names)[MAX_NAME_LEN];
+    int *storage;       // backing block for available + all matrices
+    int **rows;         // backing block for the row pointers
 } SystemState;
 
 // Detection Result Structure
+// Arrays are heap-allocated and grown on demand by detect_deadlock().
 typedef struct {
     bool is_deadlocked;
-    int deadlocked_processes[MAX_PROCESSES];
+    int *deadlocked_processes;
     int num_deadlocked;
-    int safe_sequence[MAX_PROCESSES];
+    int *safe_sequence;
     int safe_sequence_length;
+    int capacity;
 } DetectionResult;
 
 // Function Prototypes
 
 /**
- * Initialize system state with default values
+ * Allocate and zero a system state of the given dimensions
+ * @param state Pointer to SystemState structure
+ * @param num_processes Number of processes (0..MAX_PROCESSES)
+ * @param num_resources Number of resource types (0..MAX_RESOURCES)
+ * @return false if the dimensions are out of range or memory is exhausted
+ */
+bool init_system_state(SystemState *state, int num_processes, int num_resources);
+
+/**
+ * Row length in ints for a given number of resources (multiple of ROW_ALIGN_INTS)
+ * @param num_resources Number of resource types
+ */
+int padded_row_length(int num_resources);
+
+/**
+ * Release memory owned by a system state (safe to call twice)
  * @param state Pointer to SystemState structure
  */
-void init_system_state(SystemState *state);
+void free_system_state(SystemState *state);
+
+/**
+ * Initialize an empty detection result
+ * @param result Pointer to DetectionResult
+ */
+void init_detection_result(DetectionResult *result);
+
+/**
+ * Release memory owned by a detection result
+ * @param result Pointer to DetectionResult
+ */
+void free_detection_result(DetectionResult *result);
 
 /**
  * Calculate Need matrix (Need = Max - Allocation)
@@ -49,10 +91,20 @@ void calculate_need_matrix(SystemState *state);
 
 /**
  * Detect deadlock using Banker's Algorithm
+ * Runs the worklist engine (see worklist.h); the result is identical to
+ * detect_deadlock_rescan(), including the order of the safe sequence.
+ * @param state Pointer to SystemState structure (need is recalculated)
+ * @param result Receives deadlock status and safe sequence
+ */
+void detect_deadlock(SystemState *state, DetectionResult *result);
+
+/**
+ * Detect deadlock by rescanning all unfinished processes every pass
+ * O(n^2 * m) worst case; kept as the reference for testing and benchmarks.
  * @param state Pointer to SystemState structure
- * @return DetectionResult containing deadlock status and safe sequence
+ * @param result Receives deadlock status and safe sequence
  */
-DetectionResult detect_deadlock(SystemState *state);
+void detect_deadlock_rescan(SystemState *state, DetectionResult *result);
 
 /**
  * Resolve deadlock by terminating processes
@@ -83,4 +135,25 @@ void display_result(DetectionResult *result, SystemState *state);
  */
 bool can_satisfy(int need[], int work[], int num_resources);
 
+/**
+ * malloc/calloc wrappers for scratch buffers: report a failure through
+ * out_of_memory(), which does not return
+ */
+void *checked_malloc(size_t size);
+void *checked_calloc(size_t count, size_t size);
+
+/**
+ * Set what happens when a checked allocation or a JSON writer runs out of
+ * memory. A handler that leaves (the Node addon longjmps out of the failed
+ * job) replaces the exit; if it returns, the default runs.
+ * @param handler Function to call first, or NULL for the default: print
+ *        "out of memory" and exit
+ */
+void set_out_of_memory_handler(void (*handler)(void));
+
+/**
+ * Report a failed allocation: call the handler, then print and exit
+ */
+void out_of_memory(void);
+
 #endif // DEADLOCK_DETECTOR_H
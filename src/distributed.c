@@ -0,0 +1,232 @@
+/*
+ * Deadlock Detection System
+ * Distributed edge-chasing detection on one host (make distributed)
+ *
+ * Forks N workers, hands each its partition of a generated or loaded state
+ * (see edge_chasing.h) and runs probe detection across them. The report is
+ * one JSON document on stdout: rounds, probe and control message counts and
+ * detection latency. With --verify the driver also builds the centralized
+ * RAG and checks that both agree on the processes that are on a cycle.
+ *
+ *   distributed_detect [--workers N] [--state FILE] [--size NPxNR]
+ *                      [--contention PCT] [--deadlock] [--cycle LEN]
+ *                      [--seed N] [--verify]
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "deadlock_detector.h"
+#include "edge_chasing.h"
+#include "json_writer.h"
+#include "rag.h"
+#include "stats.h"
+#include "text_reader.h"
+#include "workload.h"
+
+static void usage(const char *prog) {
+    fprintf(stderr, "usage: %s [--workers N] [--state FILE] [--size NPxNR] [--contention PCT] "
+            "[--deadlock] [--cycle LEN] [--seed N] [--verify]\n", prog);
+}
+
+static bool load_state(const char *path, SystemState *state) {
+    TextReader r;
+    if (!text_reader_open(&r, path)) {
+        fprintf(stderr, "%s: %s\n", path, strerror(errno));
+        return false;
+    }
+    const char *err = text_read_state(&r, state);
+    if (err) fprintf(stderr, "%s: %s\n", path, err);
+    text_reader_free(&r);
+    if (err) return false;
+    calculate_need_matrix(state);
+    return true;
+}
+
+// Centralized reference: detect_cycle_rag() and the processes in cycles
+static bool verify(SystemState *state, const ChaseResult *result, JsonWriter *out) {
+    RAG rag;
+    RagCycles cycles;
+    init_rag(&rag);
+    init_rag_cycles(&cycles);
+    long long start = stats_now_ns();
+    build_rag(state, &rag);
+    bool cycle = detect_cycle_rag(&rag);
+    long long detect_ns = stats_now_ns() - start;
+    find_rag_cycles(&rag, &cycles);
+
+    int np = state->num_processes;
+    bool *expected = checked_calloc((size_t)np, sizeof(bool));
+    int num_expected = 0;
+    for (int k = 0; k < cycles.offsets[cycles.num_cycles]; k++) {
+        if (cycles.nodes[k] < np) {
+            expected[cycles.nodes[k]] = true;
+            num_expected++;
+        }
+    }
+    bool match = num_expected == result->num_deadlocked && cycle == (num_expected > 0);
+    for (int k = 0; k < result->num_deadlocked && match; k++) {
+        match = expected[result->deadlocked[k]];
+    }
+
+    json_lit(out, ",\"centralized\":{\"cycle\":");
+    json_str(out, cycle ? "true" : "false");
+    json_lit(out, ",\"deadlocked\":");
+    json_int(out, num_expected);
+    json_lit(out, ",\"edges\":");
+    json_int(out, rag.num_edges);
+    json_lit(out, ",\"detect_ns\":");
+    json_ll(out, detect_ns);
+    json_lit(out, ",\"match\":");
+    json_str(out, match ? "true" : "false");
+    json_char(out, '}');
+
+    free(expected);
+    free_rag_cycles(&cycles);
+    free_rag(&rag);
+    return match;
+}
+
+static void write_report(JsonWriter *out, const SystemState *state, const ChaseResult *result,
+                         int workers, long long setup_ns) {
+    long long initiators = 0;
+    for (int w = 0; w < workers; w++) initiators += result->workers[w].initiators;
+    json_lit(out, "{\"workers\":");
+    json_int(out, workers);
+    json_lit(out, ",\"processes\":");
+    json_int(out, state->num_processes);
+    json_lit(out, ",\"resources\":");
+    json_int(out, state->num_resources);
+    json_lit(out, ",\"initiators\":");
+    json_ll(out, initiators);
+    json_lit(out, ",\"rounds\":");
+    json_int(out, result->rounds);
+    json_lit(out, ",\"probes_sent\":");
+    json_ll(out, result->probes_sent);
+    json_lit(out, ",\"probes_local\":");
+    json_ll(out, result->probes_local);
+    json_lit(out, ",\"bytes_sent\":");
+    json_ll(out, result->bytes_sent);
+    json_lit(out, ",\"control_messages\":");
+    json_ll(out, result->control_messages);
+    json_lit(out, ",\"setup_ns\":");
+    json_ll(out, setup_ns);
+    json_lit(out, ",\"first_detection_ns\":");
+    if (result->first_detection_ns < 0) json_lit(out, "null");
+    else json_ll(out, result->first_detection_ns);
+    json_lit(out, ",\"detection_ns\":");
+    json_ll(out, result->detection_ns);
+    json_lit(out, ",\"deadlocked\":[");
+    json_ints(out, result->deadlocked, result->num_deadlocked, ",", "");
+    json_lit(out, "],\"per_worker\":[");
+    for (int w = 0; w < workers; w++) {
+        const ChaseWorkerStats *s = &result->workers[w];
+        if (w > 0) json_char(out, ',');
+        json_lit(out, "{\"resources\":");
+        json_int(out, s->resources);
+        json_lit(out, ",\"processes\":");
+        json_int(out, s->processes);
+        json_lit(out, ",\"initiators\":");
+        json_int(out, s->initiators);
+        json_lit(out, ",\"probes_sent\":");
+        json_ll(out, s->probes_sent);
+        json_lit(out, ",\"probes_local\":");
+        json_ll(out, s->probes_local);
+        json_lit(out, ",\"probes_received\":");
+        json_ll(out, s->probes_received);
+        json_lit(out, ",\"bytes_sent\":");
+        json_ll(out, s->bytes_sent);
+        json_char(out, '}');
+    }
+    json_char(out, ']');
+}
+
+int main(int argc, char **argv) {
+    WorkloadParams params = { 64, 8, 10, false, 4, 1 };
+    int workers = 4;
+    const char *path = NULL;
+    bool check = false;
+
+    for (int a = 1; a < argc; a++) {
+        if (strcmp(argv[a], "--deadlock") == 0) {
+            params.deadlock = true;
+            continue;
+        }
+        if (strcmp(argv[a], "--verify") == 0) {
+            check = true;
+            continue;
+        }
+        const char *value = a + 1 < argc ? argv[a + 1] : NULL;
+        if (!value) {
+            usage(argv[0]);
+            return 1;
+        }
+        if (strcmp(argv[a], "--workers") == 0) {
+            workers = atoi(value);
+        } else if (strcmp(argv[a], "--state") == 0) {
+            path = value;
+        } else if (strcmp(argv[a], "--size") == 0) {
+            char *end;
+            params.num_processes = (int)strtol(value, &end, 10);
+            params.num_resources = *end == 'x' ? (int)strtol(end + 1, &end, 10) : 0;
+            if (*end) params.num_resources = 0;
+        } else if (strcmp(argv[a], "--contention") == 0) {
+            params.contention = atoi(value);
+        } else if (strcmp(argv[a], "--cycle") == 0) {
+            params.cycle_length = atoi(value);
+        } else if (strcmp(argv[a], "--seed") == 0) {
+            params.seed = strtoull(value, NULL, 10);
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+        a++;
+    }
+    if (workers < 1 || workers > CHASE_MAX_WORKERS) {
+        fprintf(stderr, "--workers must be 1..%d\n", CHASE_MAX_WORKERS);
+        return 1;
+    }
+
+    // Fork first: the workers only ever see their own partitions
+    ChaseCluster cluster;
+    if (!chase_spawn(&cluster, workers)) {
+        fprintf(stderr, "cannot start %d workers: %s\n", workers, strerror(errno));
+        return 1;
+    }
+
+    SystemState state;
+    bool loaded = path ? load_state(path, &state) : generate_workload(&state, &params);
+    if (!loaded) {
+        if (!path) fprintf(stderr, "cannot generate %dx%d\n", params.num_processes, params.num_resources);
+        chase_shutdown(&cluster);
+        return 1;
+    }
+
+    long long start = stats_now_ns();
+    ChaseResult result;
+    memset(&result, 0, sizeof(result));
+    bool ok = chase_distribute(&cluster, &state);
+    long long setup_ns = stats_now_ns() - start;
+    ok = ok && chase_run(&cluster, state.num_processes, &result);
+    ok = chase_shutdown(&cluster) && ok;
+    if (!ok) {
+        fprintf(stderr, "a worker failed\n");
+        chase_free_result(&result);
+        free_system_state(&state);
+        return 1;
+    }
+
+    JsonWriter out;
+    json_init(&out, 1);
+    write_report(&out, &state, &result, workers, setup_ns);
+    bool match = !check || verify(&state, &result, &out);
+    json_lit(&out, "}\n");
+    json_flush(&out);
+    json_free(&out);
+    if (!match) fprintf(stderr, "distributed and centralized cycles differ\n");
+
+    chase_free_result(&result);
+    free_system_state(&state);
+    return match ? 0 : 1;
+}
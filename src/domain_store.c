@@ -0,0 +1,334 @@
+/*
+ * Deadlock Detection System
+ * Named resource domains with RCU-style snapshots
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "domain_store.h"
+#include "state_hash.h"
+
+// Shared words are accessed with the GCC __atomic builtins. The pointer
+// swap, the epoch bump and the readers' announcements are sequentially
+// consistent, which is what makes a writer's scan of the reader slots see
+// every reader that could have loaded the old pointer.
+
+// The domain the calling thread holds the write lock of, and whether the
+// write has started to change its detector (see domain_write_abandon())
+static __thread Domain *writing;
+static __thread bool writing_master;
+
+static unsigned bucket_of(const char *name) {
+    uint32_t h = 2166136261u;  // FNV-1a
+    for (const char *c = name; *c; c++) {
+        h = (h ^ (unsigned char)*c) * 16777619u;
+    }
+    return h % DOMAIN_BUCKETS;
+}
+
+static Domain *find_domain(DomainStore *store, const char *name) {
+    Domain *d = __atomic_load_n(&store->buckets[bucket_of(name)], __ATOMIC_ACQUIRE);
+    while (d && strcmp(d->name, name) != 0) d = d->next;
+    return d;
+}
+
+static Domain *find_or_add_domain(DomainStore *store, const char *name) {
+    Domain *d = find_domain(store, name);
+    if (d) return d;
+    pthread_mutex_lock(&store->create_lock);
+    d = find_domain(store, name);
+    if (!d) {
+        d = calloc(1, sizeof(*d));
+        if (d) {
+            strcpy(d->name, name);
+            pthread_mutex_init(&d->write_lock, NULL);
+            unsigned b = bucket_of(name);
+            d->next = store->buckets[b];
+            __atomic_store_n(&store->buckets[b], d, __ATOMIC_RELEASE);
+        }
+    }
+    pthread_mutex_unlock(&store->create_lock);
+    return d;
+}
+
+static void free_snapshot(DomainSnapshot *snapshot) {
+    free_system_state(&snapshot->state);
+    free_detection_result(&snapshot->result);
+    free(snapshot);
+}
+
+// Copy available and every row, need included
+static bool copy_state(const SystemState *from, SystemState *to) {
+    int np = from->num_processes;
+    size_t row = (size_t)from->num_resources * sizeof(int);
+    if (!init_system_state(to, np, from->num_resources)) return false;
+    memcpy(to->available, from->available, row);
+    for (int i = 0; i < np; i++) {
+        memcpy(to->allocation[i], from->allocation[i], row);
+        memcpy(to->max_need[i], from->max_need[i], row);
+        memcpy(to->need[i], from->need[i], row);
+    }
+    return true;
+}
+
+static DomainSnapshot *make_snapshot(IncrementalDetector *master, long version) {
+    const DetectionResult *res = incremental_query(master);
+    DomainSnapshot *snapshot = calloc(1, sizeof(*snapshot));
+    if (!snapshot) return NULL;
+    if (!copy_state(&master->state, &snapshot->state)) {
+        free(snapshot);
+        return NULL;
+    }
+    size_t np = (size_t)master->state.num_processes;
+    DetectionResult *copy = &snapshot->result;
+    copy->is_deadlocked = res->is_deadlocked;
+    copy->deadlocked_processes = malloc((np + 1) * sizeof(int));
+    copy->safe_sequence = malloc((np + 1) * sizeof(int));
+    if (!copy->deadlocked_processes || !copy->safe_sequence) {
+        free_snapshot(snapshot);
+        return NULL;
+    }
+    copy->capacity = (int)np;
+    copy->num_deadlocked = res->num_deadlocked;
+    copy->safe_sequence_length = res->safe_sequence_length;
+    memcpy(copy->deadlocked_processes, res->deadlocked_processes,
+           (size_t)res->num_deadlocked * sizeof(int));
+    memcpy(copy->safe_sequence, res->safe_sequence,
+           (size_t)res->safe_sequence_length * sizeof(int));
+    snapshot->hash = state_hash(&snapshot->state);
+    snapshot->version = version;
+    return snapshot;
+}
+
+// Free the retired snapshots no reader can still hold. Only snapshots
+// stamped before the epoch read here are considered: a reader that could
+// hold one announced before its swap, so before this read and the scan
+// below. One retired later may be held by a reader the scan missed.
+static void reclaim(DomainStore *store) {
+    unsigned long oldest = __atomic_load_n(&store->epoch, __ATOMIC_SEQ_CST);
+    for (int k = 0; k < DOMAIN_MAX_READERS; k++) {
+        unsigned long e = __atomic_load_n(&store->readers[k].epoch, __ATOMIC_SEQ_CST);
+        if (e && e < oldest) oldest = e;
+    }
+    pthread_mutex_lock(&store->retire_lock);
+    DomainSnapshot **link = &store->retired;
+    while (*link) {
+        DomainSnapshot *snapshot = *link;
+        if (snapshot->retired < oldest) {
+            *link = snapshot->next_retired;
+            free_snapshot(snapshot);
+        } else {
+            link = &snapshot->next_retired;
+        }
+    }
+    pthread_mutex_unlock(&store->retire_lock);
+}
+
+// Swap in a new snapshot (or NULL) and retire the old one; write lock held
+static void publish(DomainStore *store, Domain *d, DomainSnapshot *snapshot) {
+    DomainSnapshot *old = __atomic_exchange_n(&d->current, snapshot, __ATOMIC_SEQ_CST);
+    if (old) {
+        // Readers that announced this epoch or an earlier one may hold old
+        old->retired = __atomic_fetch_add(&store->epoch, 1, __ATOMIC_SEQ_CST);
+        pthread_mutex_lock(&store->retire_lock);
+        old->next_retired = store->retired;
+        store->retired = old;
+        pthread_mutex_unlock(&store->retire_lock);
+    }
+    reclaim(store);
+}
+
+void domain_store_init(DomainStore *store) {
+    memset(store, 0, sizeof(*store));
+    store->epoch = 1;
+    pthread_mutex_init(&store->create_lock, NULL);
+    pthread_mutex_init(&store->retire_lock, NULL);
+}
+
+void domain_store_free(DomainStore *store) {
+    for (int b = 0; b < DOMAIN_BUCKETS; b++) {
+        Domain *d = store->buckets[b];
+        while (d) {
+            Domain *next = d->next;
+            if (d->current) free_snapshot(d->current);
+            if (d->live) incremental_free(&d->master);
+            pthread_mutex_destroy(&d->write_lock);
+            free(d);
+            d = next;
+        }
+    }
+    while (store->retired) {
+        DomainSnapshot *next = store->retired->next_retired;
+        free_snapshot(store->retired);
+        store->retired = next;
+    }
+    pthread_mutex_destroy(&store->create_lock);
+    pthread_mutex_destroy(&store->retire_lock);
+    memset(store, 0, sizeof(*store));
+}
+
+bool domain_name_valid(const char *name) {
+    size_t n = 0;
+    for (const char *c = name; *c; c++, n++) {
+        bool ok = (*c >= 'a' && *c <= 'z') || (*c >= 'A' && *c <= 'Z') ||
+                  (*c >= '0' && *c <= '9') || *c == '_' || *c == '.' || *c == '-' || *c == ':';
+        if (!ok) return false;
+    }
+    return n >= 1 && n < DOMAIN_NAME_LEN;
+}
+
+int domain_reader_register(DomainStore *store) {
+    for (int k = 0; k < DOMAIN_MAX_READERS; k++) {
+        int unused = 0;
+        if (__atomic_compare_exchange_n(&store->readers[k].used, &unused, 1, false,
+                                        __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+            return k;
+        }
+    }
+    return -1;
+}
+
+void domain_reader_unregister(DomainStore *store, int reader) {
+    __atomic_store_n(&store->readers[reader].epoch, 0, __ATOMIC_SEQ_CST);
+    __atomic_store_n(&store->readers[reader].used, 0, __ATOMIC_RELEASE);
+}
+
+const DomainSnapshot *domain_read_begin(DomainStore *store, int reader, const char *name) {
+    // Announce before loading: a writer that retires the snapshot loaded
+    // below bumps the epoch after its swap, so it sees this announcement
+    unsigned long e = __atomic_load_n(&store->epoch, __ATOMIC_SEQ_CST);
+    __atomic_store_n(&store->readers[reader].epoch, e, __ATOMIC_SEQ_CST);
+    Domain *d = find_domain(store, name);
+    return d ? __atomic_load_n(&d->current, __ATOMIC_SEQ_CST) : NULL;
+}
+
+void domain_read_end(DomainStore *store, int reader) {
+    __atomic_store_n(&store->readers[reader].epoch, 0, __ATOMIC_RELEASE);
+}
+
+bool domain_snapshot_copy(const DomainSnapshot *snapshot, SystemState *state) {
+    return copy_state(&snapshot->state, state);
+}
+
+DomainStatus domain_put(DomainStore *store, const char *name, const SystemState *state,
+                        long *version) {
+    Domain *d = find_or_add_domain(store, name);
+    if (!d) return DOMAIN_NO_MEMORY;
+    pthread_mutex_lock(&d->write_lock);
+    writing = d;
+    IncrementalDetector master;
+    DomainStatus status = DOMAIN_NO_MEMORY;
+    if (incremental_init(&master, state)) {
+        DomainSnapshot *snapshot = make_snapshot(&master, d->version + 1);
+        if (snapshot) {
+            if (d->live) incremental_free(&d->master);
+            d->master = master;
+            d->live = true;
+            *version = ++d->version;
+            publish(store, d, snapshot);
+            status = DOMAIN_OK;
+        } else {
+            incremental_free(&master);
+        }
+    }
+    writing = NULL;
+    pthread_mutex_unlock(&d->write_lock);
+    return status;
+}
+
+// Take back an event replay_apply() applied, given the claim it replaced.
+// Every step is the exact inverse of one the event made, so none can fail.
+static void undo_event(IncrementalDetector *det, const ReplayEvent *event, int claim) {
+    int p = event->process;
+    int r = event->resource;
+    switch (event->kind) {
+        case EVENT_ALLOCATE:
+            incremental_release(det, p, r, event->amount);
+            incremental_set_max(det, p, r, claim);
+            break;
+        case EVENT_RELEASE:
+            incremental_allocate(det, p, r, event->amount);
+            break;
+        default:
+            incremental_set_max(det, p, r, claim);
+    }
+}
+
+DomainStatus domain_update(DomainStore *store, const char *name, const ReplayEvent *events,
+                           int count, long *version, int *rejected) {
+    Domain *d = find_domain(store, name);
+    if (!d) return DOMAIN_UNKNOWN;
+    pthread_mutex_lock(&d->write_lock);
+    writing = d;
+    DomainStatus status = DOMAIN_OK;
+    if (!d->live) {
+        status = DOMAIN_UNKNOWN;
+    } else if (count == 0) {
+        *version = d->version;
+    } else {
+        // The claims the events replace, so a batch that fails can be undone
+        int *claims = malloc((size_t)count * sizeof(int));
+        int applied = 0;
+        if (!claims) status = DOMAIN_NO_MEMORY;
+        writing_master = true;
+        for (; status == DOMAIN_OK && applied < count; applied++) {
+            const ReplayEvent *e = &events[applied];
+            const SystemState *state = &d->master.state;
+            if (e->process >= 0 && e->process < state->num_processes &&
+                e->resource >= 0 && e->resource < state->num_resources) {
+                claims[applied] = state->max_need[e->process][e->resource];
+            }
+            if (!replay_apply(&d->master, e)) {
+                *rejected = applied;
+                status = DOMAIN_REJECTED;
+                break;
+            }
+        }
+        DomainSnapshot *snapshot = NULL;
+        if (status == DOMAIN_OK) {
+            snapshot = make_snapshot(&d->master, d->version + 1);
+            if (!snapshot) status = DOMAIN_NO_MEMORY;
+        }
+        if (snapshot) {
+            *version = ++d->version;
+            publish(store, d, snapshot);
+        } else {
+            // Back to the published state. Its result still holds; if the
+            // batch left the detector dirty, the next write detects again.
+            while (applied-- > 0) undo_event(&d->master, &events[applied], claims[applied]);
+        }
+        free(claims);
+        writing_master = false;
+    }
+    writing = NULL;
+    pthread_mutex_unlock(&d->write_lock);
+    return status;
+}
+
+bool domain_drop(DomainStore *store, const char *name) {
+    Domain *d = find_domain(store, name);
+    if (!d) return false;
+    pthread_mutex_lock(&d->write_lock);
+    bool was_live = d->live;
+    if (was_live) {
+        incremental_free(&d->master);
+        d->live = false;
+        publish(store, d, NULL);
+    }
+    pthread_mutex_unlock(&d->write_lock);
+    return was_live;
+}
+
+void domain_write_abandon(DomainStore *store) {
+    Domain *d = writing;
+    if (!d) return;
+    if (writing_master && d->live) {
+        // The detector may be half way through an event; it cannot be trusted
+        incremental_free(&d->master);
+        d->live = false;
+        publish(store, d, NULL);
+    }
+    writing = NULL;
+    writing_master = false;
+    pthread_mutex_unlock(&d->write_lock);
+}
@@ -0,0 +1,174 @@
+/*
+ * Deadlock Detection System
+ * Named resource domains with RCU-style snapshots header file
+ */
+
+#ifndef DOMAIN_STORE_H
+#define DOMAIN_STORE_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "deadlock_detector.h"
+#include "incremental.h"
+#include "replay.h"
+
+#define DOMAIN_NAME_LEN 64          // including the terminator
+#define DOMAIN_BUCKETS 1024         // hash chains (domains are never unlinked)
+#define DOMAIN_MAX_READERS 256      // threads that may read at the same time
+
+// An immutable view of one domain. Readers get a pointer to the latest one
+// and may use it until domain_read_end(); it is never written after it has
+// been published, and freed only once no reader can still hold it.
+typedef struct DomainSnapshot {
+    SystemState state;          // need calculated
+    DetectionResult result;     // the writer's incremental result for state
+    uint64_t hash;              // state_hash(&state)
+    long version;               // per domain: 1 for the first PUT, +1 per change
+    unsigned long retired;      // store use: epoch at which it was replaced
+    struct DomainSnapshot *next_retired;
+} DomainSnapshot;
+
+typedef struct Domain {
+    char name[DOMAIN_NAME_LEN];
+    DomainSnapshot *current;    // published snapshot, NULL while dropped
+    struct Domain *next;        // hash chain
+    pthread_mutex_t write_lock; // serializes this domain's writers
+    IncrementalDetector master; // writer's copy of the state (if live)
+    bool live;
+    long version;
+} Domain;
+
+// Announced epoch of one reader, alone on its cache line
+typedef struct {
+    unsigned long epoch;        // 0 while outside a read
+    int used;
+    char pad[64 - sizeof(unsigned long) - sizeof(int)];
+} DomainReader;
+
+// Store of named domains
+// Writers (domain_put/update/drop) build a new snapshot from the domain's
+// incremental detector under the domain's lock and publish it with one
+// atomic pointer swap; writers of other domains do not wait. Readers take
+// no lock: each announces the global epoch in its slot, loads the current
+// pointer, and clears the slot when done. A replaced snapshot is stamped
+// with the epoch it was replaced in and freed once the global epoch and
+// every announced epoch are later than that stamp (epoch-based
+// reclamation).
+typedef struct {
+    Domain *buckets[DOMAIN_BUCKETS];
+    unsigned long epoch;                     // global epoch, from 1
+    DomainReader readers[DOMAIN_MAX_READERS];
+    pthread_mutex_t create_lock;             // serializes adding domains
+    pthread_mutex_t retire_lock;             // guards retired
+    DomainSnapshot *retired;                 // replaced, not yet freed
+} DomainStore;
+
+typedef enum {
+    DOMAIN_OK,
+    DOMAIN_UNKNOWN,         // no such domain (or it was dropped)
+    DOMAIN_REJECTED,        // an event does not fit the state; nothing applied
+    DOMAIN_NO_MEMORY
+} DomainStatus;
+
+/**
+ * Initialize an empty store
+ * @param store Pointer to DomainStore
+ */
+void domain_store_init(DomainStore *store);
+
+/**
+ * Release every domain and snapshot (no reader may be active)
+ * @param store Pointer to DomainStore
+ */
+void domain_store_free(DomainStore *store);
+
+/**
+ * Whether a name can be used for a domain: 1 to DOMAIN_NAME_LEN - 1
+ * letters, digits or "_.-:"
+ */
+bool domain_name_valid(const char *name);
+
+/**
+ * Claim a reader slot for the calling thread
+ * @param store Pointer to DomainStore
+ * @return Slot index, or -1 if DOMAIN_MAX_READERS are taken
+ */
+int domain_reader_register(DomainStore *store);
+
+/**
+ * Give a reader slot back (outside a read)
+ * @param store Pointer to DomainStore
+ * @param reader Slot from domain_reader_register()
+ */
+void domain_reader_unregister(DomainStore *store, int reader);
+
+/**
+ * Start a read: the latest snapshot of a domain, valid until
+ * domain_read_end() even if writers replace it meanwhile
+ * @param store Pointer to DomainStore
+ * @param reader Slot from domain_reader_register()
+ * @param name Domain name
+ * @return Snapshot, or NULL for an unknown or dropped domain (the read
+ *         must still be ended)
+ */
+const DomainSnapshot *domain_read_begin(DomainStore *store, int reader, const char *name);
+
+/**
+ * End a read started by domain_read_begin()
+ * @param store Pointer to DomainStore
+ * @param reader Slot from domain_reader_register()
+ */
+void domain_read_end(DomainStore *store, int reader);
+
+/**
+ * Copy a snapshot's state (need included) for a command that modifies it
+ * @param snapshot Snapshot inside a read
+ * @param state Receives the copy (initialized here)
+ * @return false if memory is exhausted
+ */
+bool domain_snapshot_copy(const DomainSnapshot *snapshot, SystemState *state);
+
+/**
+ * Create a domain, or replace its whole state
+ * @param store Pointer to DomainStore
+ * @param name Valid domain name
+ * @param state State to copy (need is recalculated)
+ * @param version Receives the published version
+ */
+DomainStatus domain_put(DomainStore *store, const char *name, const SystemState *state,
+                        long *version);
+
+/**
+ * Apply events to a domain and publish the result as one snapshot
+ * The events are applied in order as by replay_apply(); if one does not
+ * fit, the ones before it are undone in reverse and none take effect.
+ * No events publish nothing and report the current version.
+ * @param store Pointer to DomainStore
+ * @param name Domain name
+ * @param events Events to apply
+ * @param count Number of events
+ * @param version Receives the published version
+ * @param rejected Receives the index of the event that did not fit
+ */
+DomainStatus domain_update(DomainStore *store, const char *name, const ReplayEvent *events,
+                           int count, long *version, int *rejected);
+
+/**
+ * Remove a domain; readers inside a read keep their snapshot
+ * @param store Pointer to DomainStore
+ * @param name Domain name
+ * @return false if there was no such domain
+ */
+bool domain_drop(DomainStore *store, const char *name);
+
+/**
+ * Leave the domain write the calling thread is in, for an out-of-memory
+ * handler that does not return: the domain's lock is released, and if the
+ * failure came while UPDATE events were being applied, the domain is
+ * dropped (its detector may be half updated). No-op outside a write.
+ * @param store Pointer to DomainStore
+ */
+void domain_write_abandon(DomainStore *store);
+
+#endif // DOMAIN_STORE_H
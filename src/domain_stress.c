@@ -0,0 +1,263 @@
+/*
+ * Deadlock Detection System
+ * Domain store stress test (make stress)
+ *
+ * Writer threads PUT, UPDATE and DROP a few domains while reader threads
+ * read them without locks, as the daemon's connections do. Every snapshot
+ * a reader gets is checked while it is held: its hash must match its state,
+ * its result must cover every process once, and a domain's versions must
+ * never go back. make stress builds with AddressSanitizer, so a snapshot
+ * freed while a reader still holds it stops the run.
+ *
+ *   domain_stress [--domains N] [--writers N] [--readers N] [--ops N] [--seed N]
+ *
+ * Prints one JSON object on stdout; exits 1 if any check failed.
+ */
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "domain_store.h"
+#include "json_writer.h"
+#include "state_hash.h"
+#include "stats.h"
+
+#define STRESS_MAX_DOMAINS 64
+#define STRESS_RESOURCES 3
+
+typedef struct {
+    DomainStore store;
+    int domains;
+    int ops;                    // writes per writer
+    int writers_left;
+    long long writes;
+    long long rejected;
+    long long reads;
+    long long misses;           // reads of a dropped or not yet created domain
+    long long errors;
+} Stress;
+
+typedef struct {
+    Stress *stress;
+    unsigned long long rng;
+} Worker;
+
+static unsigned next_random(Worker *w) {
+    w->rng ^= w->rng << 13;
+    w->rng ^= w->rng >> 7;
+    w->rng ^= w->rng << 17;
+    return (unsigned)(w->rng >> 32);
+}
+
+static void domain_name(char *name, int k) {
+    snprintf(name, DOMAIN_NAME_LEN, "stress-%d", k);
+}
+
+// A random state small enough that writes stay quick
+static bool random_state(Worker *w, SystemState *state) {
+    int np = 2 + (int)(next_random(w) % 24);
+    if (!init_system_state(state, np, STRESS_RESOURCES)) return false;
+    for (int j = 0; j < STRESS_RESOURCES; j++) {
+        state->available[j] = (int)(next_random(w) % 5);
+    }
+    for (int i = 0; i < np; i++) {
+        for (int j = 0; j < STRESS_RESOURCES; j++) {
+            int max = (int)(next_random(w) % 6);
+            state->max_need[i][j] = max;
+            state->allocation[i][j] = max ? (int)(next_random(w) % (unsigned)(max + 1)) : 0;
+        }
+    }
+    return true;
+}
+
+static void *writer_thread(void *arg) {
+    Worker *w = arg;
+    Stress *s = w->stress;
+    long long writes = 0;
+    long long rejected = 0;
+    long long errors = 0;
+    char name[DOMAIN_NAME_LEN];
+    for (int op = 0; op < s->ops; op++) {
+        domain_name(name, (int)(next_random(w) % (unsigned)s->domains));
+        unsigned pick = next_random(w) % 100;
+        long version;
+        if (pick < 25) {
+            SystemState state;
+            if (!random_state(w, &state)) {
+                errors++;
+                continue;
+            }
+            if (domain_put(&s->store, name, &state, &version) != DOMAIN_OK) errors++;
+            free_system_state(&state);
+        } else if (pick < 30) {
+            domain_drop(&s->store, name);
+        } else {
+            // Single units, so most events fit and some batches do not
+            ReplayEvent events[4];
+            int count = 1 + (int)(next_random(w) % 4);
+            for (int e = 0; e < count; e++) {
+                events[e].kind = next_random(w) % 2 ? EVENT_ALLOCATE : EVENT_RELEASE;
+                events[e].process = (int)(next_random(w) % 2);
+                events[e].resource = (int)(next_random(w) % STRESS_RESOURCES);
+                events[e].amount = 1;
+            }
+            int at;
+            DomainStatus status = domain_update(&s->store, name, events, count, &version, &at);
+            if (status == DOMAIN_REJECTED) rejected++;
+            else if (status == DOMAIN_NO_MEMORY) errors++;
+        }
+        writes++;
+    }
+    __atomic_add_fetch(&s->writes, writes, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&s->rejected, rejected, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&s->errors, errors, __ATOMIC_RELAXED);
+    __atomic_sub_fetch(&s->writers_left, 1, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+// Whether a held snapshot is intact
+static bool snapshot_valid(const DomainSnapshot *snapshot) {
+    const SystemState *state = &snapshot->state;
+    const DetectionResult *result = &snapshot->result;
+    int np = state->num_processes;
+    if (state_hash(state) != snapshot->hash) return false;
+    if (result->num_deadlocked + result->safe_sequence_length != np) return false;
+    if (result->is_deadlocked != (result->num_deadlocked > 0)) return false;
+    for (int k = 0; k < result->safe_sequence_length; k++) {
+        if (result->safe_sequence[k] < 0 || result->safe_sequence[k] >= np) return false;
+    }
+    for (int k = 0; k < result->num_deadlocked; k++) {
+        if (result->deadlocked_processes[k] < 0 || result->deadlocked_processes[k] >= np) return false;
+    }
+    return true;
+}
+
+static void *reader_thread(void *arg) {
+    Worker *w = arg;
+    Stress *s = w->stress;
+    long last[STRESS_MAX_DOMAINS] = {0};
+    long long reads = 0;
+    long long misses = 0;
+    long long errors = 0;
+    char name[DOMAIN_NAME_LEN];
+    int reader = domain_reader_register(&s->store);
+    if (reader < 0) {
+        __atomic_add_fetch(&s->errors, 1, __ATOMIC_RELAXED);
+        return NULL;
+    }
+    while (__atomic_load_n(&s->writers_left, __ATOMIC_ACQUIRE) > 0) {
+        int k = (int)(next_random(w) % (unsigned)s->domains);
+        domain_name(name, k);
+        const DomainSnapshot *snapshot = domain_read_begin(&s->store, reader, name);
+        if (snapshot) {
+            // Hold it while writers replace it, then check it
+            sched_yield();
+            if (!snapshot_valid(snapshot) || snapshot->version < last[k]) errors++;
+            last[k] = snapshot->version;
+        } else {
+            misses++;
+        }
+        domain_read_end(&s->store, reader);
+        reads++;
+        // Leave writers gaps with no reader active: a reader that announces
+        // just after a writer's scan is the case reclamation must get right
+        sched_yield();
+    }
+    domain_reader_unregister(&s->store, reader);
+    __atomic_add_fetch(&s->reads, reads, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&s->misses, misses, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&s->errors, errors, __ATOMIC_RELAXED);
+    return NULL;
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr, "usage: %s [--domains N] [--writers N] [--readers N] [--ops N] [--seed N]\n", prog);
+}
+
+int main(int argc, char **argv) {
+    int writers = 4;
+    int readers = 8;
+    unsigned long long seed = 1;
+    static Stress s;
+    s.domains = 4;
+    s.ops = 20000;
+
+    for (int a = 1; a < argc; a++) {
+        const char *value = a + 1 < argc ? argv[a + 1] : NULL;
+        if (!value) {
+            usage(argv[0]);
+            return 1;
+        }
+        if (strcmp(argv[a], "--domains") == 0) {
+            s.domains = atoi(value);
+        } else if (strcmp(argv[a], "--writers") == 0) {
+            writers = atoi(value);
+        } else if (strcmp(argv[a], "--readers") == 0) {
+            readers = atoi(value);
+        } else if (strcmp(argv[a], "--ops") == 0) {
+            s.ops = atoi(value);
+        } else if (strcmp(argv[a], "--seed") == 0) {
+            seed = strtoull(value, NULL, 10);
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+        a++;
+    }
+    if (s.domains < 1 || s.domains > STRESS_MAX_DOMAINS || writers < 1 ||
+        readers < 1 || readers > DOMAIN_MAX_READERS || s.ops < 0) {
+        fprintf(stderr, "--domains must be 1..%d, --writers at least 1, --readers 1..%d\n",
+                STRESS_MAX_DOMAINS, DOMAIN_MAX_READERS);
+        return 1;
+    }
+
+    domain_store_init(&s.store);
+    s.writers_left = writers;
+    int total = writers + readers;
+    pthread_t *threads = checked_malloc((size_t)total * sizeof(pthread_t));
+    Worker *workers = checked_malloc((size_t)total * sizeof(Worker));
+    long long start = stats_now_ns();
+    for (int t = 0; t < total; t++) {
+        workers[t].stress = &s;
+        workers[t].rng = (seed + (unsigned long long)t) * 0x9E3779B97F4A7C15ull | 1;
+        if (pthread_create(&threads[t], NULL, t < writers ? writer_thread : reader_thread,
+                           &workers[t]) != 0) {
+            fprintf(stderr, "cannot start thread %d\n", t);
+            return 1;
+        }
+    }
+    for (int t = 0; t < total; t++) {
+        pthread_join(threads[t], NULL);
+    }
+    long long elapsed_ns = stats_now_ns() - start;
+    domain_store_free(&s.store);
+
+    JsonWriter out;
+    json_init(&out, 1);
+    json_lit(&out, "{\"domains\":");
+    json_int(&out, s.domains);
+    json_lit(&out, ",\"writers\":");
+    json_int(&out, writers);
+    json_lit(&out, ",\"readers\":");
+    json_int(&out, readers);
+    json_lit(&out, ",\"writes\":");
+    json_ll(&out, s.writes);
+    json_lit(&out, ",\"rejected\":");
+    json_ll(&out, s.rejected);
+    json_lit(&out, ",\"reads\":");
+    json_ll(&out, s.reads);
+    json_lit(&out, ",\"misses\":");
+    json_ll(&out, s.misses);
+    json_lit(&out, ",\"errors\":");
+    json_ll(&out, s.errors);
+    json_lit(&out, ",\"elapsed_ns\":");
+    json_ll(&out, elapsed_ns);
+    json_lit(&out, "}\n");
+    json_flush(&out);
+    json_free(&out);
+    free(workers);
+    free(threads);
+    return s.errors ? 1 : 0;
+}
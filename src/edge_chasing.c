@@ -0,0 +1,742 @@
+/*
+ * Deadlock Detection System
+ * Distributed edge-chasing (Chandy-Misra-Haas) detection
+ */
+
+#define _POSIX_C_SOURCE 200809L  /* socketpair, fork */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "edge_chasing.h"
+#include "json_writer.h"
+#include "stats.h"
+
+// Control socket, driver to worker (int32 words):
+//   partition: num_processes num_resources num_workers self
+//              K, then K x (resource, holders, holder ids.., waiters, waiter ids..)
+//              H, then H x (process, sites, site ids..)
+//   then one command per round: CHASE_NEXT, or CHASE_STOP to end the run
+// Worker to driver, once per round (int64 words):
+//   round emitted resources processes initiators sent local received bytes
+//   found, then found process ids
+// After CHASE_STOP a worker waits for the next partition; EOF ends it.
+enum { CHASE_STOP = 0, CHASE_NEXT = 1 };
+#define REPORT_WORDS 10
+#define READ_CHUNK (1 << 16)
+
+// Seen-set roles: a home forwarded (initiator, process) to its sites, a site
+// sent (initiator, holder) a probe, or a site expanded (initiator, resource)
+enum { SEEN_HOME = 0, SEEN_SITE = 1, SEEN_RESOURCE = 2 };
+
+typedef struct {
+    int fd;
+    char buf[READ_CHUNK];
+    size_t pos, len;
+} FdReader;
+
+typedef struct {
+    int fd;
+    JsonWriter out;             // this round's records, written as poll allows
+    size_t written;
+    bool ended;                 // CHASE_END received this round
+    char pending[sizeof(ChaseMessage)];
+    size_t partial;             // bytes of a record split across reads
+} Peer;
+
+typedef struct {
+    ChaseMessage *items;
+    size_t count;
+    size_t capacity;
+} Queue;
+
+// Open-addressing set of (role, initiator, process or resource) keys, stored
+// plus one
+typedef struct {
+    uint64_t *keys;
+    size_t count;
+    size_t capacity;            // power of two, or 0
+} SeenSet;
+
+typedef struct {
+    int self;
+    int num_workers;
+    int num_processes;
+    // Site: the managed resources (by local index) and who waits for them
+    int num_owned;
+    int *holder_offsets;        // num_owned + 1
+    int *holders;
+    int *wait_offsets;          // num_processes + 1: local resources each waits for
+    int *wait_resources;
+    // Home: the sites each homed process waits at (empty for the others)
+    int *site_offsets;          // num_processes + 1
+    int *sites;
+    bool *detected;             // homed process found on a cycle
+    int *found;                 // detected this round
+    int num_found;
+    SeenSet seen;
+    Queue inbox;                // this round's input
+    Queue next;                 // received and local probes for the next round
+    Peer *peers;                // num_workers entries; peers[self] unused
+    long long emitted;          // probes emitted this round
+    ChaseWorkerStats stats;
+} Worker;
+
+static bool read_full(int fd, void *data, size_t n) {
+    char *p = data;
+    while (n > 0) {
+        ssize_t got = read(fd, p, n);
+        if (got < 0 && errno == EINTR) continue;
+        if (got <= 0) return false;
+        p += got;
+        n -= (size_t)got;
+    }
+    return true;
+}
+
+static bool write_full(int fd, const void *data, size_t n) {
+    const char *p = data;
+    while (n > 0) {
+        ssize_t put = write(fd, p, n);
+        if (put < 0 && errno == EINTR) continue;
+        if (put <= 0) return false;
+        p += put;
+        n -= (size_t)put;
+    }
+    return true;
+}
+
+// Next int32 from a buffered control socket; *eof is set if the stream
+// ended cleanly before it
+static bool read_word(FdReader *r, int32_t *value, bool *eof) {
+    while (r->len - r->pos < sizeof(*value)) {
+        size_t left = r->len - r->pos;
+        memmove(r->buf, r->buf + r->pos, left);
+        r->pos = 0;
+        r->len = left;
+        ssize_t got = read(r->fd, r->buf + left, sizeof(r->buf) - left);
+        if (got < 0 && errno == EINTR) continue;
+        if (got <= 0) {
+            if (eof) *eof = got == 0 && left == 0;
+            return false;
+        }
+        r->len += (size_t)got;
+    }
+    memcpy(value, r->buf + r->pos, sizeof(*value));
+    r->pos += sizeof(*value);
+    return true;
+}
+
+// A count or id in [0, limit)
+static bool read_index(FdReader *r, int limit, int *value) {
+    int32_t v;
+    if (!read_word(r, &v, NULL) || v < 0 || v >= limit) return false;
+    *value = v;
+    return true;
+}
+
+// realloc that exits when memory is exhausted, like checked_malloc
+static void *grow(void *data, size_t *capacity, size_t needed, size_t size) {
+    if (needed <= *capacity) return data;
+    *capacity = needed < 512 ? 1024 : needed * 2;
+    data = realloc(data, *capacity * size);
+    if (!data) {
+        fprintf(stderr, "out of memory\n");
+        exit(1);
+    }
+    return data;
+}
+
+static int *grow_ints(int *data, size_t *capacity, size_t needed) {
+    return grow(data, capacity, needed, sizeof(int));
+}
+
+static void queue_push(Queue *q, const ChaseMessage *m) {
+    q->items = grow(q->items, &q->capacity, q->count + 1, sizeof(ChaseMessage));
+    q->items[q->count++] = *m;
+}
+
+static size_t seen_slot(uint64_t key, size_t mask) {
+    uint64_t h = key * 0x9E3779B97F4A7C15ull;
+    return (size_t)(h ^ (h >> 29)) & mask;
+}
+
+// Add a key; false if it was already there
+static bool seen_add(SeenSet *s, int role, int initiator, int process) {
+    uint64_t key = ((((uint64_t)initiator << 32) | (uint32_t)process) << 2 | (uint64_t)role) + 1;
+    if ((s->count + 1) * 2 > s->capacity) {
+        size_t capacity = s->capacity ? s->capacity * 2 : 4096;
+        uint64_t *keys = checked_calloc(capacity, sizeof(*keys));
+        for (size_t k = 0; k < s->capacity; k++) {
+            if (!s->keys[k]) continue;
+            size_t at = seen_slot(s->keys[k], capacity - 1);
+            while (keys[at]) at = (at + 1) & (capacity - 1);
+            keys[at] = s->keys[k];
+        }
+        free(s->keys);
+        s->keys = keys;
+        s->capacity = capacity;
+    }
+    size_t mask = s->capacity - 1;
+    size_t at = seen_slot(key, mask);
+    while (s->keys[at]) {
+        if (s->keys[at] == key) return false;
+        at = (at + 1) & mask;
+    }
+    s->keys[at] = key;
+    s->count++;
+    return true;
+}
+
+static void free_partition(Worker *w) {
+    free(w->holder_offsets);
+    free(w->holders);
+    free(w->wait_offsets);
+    free(w->wait_resources);
+    free(w->site_offsets);
+    free(w->sites);
+    free(w->detected);
+    free(w->found);
+    free(w->seen.keys);
+    w->holder_offsets = w->holders = w->wait_offsets = w->wait_resources = NULL;
+    w->site_offsets = w->sites = w->found = NULL;
+    w->detected = NULL;
+    memset(&w->seen, 0, sizeof(w->seen));
+    w->inbox.count = w->next.count = 0;
+}
+
+// Read a partition and index it; 1 at a clean EOF, -1 on a protocol error
+static int read_partition(Worker *w, FdReader *r) {
+    int32_t header[4];
+    bool eof = false;
+    if (!read_word(r, &header[0], &eof)) return eof ? 1 : -1;
+    for (int k = 1; k < 4; k++) {
+        if (!read_word(r, &header[k], NULL)) return -1;
+    }
+    int np = header[0];
+    int nr = header[1];
+    if (np < 1 || nr < 1 || np > MAX_PROCESSES || nr > MAX_RESOURCES ||
+        header[2] != w->num_workers || header[3] != w->self) {
+        return -1;
+    }
+    w->num_processes = np;
+    memset(&w->stats, 0, sizeof(w->stats));
+
+    // Holders in CSR as they arrive; waits as (process, local resource)
+    // pairs, regrouped by process below
+    int owned;
+    if (!read_index(r, nr + 1, &owned)) return -1;
+    w->num_owned = owned;
+    w->stats.resources = owned;
+    w->holder_offsets = checked_malloc(((size_t)owned + 1) * sizeof(int));
+    w->holders = NULL;
+    int *pairs = NULL;
+    size_t num_holders = 0, holder_capacity = 0, num_pairs = 0, pair_capacity = 0;
+    w->holder_offsets[0] = 0;
+    for (int k = 0; k < owned; k++) {
+        int resource, count;
+        if (!read_index(r, nr, &resource) || !read_index(r, np + 1, &count)) goto fail;
+        w->holders = grow_ints(w->holders, &holder_capacity, num_holders + (size_t)count);
+        for (int h = 0; h < count; h++) {
+            if (!read_index(r, np, &w->holders[num_holders++])) goto fail;
+        }
+        w->holder_offsets[k + 1] = (int)num_holders;
+        if (!read_index(r, np + 1, &count)) goto fail;
+        pairs = grow_ints(pairs, &pair_capacity, num_pairs + 2 * (size_t)count);
+        for (int q = 0; q < count; q++) {
+            if (!read_index(r, np, &pairs[num_pairs])) goto fail;
+            pairs[num_pairs + 1] = k;
+            num_pairs += 2;
+        }
+    }
+    w->wait_offsets = checked_calloc((size_t)np + 1, sizeof(int));
+    w->wait_resources = checked_malloc((num_pairs / 2 + 1) * sizeof(int));
+    for (size_t q = 0; q < num_pairs; q += 2) w->wait_offsets[pairs[q] + 1]++;
+    for (int p = 0; p < np; p++) w->wait_offsets[p + 1] += w->wait_offsets[p];
+    int *fill = checked_malloc((size_t)np * sizeof(int));
+    memcpy(fill, w->wait_offsets, (size_t)np * sizeof(int));
+    for (size_t q = 0; q < num_pairs; q += 2) w->wait_resources[fill[pairs[q]]++] = pairs[q + 1];
+    free(fill);
+    free(pairs);
+    pairs = NULL;
+
+    int homed;
+    if (!read_index(r, np + 1, &homed)) goto fail;
+    w->site_offsets = checked_calloc((size_t)np + 1, sizeof(int));
+    w->sites = checked_malloc(((size_t)homed * w->num_workers + 1) * sizeof(int));
+    int num_sites = 0, last = -1;
+    for (int k = 0; k < homed; k++) {
+        int process, count;
+        if (!read_index(r, np, &process) || process <= last || process % w->num_workers != w->self ||
+            !read_index(r, w->num_workers + 1, &count)) {
+            goto fail;
+        }
+        for (int p = last + 1; p <= process; p++) w->site_offsets[p] = num_sites;
+        for (int s = 0; s < count; s++) {
+            if (!read_index(r, w->num_workers, &w->sites[num_sites++])) goto fail;
+        }
+        last = process;
+    }
+    for (int p = last + 1; p <= np; p++) w->site_offsets[p] = num_sites;
+    for (int p = w->self; p < np; p += w->num_workers) w->stats.processes++;
+    w->detected = checked_calloc((size_t)np, sizeof(bool));
+    w->found = checked_malloc((size_t)np * sizeof(int));
+    return 0;
+
+fail:
+    free(pairs);
+    free_partition(w);
+    return -1;
+}
+
+static void emit(Worker *w, int dest, ChaseKind kind, int initiator, int sender, int receiver) {
+    ChaseMessage m = { kind, initiator, sender, receiver };
+    if (dest == w->self) {
+        queue_push(&w->next, &m);
+        w->stats.probes_local++;
+    } else {
+        json_raw(&w->peers[dest].out, &m, sizeof(m));
+        w->stats.probes_sent++;
+        w->stats.bytes_sent += (long long)sizeof(m);
+    }
+    w->emitted++;
+}
+
+static void forward_to_sites(Worker *w, int initiator, int sender, int process) {
+    for (int s = w->site_offsets[process]; s < w->site_offsets[process + 1]; s++) {
+        emit(w, w->sites[s], CHASE_FORWARD, initiator, sender, process);
+    }
+}
+
+// Round 0: every blocked process homed here starts a probe
+static void initiate(Worker *w) {
+    for (int p = w->self; p < w->num_processes; p += w->num_workers) {
+        if (w->site_offsets[p] == w->site_offsets[p + 1]) continue;
+        w->stats.initiators++;
+        seen_add(&w->seen, SEEN_HOME, p, p);
+        forward_to_sites(w, p, p, p);
+    }
+}
+
+static void handle(Worker *w, const ChaseMessage *m) {
+    int i = m->initiator;
+    int k = m->receiver;
+    if (m->kind == CHASE_PROBE) {
+        if (k == i) {
+            if (!w->detected[i]) {
+                w->detected[i] = true;
+                w->found[w->num_found++] = i;
+            }
+        } else if (seen_add(&w->seen, SEEN_HOME, i, k)) {
+            forward_to_sites(w, i, m->sender, k);
+        }
+        return;
+    }
+    // FORWARD: k waits for these resources here; probe their holders. Once
+    // a resource is expanded for an initiator its holders all have the
+    // probe, so other waiters for it add nothing.
+    for (int q = w->wait_offsets[k]; q < w->wait_offsets[k + 1]; q++) {
+        int r = w->wait_resources[q];
+        if (!seen_add(&w->seen, SEEN_RESOURCE, i, r)) continue;
+        for (int h = w->holder_offsets[r]; h < w->holder_offsets[r + 1]; h++) {
+            int holder = w->holders[h];
+            if (seen_add(&w->seen, SEEN_SITE, i, holder)) {
+                emit(w, holder % w->num_workers, CHASE_PROBE, i, k, holder);
+            }
+        }
+    }
+}
+
+// Take the records of one read; false on a malformed record
+static bool deliver(Worker *w, Peer *p, const char *data, size_t n) {
+    while (n > 0) {
+        size_t take = sizeof(ChaseMessage) - p->partial;
+        if (take > n) take = n;
+        memcpy(p->pending + p->partial, data, take);
+        p->partial += take;
+        data += take;
+        n -= take;
+        if (p->partial < sizeof(ChaseMessage)) break;
+        p->partial = 0;
+        ChaseMessage m;
+        memcpy(&m, p->pending, sizeof(m));
+        if (m.kind == CHASE_END) {
+            p->ended = true;
+            return n == 0;
+        }
+        if ((m.kind != CHASE_PROBE && m.kind != CHASE_FORWARD) || m.initiator < 0 ||
+            m.initiator >= w->num_processes || m.receiver < 0 || m.receiver >= w->num_processes) {
+            return false;
+        }
+        // A PROBE comes to the receiver's home; a FORWARD to one of its sites
+        if (m.kind == CHASE_PROBE && m.receiver % w->num_workers != w->self) return false;
+        queue_push(&w->next, &m);
+        w->stats.probes_received++;
+    }
+    return true;
+}
+
+// Send this round's records and an END to every peer while collecting
+// theirs; writes and reads interleave so full socket buffers cannot stall
+// two workers writing to each other
+static bool exchange(Worker *w) {
+    static const ChaseMessage end = { CHASE_END, 0, 0, 0 };
+    struct pollfd fds[CHASE_MAX_WORKERS];
+    int index[CHASE_MAX_WORKERS];
+    char buf[READ_CHUNK];
+
+    for (int v = 0; v < w->num_workers; v++) {
+        if (v == w->self) continue;
+        json_raw(&w->peers[v].out, &end, sizeof(end));
+        w->stats.bytes_sent += (long long)sizeof(end);
+        w->peers[v].ended = false;
+    }
+    for (;;) {
+        int n = 0;
+        for (int v = 0; v < w->num_workers; v++) {
+            Peer *p = &w->peers[v];
+            if (v == w->self) continue;
+            short events = (short)((p->written < p->out.length ? POLLOUT : 0) | (p->ended ? 0 : POLLIN));
+            if (!events) continue;
+            fds[n].fd = p->fd;
+            fds[n].events = events;
+            fds[n].revents = 0;
+            index[n++] = v;
+        }
+        if (n == 0) return true;
+        if (poll(fds, (nfds_t)n, -1) < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        for (int k = 0; k < n; k++) {
+            Peer *p = &w->peers[index[k]];
+            if (fds[k].revents & POLLOUT) {
+                ssize_t put = write(p->fd, p->out.data + p->written, p->out.length - p->written);
+                if (put < 0 && errno != EAGAIN && errno != EINTR) return false;
+                if (put > 0) p->written += (size_t)put;
+                if (p->written == p->out.length) {
+                    json_reset(&p->out);
+                    p->written = 0;
+                }
+            }
+            if ((fds[k].revents & (POLLIN | POLLHUP | POLLERR)) && !p->ended) {
+                ssize_t got = read(p->fd, buf, sizeof(buf));
+                if (got == 0) return false;  // a peer went away mid-run
+                if (got < 0) {
+                    if (errno == EAGAIN || errno == EINTR) continue;
+                    return false;
+                }
+                if (!deliver(w, p, buf, (size_t)got)) return false;
+            }
+        }
+    }
+}
+
+static bool report(Worker *w, int control, int round) {
+    int64_t words[REPORT_WORDS] = {
+        round, w->emitted, w->stats.resources, w->stats.processes, w->stats.initiators,
+        w->stats.probes_sent, w->stats.probes_local, w->stats.probes_received,
+        w->stats.bytes_sent, w->num_found
+    };
+    JsonWriter out;
+    json_init(&out, control);
+    json_raw(&out, words, sizeof(words));
+    for (int k = 0; k < w->num_found; k++) {
+        int64_t id = w->found[k];
+        json_raw(&out, &id, sizeof(id));
+    }
+    bool ok = json_flush(&out);
+    json_free(&out);
+    return ok;
+}
+
+// Body of a forked worker: runs until the driver closes the control socket
+static int worker_main(int control, const int *peer_fds, int num_workers, int self) {
+    Worker w;
+    memset(&w, 0, sizeof(w));
+    w.self = self;
+    w.num_workers = num_workers;
+    w.peers = checked_calloc((size_t)num_workers, sizeof(Peer));
+    for (int v = 0; v < num_workers; v++) {
+        if (v == self) continue;
+        w.peers[v].fd = peer_fds[v];
+        json_init(&w.peers[v].out, -1);
+        fcntl(peer_fds[v], F_SETFL, fcntl(peer_fds[v], F_GETFL) | O_NONBLOCK);
+    }
+    FdReader *r = checked_malloc(sizeof(*r));
+    r->fd = control;
+    r->pos = r->len = 0;
+
+    int status = 0;
+    for (;;) {
+        int loaded = read_partition(&w, r);
+        if (loaded != 0) {
+            status = loaded > 0 ? 0 : 1;
+            break;
+        }
+        for (int round = 0;; round++) {
+            int32_t command;
+            if (!read_word(r, &command, NULL)) {
+                status = 1;
+                break;
+            }
+            if (command == CHASE_STOP) break;
+            w.emitted = 0;
+            w.num_found = 0;
+            if (round == 0) {
+                initiate(&w);
+            } else {
+                // This round's input is what arrived in the last exchange
+                Queue swap = w.inbox;
+                w.inbox = w.next;
+                w.next = swap;
+                w.next.count = 0;
+                for (size_t k = 0; k < w.inbox.count; k++) handle(&w, &w.inbox.items[k]);
+            }
+            if (!exchange(&w) || !report(&w, control, round)) {
+                status = 1;
+                break;
+            }
+        }
+        free_partition(&w);
+        if (status != 0) break;
+    }
+    for (int v = 0; v < num_workers; v++) {
+        if (v != self) json_free(&w.peers[v].out);
+    }
+    free(w.peers);
+    free(w.inbox.items);
+    free(w.next.items);
+    free(r);
+    return status;
+}
+
+static void close_all(int *fds, int count) {
+    for (int k = 0; k < count; k++) {
+        if (fds[k] >= 0) close(fds[k]);
+        fds[k] = -1;
+    }
+}
+
+bool chase_spawn(ChaseCluster *cluster, int num_workers) {
+    memset(cluster, 0, sizeof(*cluster));
+    if (num_workers < 1 || num_workers > CHASE_MAX_WORKERS) return false;
+    int n = num_workers;
+    // control[w] is the driver's end, child[w] the worker's; mesh[a * n + b]
+    // is a's end of the (a, b) socketpair
+    int *control = checked_malloc((size_t)n * sizeof(int));
+    int *child = checked_malloc((size_t)n * sizeof(int));
+    int *mesh = checked_malloc((size_t)n * n * sizeof(int));
+    pid_t *pids = checked_calloc((size_t)n, sizeof(pid_t));
+    for (int k = 0; k < n; k++) control[k] = child[k] = -1;
+    for (int k = 0; k < n * n; k++) mesh[k] = -1;
+
+    bool ok = true;
+    for (int a = 0; a < n && ok; a++) {
+        int pair[2];
+        ok = socketpair(AF_UNIX, SOCK_STREAM, 0, pair) == 0;
+        if (ok) {
+            control[a] = pair[0];
+            child[a] = pair[1];
+        }
+        for (int b = a + 1; b < n && ok; b++) {
+            ok = socketpair(AF_UNIX, SOCK_STREAM, 0, pair) == 0;
+            if (ok) {
+                mesh[a * n + b] = pair[0];
+                mesh[b * n + a] = pair[1];
+            }
+        }
+    }
+    int started = 0;
+    fflush(NULL);  // a child must not inherit buffered output
+    while (ok && started < n) {
+        int self = started;
+        pid_t pid = fork();
+        if (pid < 0) {
+            ok = false;
+            break;
+        }
+        if (pid == 0) {
+            // Keep only this worker's control end and its row of the mesh
+            for (int k = 0; k < n; k++) {
+                close(control[k]);
+                if (k != self) close(child[k]);
+            }
+            for (int a = 0; a < n; a++) {
+                for (int b = 0; b < n; b++) {
+                    if (a != self && mesh[a * n + b] >= 0) close(mesh[a * n + b]);
+                }
+            }
+            _exit(worker_main(child[self], mesh + self * n, n, self));
+        }
+        pids[started++] = pid;
+    }
+    close_all(child, n);
+    close_all(mesh, n * n);
+    free(child);
+    free(mesh);
+    cluster->num_workers = started;
+    cluster->pids = pids;
+    cluster->control = control;
+    if (!ok) {
+        close_all(control + started, n - started);
+        chase_shutdown(cluster);
+    }
+    return ok;
+}
+
+static void put_word(JsonWriter *out, int32_t value) {
+    json_raw(out, &value, sizeof(value));
+}
+
+bool chase_distribute(ChaseCluster *cluster, const SystemState *state) {
+    int n = cluster->num_workers;
+    int np = state->num_processes;
+    int nr = state->num_resources;
+    bool ok = true;
+    int *list = checked_malloc((size_t)np * sizeof(int));
+    bool *at = checked_malloc((size_t)n * sizeof(bool));
+    for (int w = 0; w < n && ok; w++) {
+        JsonWriter out;
+        json_init(&out, cluster->control[w]);
+        put_word(&out, np);
+        put_word(&out, nr);
+        put_word(&out, n);
+        put_word(&out, w);
+        put_word(&out, nr / n + (w < nr % n));
+        for (int r = w; r < nr; r += n) {
+            put_word(&out, r);
+            int count = 0;
+            for (int p = 0; p < np; p++) {
+                if (state->allocation[p][r] > 0) list[count++] = p;
+            }
+            put_word(&out, count);
+            json_raw(&out, list, (size_t)count * sizeof(int));
+            count = 0;
+            for (int p = 0; p < np; p++) {
+                if (state->need[p][r] > 0) list[count++] = p;
+            }
+            put_word(&out, count);
+            json_raw(&out, list, (size_t)count * sizeof(int));
+            json_drain(&out);
+        }
+        put_word(&out, np / n + (w < np % n));
+        for (int p = w; p < np; p += n) {
+            memset(at, 0, (size_t)n * sizeof(bool));
+            int count = 0;
+            for (int r = 0; r < nr; r++) {
+                if (state->need[p][r] > 0 && !at[r % n]) {
+                    at[r % n] = true;
+                    list[count++] = r % n;
+                }
+            }
+            put_word(&out, p);
+            put_word(&out, count);
+            json_raw(&out, list, (size_t)count * sizeof(int));
+            json_drain(&out);
+        }
+        ok = json_flush(&out);
+        json_free(&out);
+    }
+    free(list);
+    free(at);
+    return ok;
+}
+
+static bool send_command(ChaseCluster *cluster, int32_t command) {
+    bool ok = true;
+    for (int w = 0; w < cluster->num_workers; w++) {
+        ok = write_full(cluster->control[w], &command, sizeof(command)) && ok;
+    }
+    return ok;
+}
+
+bool chase_run(ChaseCluster *cluster, int num_processes, ChaseResult *result) {
+    int n = cluster->num_workers;
+    memset(result, 0, sizeof(*result));
+    result->first_detection_ns = -1;
+    result->workers = checked_calloc((size_t)n, sizeof(ChaseWorkerStats));
+    bool *on_cycle = checked_calloc((size_t)num_processes, sizeof(bool));
+    bool ok = true;
+
+    long long start = stats_now_ns();
+    for (int round = 0; ok; round++) {
+        ok = send_command(cluster, CHASE_NEXT);
+        result->control_messages += n;
+        long long emitted = 0;
+        for (int w = 0; w < n && ok; w++) {
+            int64_t words[REPORT_WORDS];
+            ok = read_full(cluster->control[w], words, sizeof(words)) && words[0] == round &&
+                 words[9] >= 0 && words[9] <= num_processes;
+            if (!ok) break;
+            emitted += words[1];
+            ChaseWorkerStats *s = &result->workers[w];
+            s->resources = (int)words[2];
+            s->processes = (int)words[3];
+            s->initiators = (int)words[4];
+            s->probes_sent = words[5];
+            s->probes_local = words[6];
+            s->probes_received = words[7];
+            s->bytes_sent = words[8];
+            for (int64_t k = 0; k < words[9] && ok; k++) {
+                int64_t id;
+                ok = read_full(cluster->control[w], &id, sizeof(id)) && id >= 0 && id < num_processes;
+                if (ok) on_cycle[id] = true;
+            }
+            if (ok && words[9] > 0 && result->first_detection_ns < 0) {
+                result->first_detection_ns = stats_now_ns() - start;
+            }
+        }
+        result->control_messages += n + (long long)n * (n - 1);
+        result->rounds = round + 1;
+        if (ok && emitted == 0) break;
+    }
+    result->detection_ns = stats_now_ns() - start;
+    if (ok) {
+        ok = send_command(cluster, CHASE_STOP);
+        result->control_messages += n;
+    }
+
+    for (int w = 0; w < n; w++) {
+        result->probes_sent += result->workers[w].probes_sent;
+        result->probes_local += result->workers[w].probes_local;
+        result->bytes_sent += result->workers[w].bytes_sent;
+    }
+    result->deadlocked = checked_malloc(((size_t)num_processes + 1) * sizeof(int));
+    for (int p = 0; p < num_processes; p++) {
+        if (on_cycle[p]) result->deadlocked[result->num_deadlocked++] = p;
+    }
+    free(on_cycle);
+    return ok;
+}
+
+bool chase_shutdown(ChaseCluster *cluster) {
+    bool ok = true;
+    close_all(cluster->control, cluster->num_workers);
+    for (int w = 0; w < cluster->num_workers; w++) {
+        int status;
+        while (waitpid(cluster->pids[w], &status, 0) < 0) {
+            if (errno != EINTR) {
+                status = -1;
+                break;
+            }
+        }
+        ok = ok && status == 0;
+    }
+    free(cluster->control);
+    free(cluster->pids);
+    memset(cluster, 0, sizeof(*cluster));
+    return ok;
+}
+
+void chase_free_result(ChaseResult *result) {
+    free(result->deadlocked);
+    free(result->workers);
+    memset(result, 0, sizeof(*result));
+}
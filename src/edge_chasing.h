@@ -0,0 +1,123 @@
+/*
+ * Deadlock Detection System
+ * Distributed edge-chasing (Chandy-Misra-Haas) detection header file
+ */
+
+#ifndef EDGE_CHASING_H
+#define EDGE_CHASING_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include "deadlock_detector.h"
+
+#define CHASE_MAX_WORKERS 64
+
+// The RAG is split across worker processes and never assembled in one.
+// Worker w is the manager ("site") of the resources r with r % N == w: it
+// knows their holders (allocation > 0) and waiters (need > 0). It is also
+// the home of the processes p with p % N == w, and knows at which sites each
+// of them waits, as a blocked process knows whom it asked.
+//
+// Detection chases CMH probes (initiator, sender, receiver) along the
+// wait-for edges P -> R -> P'. Every blocked process initiates; its home
+// sends FORWARD to each site it waits at. A site expands FORWARD(i, j, k)
+// over the resources k waits for there and sends PROBE(i, k, h) to the home
+// of every holder h. A home that receives PROBE(i, j, i) has found i on a
+// cycle; otherwise it passes the probe on as FORWARD to the sites of its
+// receiver. Homes and sites pass each (initiator, process) pair on once,
+// and sites expand each (initiator, resource) once, so a run sends
+// O(initiators * processes * N) probes at most.
+//
+// Probes travel in rounds: a worker handles the previous round's probes,
+// sends the new ones to its peers followed by CHASE_END, and has the next
+// round's input once it holds an END from every peer. It then reports to
+// the driver, which stops the run after a round that sent no probe. The
+// processes on a cycle are exactly those find_rag_cycles() puts in a cycle.
+
+typedef enum {
+    CHASE_PROBE = 1,    // to the home of receiver
+    CHASE_FORWARD,      // to a site where receiver waits
+    CHASE_END           // no more probes from this peer this round
+} ChaseKind;
+
+// Worker-to-worker record; socketpairs on one host, so host byte order
+typedef struct {
+    int32_t kind;
+    int32_t initiator;
+    int32_t sender;
+    int32_t receiver;
+} ChaseMessage;
+
+// Per-worker totals over a run
+typedef struct {
+    int resources;              // managed by this worker
+    int processes;              // homed at this worker
+    int initiators;             // blocked processes that started a probe
+    long long probes_sent;      // to other workers
+    long long probes_local;     // handled without leaving the worker
+    long long probes_received;
+    long long bytes_sent;       // probes and END markers
+} ChaseWorkerStats;
+
+// A forked set of workers, full mesh over AF_UNIX socketpairs
+typedef struct {
+    int num_workers;
+    pid_t *pids;
+    int *control;               // driver's end of each worker's control socket
+} ChaseCluster;
+
+// Outcome of chase_run()
+typedef struct {
+    int rounds;
+    long long probes_sent;
+    long long probes_local;
+    long long bytes_sent;
+    long long control_messages; // END markers, reports and round commands
+    long long first_detection_ns; // from the start of round 0; -1 if none
+    long long detection_ns;     // until the quiet round was reported
+    int num_deadlocked;
+    int *deadlocked;            // ascending process ids on a cycle
+    ChaseWorkerStats *workers;  // num_workers entries
+} ChaseResult;
+
+/**
+ * Fork the workers and connect every pair of them
+ * Call before loading the state, so no worker inherits it.
+ * @param cluster Receives the workers
+ * @param num_workers Number of workers (1..CHASE_MAX_WORKERS)
+ * @return false if a socket or fork failed (workers already started are stopped)
+ */
+bool chase_spawn(ChaseCluster *cluster, int num_workers);
+
+/**
+ * Give every worker its partition of a state
+ * @param cluster Workers from chase_spawn()
+ * @param state State with need calculated
+ * @return false if a worker went away
+ */
+bool chase_distribute(ChaseCluster *cluster, const SystemState *state);
+
+/**
+ * Run detection to quiescence
+ * @param cluster Workers that hold their partitions
+ * @param num_processes Processes in the distributed state
+ * @param result Receives the outcome (release with chase_free_result)
+ * @return false if a worker went away or sent a malformed report
+ */
+bool chase_run(ChaseCluster *cluster, int num_processes, ChaseResult *result);
+
+/**
+ * Stop the workers and wait for them
+ * @param cluster Workers from chase_spawn()
+ * @return false if a worker did not exit cleanly
+ */
+bool chase_shutdown(ChaseCluster *cluster);
+
+/**
+ * Release memory owned by a result
+ * @param result Pointer to ChaseResult
+ */
+void chase_free_result(ChaseResult *result);
+
+#endif // EDGE_CHASING_H
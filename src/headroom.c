@@ -0,0 +1,155 @@
+/*
+ * Deadlock Detection System
+ * Safe-grant headroom for every (process, resource) pair
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "headroom.h"
+#include "simd_kernels.h"
+
+// Scratch shared by the probes of one compute_headroom() call
+typedef struct {
+    SystemState *state;
+    const int *sequence;    // base safe sequence
+    const int *work;        // work[k * stride]: Work before sequence[k] runs
+    int *position;          // index of each process in the sequence
+    int *pending;           // processes still to finish in a probe
+    int *probe_work;
+} Headroom;
+
+// Is the state still safe after granting amount of resource j to process p?
+// With p < 0 the units are only taken out of Available, which is harder to
+// survive than granting them to any one process.
+static bool grant_is_safe(Headroom *h, int p, int j, int amount) {
+    SystemState *state = h->state;
+    int np = state->num_processes;
+    int stride = state->row_stride;
+    int last = p < 0 ? np - 1 : h->position[p];
+
+    // The base sequence holds up to the first step that no longer fits
+    int m = 0;
+    while (m < last &&
+           h->work[(size_t)m * stride + j] - state->need[h->sequence[m]][j] >= amount) {
+        m++;
+    }
+
+    memcpy(h->probe_work, h->work + (size_t)m * stride, (size_t)stride * sizeof(int));
+    h->probe_work[j] -= amount;
+    if (p >= 0) {
+        state->need[p][j] -= amount;
+        state->allocation[p][j] += amount;
+    }
+
+    // Finish the rest in passes, keeping the base order. Once sequence[m..last]
+    // are all done, Work is at least the base Work after step last and the
+    // base sequence finishes the others, so stop there.
+    int length = np - m;
+    int window = last - m + 1;
+    memcpy(h->pending, h->sequence + m, (size_t)length * sizeof(int));
+    bool progress = true;
+    while (window > 0 && progress) {
+        progress = false;
+        int kept = 0;
+        for (int k = 0; k < length; k++) {
+            int q = h->pending[k];
+            if (window > 0 && vec_all_le(state->need[q], h->probe_work, stride)) {
+                vec_add(h->probe_work, state->allocation[q], stride);
+                if (h->position[q] <= last) window--;
+                progress = true;
+            } else {
+                h->pending[kept++] = q;
+            }
+        }
+        length = kept;
+    }
+
+    if (p >= 0) {
+        state->need[p][j] += amount;
+        state->allocation[p][j] -= amount;
+    }
+    return window == 0;
+}
+
+bool compute_headroom(SystemState *state, int *headroom) {
+    int np = state->num_processes;
+    int nr = state->num_resources;
+    int stride = state->row_stride;
+    memset(headroom, 0, (size_t)np * nr * sizeof(int));
+
+    calculate_need_matrix(state);
+    DetectionResult result;
+    init_detection_result(&result);
+    detect_deadlock(state, &result);
+    if (result.is_deadlocked) {
+        free_detection_result(&result);
+        return false;
+    }
+
+    Headroom h;
+    h.state = state;
+    h.sequence = result.safe_sequence;
+    int *work = checked_malloc(((size_t)np + 1) * stride * sizeof(int));
+    int *slack = checked_malloc((size_t)stride * sizeof(int));
+    h.work = work;
+    h.position = checked_malloc((size_t)np * sizeof(int));
+    h.pending = checked_malloc((size_t)np * sizeof(int));
+    h.probe_work = checked_malloc((size_t)stride * sizeof(int));
+
+    // Walk the sequence once: Work before each step, and for each step the
+    // least slack (Work - Need) of the steps before it. A grant no larger
+    // than that slack leaves the whole sequence valid.
+    memcpy(work, state->available, (size_t)stride * sizeof(int));
+    memcpy(slack, state->available, (size_t)stride * sizeof(int));
+    for (int k = 0; k < np; k++) {
+        int p = h.sequence[k];
+        const int *w = work + (size_t)k * stride;
+        h.position[p] = k;
+        for (int j = 0; j < nr; j++) {
+            int bound = state->need[p][j] < slack[j] ? state->need[p][j] : slack[j];
+            headroom[(size_t)p * nr + j] = bound > 0 ? bound : 0;
+            if (w[j] - state->need[p][j] < slack[j]) {
+                slack[j] = w[j] - state->need[p][j];
+            }
+        }
+        memcpy(work + (size_t)(k + 1) * stride, w, (size_t)stride * sizeof(int));
+        vec_add(work + (size_t)(k + 1) * stride, state->allocation[p], stride);
+    }
+
+    // Units of each resource the state survives losing: a floor for every
+    // process, found with one search per resource instead of one per cell
+    for (int j = 0; j < nr; j++) {
+        int hi = state->available[j] > 0 ? state->available[j] : 0;
+        int lo = slack[j] < 0 ? 0 : slack[j] < hi ? slack[j] : hi;
+        while (lo < hi) {
+            int mid = lo + (hi - lo + 1) / 2;
+            if (grant_is_safe(&h, -1, j, mid)) lo = mid;
+            else hi = mid - 1;
+        }
+        slack[j] = lo;
+    }
+
+    // Binary search the cells whose ceiling is above the bounds
+    for (int p = 0; p < np; p++) {
+        for (int j = 0; j < nr; j++) {
+            int hi = state->need[p][j] < state->available[j] ? state->need[p][j] : state->available[j];
+            if (hi < 0) hi = 0;
+            int lo = headroom[(size_t)p * nr + j];
+            if (lo < slack[j]) lo = slack[j] < hi ? slack[j] : hi;
+            while (lo < hi) {
+                int mid = lo + (hi - lo + 1) / 2;
+                if (grant_is_safe(&h, p, j, mid)) lo = mid;
+                else hi = mid - 1;
+            }
+            headroom[(size_t)p * nr + j] = lo;
+        }
+    }
+
+    free(work);
+    free(slack);
+    free(h.position);
+    free(h.pending);
+    free(h.probe_work);
+    free_detection_result(&result);
+    return true;
+}
@@ -0,0 +1,32 @@
+/*
+ * Deadlock Detection System
+ * Safe-grant headroom: the largest safe request for every (process, resource)
+ */
+
+#ifndef HEADROOM_H
+#define HEADROOM_H
+
+#include <stdbool.h>
+#include "deadlock_detector.h"
+
+/**
+ * Largest amount of each resource that could be granted to each process
+ * (one request at a time, as SIMULATE would) with the state staying safe
+ *
+ * Granting never makes a state safer, so the answer is monotone in the
+ * amount. One detection yields a safe sequence S; a grant to S[k] keeps S
+ * valid while it fits the slack of every step before k, which bounds each
+ * cell from below in O(1); so does the number of units of a resource the
+ * state survives losing, searched once per resource. Cells with room above
+ * both bounds are binary searched, each probe keeping the prefix of S that
+ * still fits and only re-checking the steps up to k.
+ *
+ * @param state System state; the need matrix is recalculated, and the
+ *        matrices are restored before returning
+ * @param headroom Output, num_processes * num_resources row-major; all zero
+ *        when the state is unsafe
+ * @return true if the current state is safe
+ */
+bool compute_headroom(SystemState *state, int *headroom);
+
+#endif // HEADROOM_H
@@ -0,0 +1,150 @@
+/*
+ * Deadlock Detection System
+ * Incremental (delta-driven) deadlock detector
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "incremental.h"
+
+static bool in_range(const IncrementalDetector *det, int p, int r) {
+    return p >= 0 && p < det->state.num_processes &&
+           r >= 0 && r < det->state.num_resources;
+}
+
+// Full detection; rebuild positions and slack when the state is safe
+static void recompute(IncrementalDetector *det) {
+    SystemState *state = &det->state;
+    int np = state->num_processes;
+    int nr = state->num_resources;
+
+    detect_deadlock(state, &det->result);
+    det->full_runs++;
+    det->dirty = false;
+    if (det->result.is_deadlocked) {
+        return;
+    }
+
+    int *work = checked_malloc((size_t)nr * sizeof(int));
+    memcpy(work, state->available, (size_t)nr * sizeof(int));
+    for (int t = 0; t < np; t++) {
+        int p = det->result.safe_sequence[t];
+        det->position[p] = t;
+        for (int r = 0; r < nr; r++) {
+            det->slack[(size_t)r * np + t] = work[r] - state->need[p][r];
+            work[r] += state->allocation[p][r];
+        }
+    }
+    free(work);
+}
+
+// Add delta to the slack of every process ahead of p in column r;
+// returns false if one of them can no longer run
+static bool shift_prefix(IncrementalDetector *det, int p, int r, int delta) {
+    int *column = det->slack + (size_t)r * det->state.num_processes;
+    int end = det->position[p];
+    bool ok = true;
+    for (int t = 0; t < end; t++) {
+        column[t] += delta;
+        if (column[t] < 0) ok = false;
+    }
+    return ok;
+}
+
+bool incremental_init(IncrementalDetector *det, const SystemState *initial) {
+    int np = initial->num_processes;
+    int nr = initial->num_resources;
+
+    memset(det, 0, sizeof(*det));
+    if (!init_system_state(&det->state, np, nr)) {
+        return false;
+    }
+    memcpy(det->state.available, initial->available, (size_t)nr * sizeof(int));
+    for (int i = 0; i < np; i++) {
+        memcpy(det->state.allocation[i], initial->allocation[i], (size_t)nr * sizeof(int));
+        memcpy(det->state.max_need[i], initial->max_need[i], (size_t)nr * sizeof(int));
+    }
+
+    det->position = malloc(((size_t)np + 1) * sizeof(int));
+    det->slack = malloc(((size_t)np * nr + 1) * sizeof(int));
+    if (!det->position || !det->slack) {
+        incremental_free(det);
+        return false;
+    }
+    init_detection_result(&det->result);
+    recompute(det);
+    return true;
+}
+
+void incremental_free(IncrementalDetector *det) {
+    free_system_state(&det->state);
+    free_detection_result(&det->result);
+    free(det->position);
+    free(det->slack);
+    memset(det, 0, sizeof(*det));
+}
+
+bool incremental_allocate(IncrementalDetector *det, int p, int r, int k) {
+    SystemState *state = &det->state;
+    if (!in_range(det, p, r) || k <= 0 ||
+        k > state->available[r] || k > state->need[p][r]) {
+        return false;
+    }
+    state->available[r] -= k;
+    state->allocation[p][r] += k;
+    state->need[p][r] -= k;
+
+    // Everyone ahead of p in S sees k fewer units; p itself needs k fewer
+    // and gives the same amount back, so its slack and the suffix are unchanged
+    if (!det->dirty && !det->result.is_deadlocked) {
+        if (!shift_prefix(det, p, r, -k)) det->dirty = true;
+    } else {
+        det->dirty = true;
+    }
+    return true;
+}
+
+bool incremental_release(IncrementalDetector *det, int p, int r, int k) {
+    SystemState *state = &det->state;
+    if (!in_range(det, p, r) || k <= 0 || k > state->allocation[p][r]) {
+        return false;
+    }
+    state->available[r] += k;
+    state->allocation[p][r] -= k;
+    state->need[p][r] += k;
+
+    // Releasing never breaks S, but it may unblock a deadlocked state
+    if (!det->dirty && !det->result.is_deadlocked) {
+        shift_prefix(det, p, r, k);
+    } else {
+        det->dirty = true;
+    }
+    return true;
+}
+
+bool incremental_set_max(IncrementalDetector *det, int p, int r, int k) {
+    SystemState *state = &det->state;
+    if (!in_range(det, p, r) || k < state->allocation[p][r]) {
+        return false;
+    }
+    int delta = k - state->max_need[p][r];
+    state->max_need[p][r] = k;
+    state->need[p][r] += delta;
+
+    // Only p's own step changes: it needs delta more of r
+    if (!det->dirty && !det->result.is_deadlocked) {
+        int *cell = &det->slack[(size_t)r * state->num_processes + det->position[p]];
+        *cell -= delta;
+        if (*cell < 0) det->dirty = true;
+    } else if (delta != 0) {
+        det->dirty = true;
+    }
+    return true;
+}
+
+const DetectionResult *incremental_query(IncrementalDetector *det) {
+    if (det->dirty) {
+        recompute(det);
+    }
+    return &det->result;
+}
@@ -0,0 +1,70 @@
+/*
+ * Deadlock Detection System
+ * Incremental (delta-driven) deadlock detector header file
+ */
+
+#ifndef INCREMENTAL_H
+#define INCREMENTAL_H
+
+#include <stdbool.h>
+#include "deadlock_detector.h"
+
+// Incremental detector
+// Owns a copy of the system state plus the last detection result. While the
+// state is safe, the last safe sequence S is kept together with its slack:
+// slack[r][t] = Work[r] just before S[t] runs - Need[S[t]][r].
+// A delta on process p (at position t0 in S) only changes the slack of the
+// processes before it in one resource column, so allocate/release cost
+// O(t0) and set_max costs O(1). If a slack goes negative, S is no longer a
+// witness and the next query falls back to a full detection. The reported
+// safe sequence is therefore a valid witness for the current state, but not
+// necessarily the one a fresh detect_deadlock() would list.
+typedef struct {
+    SystemState state;
+    DetectionResult result;
+    int *position;      // [num_processes] index of each process in S
+    int *slack;         // [num_resources * num_processes], column-major
+    bool dirty;         // result must be recomputed on the next query
+    long full_runs;     // number of full detections performed
+} IncrementalDetector;
+
+/**
+ * Create a detector from a copy of a system state and run one detection
+ * @param det Pointer to IncrementalDetector
+ * @param initial State to copy (need is recalculated)
+ * @return false if memory is exhausted
+ */
+bool incremental_init(IncrementalDetector *det, const SystemState *initial);
+
+/**
+ * Release memory owned by the detector
+ * @param det Pointer to IncrementalDetector
+ */
+void incremental_free(IncrementalDetector *det);
+
+/**
+ * Grant k units of resource r to process p
+ * @return false (state unchanged) if k <= 0, k > Available[r] or k > Need[p][r]
+ */
+bool incremental_allocate(IncrementalDetector *det, int p, int r, int k);
+
+/**
+ * Return k units of resource r held by process p
+ * @return false (state unchanged) if k <= 0 or k > Allocation[p][r]
+ */
+bool incremental_release(IncrementalDetector *det, int p, int r, int k);
+
+/**
+ * Set process p's maximum claim on resource r to k
+ * @return false (state unchanged) if k < Allocation[p][r]
+ */
+bool incremental_set_max(IncrementalDetector *det, int p, int r, int k);
+
+/**
+ * Detection result for the current state
+ * @param det Pointer to IncrementalDetector
+ * @return Result owned by the detector, valid until the next operation
+ */
+const DetectionResult *incremental_query(IncrementalDetector *det);
+
+#endif // INCREMENTAL_H
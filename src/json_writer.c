@@ -0,0 +1,166 @@
+/*
+ * Deadlock Detection System
+ * Buffered JSON output for worker responses
+ */
+
+#define _POSIX_C_SOURCE 200809L  /* write */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "deadlock_detector.h"
+#include "json_writer.h"
+
+// Longest decimal: "-9223372036854775808"
+#define MAX_DIGITS 20
+
+static const char digit_pairs[201] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+static const uint64_t powers_of_10[20] = {
+    1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL,
+    100000000ULL, 1000000000ULL, 10000000000ULL, 100000000000ULL,
+    1000000000000ULL, 10000000000000ULL, 100000000000000ULL,
+    1000000000000000ULL, 10000000000000000ULL, 100000000000000000ULL,
+    1000000000000000000ULL, 10000000000000000000ULL
+};
+
+void json_init(JsonWriter *w, int fd) {
+    memset(w, 0, sizeof(*w));
+    w->fd = fd;
+}
+
+void json_free(JsonWriter *w) {
+    free(w->data);
+    w->data = NULL;
+    w->length = 0;
+    w->capacity = 0;
+}
+
+void json_reset(JsonWriter *w) {
+    w->length = 0;
+}
+
+// Make room for n more bytes
+static char *json_reserve(JsonWriter *w, size_t n) {
+    if (w->capacity - w->length < n) {
+        size_t capacity = w->capacity ? w->capacity : 4096;
+        while (capacity - w->length < n) capacity *= 2;
+        char *data = realloc(w->data, capacity);
+        if (!data) out_of_memory();
+        w->data = data;
+        w->capacity = capacity;
+    }
+    return w->data + w->length;
+}
+
+void json_raw(JsonWriter *w, const void *data, size_t n) {
+    memcpy(json_reserve(w, n), data, n);
+    w->length += n;
+}
+
+void json_str(JsonWriter *w, const char *s) {
+    json_raw(w, s, strlen(s));
+}
+
+void json_char(JsonWriter *w, char c) {
+    *json_reserve(w, 1) = c;
+    w->length++;
+}
+
+// Decimal digits in v: log2 from the leading zero count, scaled by
+// log10(2) ~ 1233/4096, then corrected by one table comparison (v | 1
+// gives 0 its one digit and changes no other count)
+static int count_digits(uint64_t v) {
+    v |= 1;
+    int t = (64 - __builtin_clzll(v)) * 1233 >> 12;
+    return t + (v >= powers_of_10[t]);
+}
+
+// Write v's digits ending just before end, two at a time
+static void write_digits(char *end, uint64_t v) {
+    while (v >= 100) {
+        unsigned pair = (unsigned)(v % 100) * 2;
+        v /= 100;
+        *--end = digit_pairs[pair + 1];
+        *--end = digit_pairs[pair];
+    }
+    if (v >= 10) {
+        *--end = digit_pairs[v * 2 + 1];
+        *--end = digit_pairs[v * 2];
+    } else {
+        *--end = (char)('0' + v);
+    }
+}
+
+// The sign is stored unconditionally and kept only for negative values
+static void put_signed(JsonWriter *w, long long v) {
+    char *p = json_reserve(w, MAX_DIGITS + 1);
+    int negative = v < 0;
+    uint64_t magnitude = negative ? 0 - (uint64_t)v : (uint64_t)v;
+    int digits = count_digits(magnitude);
+    *p = '-';
+    write_digits(p + negative + digits, magnitude);
+    w->length += (size_t)(negative + digits);
+}
+
+void json_int(JsonWriter *w, int v) {
+    put_signed(w, v);
+}
+
+void json_ll(JsonWriter *w, long long v) {
+    put_signed(w, v);
+}
+
+void json_hex64(JsonWriter *w, uint64_t v) {
+    static const char hex[16] = "0123456789abcdef";
+    char *p = json_reserve(w, 16);
+    for (int k = 15; k >= 0; k--) {
+        p[k] = hex[v & 15];
+        v >>= 4;
+    }
+    w->length += 16;
+}
+
+void json_ints(JsonWriter *w, const int *values, int count, const char *sep,
+               const char *prefix) {
+    size_t sep_length = strlen(sep);
+    size_t prefix_length = strlen(prefix);
+    for (int k = 0; k < count; k++) {
+        if (k) json_raw(w, sep, sep_length);
+        if (prefix_length) json_raw(w, prefix, prefix_length);
+        put_signed(w, values[k]);
+    }
+}
+
+bool json_flush(JsonWriter *w) {
+    size_t done = 0;
+    while (done < w->length && !w->failed) {
+        ssize_t n = write(w->fd, w->data + done, w->length - done);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            w->failed = true;
+            break;
+        }
+        done += (size_t)n;
+    }
+    w->length = 0;
+    return !w->failed;
+}
+
+void json_drain(JsonWriter *w) {
+    if (w->fd >= 0 && w->length >= JSON_DRAIN_BYTES) {
+        json_flush(w);
+    }
+}
@@ -0,0 +1,105 @@
+/*
+ * Deadlock Detection System
+ * Buffered JSON output for worker responses header file
+ */
+
+#ifndef JSON_WRITER_H
+#define JSON_WRITER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Responses are built in one growable buffer and handed to the kernel with
+// a single write() (see json_flush()), instead of one stdio call per value.
+// A writer bound to a file descriptor also drains early once it holds
+// JSON_DRAIN_BYTES, where a caller streams a long response (BATCH_DETECT).
+#define JSON_DRAIN_BYTES (1 << 16)
+
+typedef struct {
+    char *data;
+    size_t length;
+    size_t capacity;
+    int fd;             // destination of json_flush(); -1 for memory only
+    bool failed;        // a write() to fd failed; later output is dropped
+} JsonWriter;
+
+/**
+ * Initialize an empty writer
+ * @param w Pointer to JsonWriter
+ * @param fd File descriptor for json_flush(), or -1 to only collect bytes
+ */
+void json_init(JsonWriter *w, int fd);
+
+/**
+ * Release a writer's buffer (unflushed bytes are discarded)
+ * @param w Pointer to JsonWriter
+ */
+void json_free(JsonWriter *w);
+
+/**
+ * Forget the buffered bytes but keep the buffer
+ * @param w Pointer to JsonWriter
+ */
+void json_reset(JsonWriter *w);
+
+/**
+ * Append bytes verbatim (also used for binary wire payloads)
+ * @param w Pointer to JsonWriter
+ * @param data Bytes to append
+ * @param n Number of bytes
+ */
+void json_raw(JsonWriter *w, const void *data, size_t n);
+
+// Append a string literal without measuring it at run time
+#define json_lit(w, s) json_raw((w), (s), sizeof(s) - 1)
+
+/**
+ * Append a NUL-terminated string verbatim (no quoting or escaping)
+ */
+void json_str(JsonWriter *w, const char *s);
+
+/**
+ * Append one character
+ */
+void json_char(JsonWriter *w, char c);
+
+/**
+ * Append an integer in decimal, exactly as printf("%d") would
+ */
+void json_int(JsonWriter *w, int v);
+
+/**
+ * Append a long long in decimal, exactly as printf("%lld") would
+ */
+void json_ll(JsonWriter *w, long long v);
+
+/**
+ * Append 16 lowercase hex digits, exactly as printf("%016llx") would
+ */
+void json_hex64(JsonWriter *w, uint64_t v);
+
+/**
+ * Append count integers joined by sep, each preceded by prefix
+ * ("1,2,3" with sep ","; "P1, P2" with sep ", " and prefix "P")
+ * @param sep Separator between values
+ * @param prefix Text before each value ("" for none)
+ */
+void json_ints(JsonWriter *w, const int *values, int count, const char *sep,
+               const char *prefix);
+
+/**
+ * Write every buffered byte to the writer's fd and empty the buffer
+ * One write() call unless the kernel takes the bytes in pieces.
+ * @param w Pointer to JsonWriter (fd must not be -1)
+ * @return false if a write failed (the bytes are dropped)
+ */
+bool json_flush(JsonWriter *w);
+
+/**
+ * json_flush() if the writer has an fd and holds JSON_DRAIN_BYTES or more
+ * @param w Pointer to JsonWriter
+ */
+void json_drain(JsonWriter *w);
+
+#endif // JSON_WRITER_H
@@ -10,16 +10,23 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include "deadlock_detector.h"
+#include "parallel_detect.h"
 #include "rag.h"
+#include "replay.h"
+#include "text_reader.h"
 
 // Function prototypes
 void display_banner(void);
 void display_menu(void);
 void input_system_config(SystemState *state);
+bool load_system_config(SystemState *state, const char *path);
 void run_sample_scenario(SystemState *state, int scenario);
 void clear_screen(void);
 void press_enter_to_continue(void);
+void print_replay_json(const ReplayReport *report);
+int run_replay(int argc, char **argv);
 
 // Clear screen (cross-platform)
 void clear_screen(void) {
@@ -76,50 +83,70 @@ void display_menu(void) {
     printf("\n  Enter your choice: ");
 }
 
+// Read count console integers; a bad token is reported and skipped
+static void read_console_ints(TextReader *in, int *values, int count) {
+    for (int j = 0; j < count; j++) {
+        if (!text_read_int(in, &values[j])) {
+            char token[32];
+            printf("  [ERROR] %s, using 0.\n", text_reader_error(in, "Expected an integer"));
+            text_read_word(in, token, sizeof(token));
+        }
+    }
+}
+
+// Hand stdin back to scanf, leaving the newline press_enter_to_continue expects
+static void end_console_input(TextReader *in) {
+    text_reader_free(in);
+    ungetc('\n', stdin);
+}
+
 // Input system configuration from user
 void input_system_config(SystemState *state) {
     printf("\n  ┌─────────────────────────────────────────┐\n");
     printf("  │         SYSTEM CONFIGURATION            │\n");
     printf("  └─────────────────────────────────────────┘\n");
     
+    // Values are parsed a line at a time, so several may share one line
+    TextReader in;
+    text_reader_init_file(&in, stdin, true);
+
     // Number of processes
+    int num_processes = 0, num_resources = 0;
     printf("\n  Enter number of processes (1-%d): ", MAX_PROCESSES);
-    scanf("%d", &state->num_processes);
-    if (state->num_processes < 1 || state->num_processes > MAX_PROCESSES) {
+    read_console_ints(&in, &num_processes, 1);
+    if (num_processes < 1 || num_processes > MAX_PROCESSES) {
         printf("  [ERROR] Invalid number of processes. Setting to 5.\n");
-        state->num_processes = 5;
+        num_processes = 5;
     }
     
     // Number of resources
     printf("  Enter number of resource types (1-%d): ", MAX_RESOURCES);
-    scanf("%d", &state->num_resources);
-    if (state->num_resources < 1 || state->num_resources > MAX_RESOURCES) {
+    read_console_ints(&in, &num_resources, 1);
+    if (num_resources < 1 || num_resources > MAX_RESOURCES) {
         printf("  [ERROR] Invalid number of resources. Setting to 3.\n");
-        state->num_resources = 3;
+        num_resources = 3;
     }
     
-    // Initialize names
-    for (int i = 0; i < state->num_processes; i++) {
-        sprintf(state->process_names[i], "P%d", i);
-    }
-    for (int j = 0; j < state->num_resources; j++) {
-        sprintf(state->resource_names[j], "R%d", j);
+    // Allocate matrices (also initializes names)
+    free_system_state(state);
+    if (!init_system_state(state, num_processes, num_resources)) {
+        printf("  [ERROR] Not enough memory for a %dx%d system.\n",
+               num_processes, num_resources);
+        init_system_state(state, 0, 0);
+        end_console_input(&in);
+        return;
     }
     
     // Available resources
     printf("\n  Enter Available resources (%d values):\n  ", state->num_resources);
-    for (int j = 0; j < state->num_resources; j++) {
-        scanf("%d", &state->available[j]);
-    }
+    read_console_ints(&in, state->available, state->num_resources);
     
     // Allocation matrix
     printf("\n  Enter Allocation Matrix (%dx%d):\n", 
            state->num_processes, state->num_resources);
     for (int i = 0; i < state->num_processes; i++) {
         printf("  %s: ", state->process_names[i]);
-        for (int j = 0; j < state->num_resources; j++) {
-            scanf("%d", &state->allocation[i][j]);
-        }
+        read_console_ints(&in, state->allocation[i], state->num_resources);
     }
     
     // Maximum need matrix
@@ -127,28 +154,47 @@ void input_system_config(SystemState *state) {
            state->num_processes, state->num_resources);
     for (int i = 0; i < state->num_processes; i++) {
         printf("  %s: ", state->process_names[i]);
-        for (int j = 0; j < state->num_resources; j++) {
-            scanf("%d", &state->max_need[i][j]);
-        }
+        read_console_ints(&in, state->max_need[i], state->num_resources);
     }
     
+    end_console_input(&in);
+    
     // Calculate need matrix
     calculate_need_matrix(state);
     
     printf("\n  [✓] System configuration saved successfully!\n");
 }
 
+// Load a state file (plain or labelled format, see text_reader.h)
+bool load_system_config(SystemState *state, const char *path) {
+    TextReader in;
+    if (!text_reader_open(&in, path)) {
+        perror(path);
+        return false;
+    }
+    free_system_state(state);
+    const char *err = text_read_state(&in, state);
+    if (err) {
+        fprintf(stderr, "%s: %s\n", path, err);
+        free_system_state(state);
+        init_system_state(state, 0, 0);
+    } else {
+        calculate_need_matrix(state);
+    }
+    text_reader_free(&in);
+    return err == NULL;
+}
+
 // Run predefined sample scenarios
 void run_sample_scenario(SystemState *state, int scenario) {
-    init_system_state(state);
+    free_system_state(state);
     
     if (scenario == 1) {
         // Safe state scenario (classic Banker's example)
         printf("\n  Loading Sample Scenario: SAFE STATE\n");
         printf("  ─────────────────────────────────────────\n");
         
-        state->num_processes = 5;
-        state->num_resources = 3;
+        init_system_state(state, 5, 3);
         
         // Available resources
         state->available[0] = 3;
@@ -188,8 +234,7 @@ void run_sample_scenario(SystemState *state, int scenario) {
         printf("\n  Loading Sample Scenario: DEADLOCK STATE\n");
         printf("  ─────────────────────────────────────────\n");
         
-        state->num_processes = 4;
-        state->num_resources = 3;
+        init_system_state(state, 4, 3);
         
         // Very limited available resources
         state->available[0] = 0;
@@ -227,15 +272,119 @@ void run_sample_scenario(SystemState *state, int scenario) {
     printf("\n  [✓] Sample scenario loaded!\n");
 }
 
+// Print a replay report as one JSON object
+void print_replay_json(const ReplayReport *report) {
+    static const char *const status[] = { "safe", "unsafe", "invalid" };
+    printf("{\"status\":\"%s\",\"events\":%lld", status[report->status], report->events);
+    if (report->status != REPLAY_SAFE) {
+        printf(",\"event_index\":%lld,\"line\":%lld", report->event_index, report->line);
+    }
+    if (report->status == REPLAY_UNSAFE) {
+        const ReplayEvent *e = &report->event;
+        printf(",\"event\":{\"kind\":\"%s\",\"process\":%d,\"resource\":%d,\"amount\":%d}",
+               event_kind_name(e->kind), e->process, e->resource, e->amount);
+        printf(",\"blocked_processes\":[");
+        for (int i = 0; i < report->num_blocked; i++) {
+            printf(i ? ",%d" : "%d", report->blocked[i]);
+        }
+        printf("]");
+    } else if (report->status == REPLAY_INVALID) {
+        printf(",\"error\":\"%s\"", report->error);
+    }
+    printf(",\"full_detections\":%ld}\n", report->full_detections);
+}
+
+// deadlock_detector replay [--json] [FILE | -]
+// Exit status: 0 safe throughout, 1 unsafe, 2 invalid trace or usage
+int run_replay(int argc, char **argv) {
+    bool json = false;
+    const char *path = NULL;
+    for (int a = 2; a < argc; a++) {
+        if (strcmp(argv[a], "--json") == 0) {
+            json = true;
+        } else if (!path) {
+            path = argv[a];
+        } else {
+            fprintf(stderr, "Usage: %s replay [--json] [FILE | -]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    FILE *in = stdin;
+    if (path && strcmp(path, "-") != 0) {
+        in = fopen(path, "r");
+        if (!in) {
+            perror(path);
+            return 2;
+        }
+    }
+
+    ReplayReport report;
+    clock_t start = clock();
+    replay_file(in, &report);
+    double seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+    if (in != stdin) fclose(in);
+
+    if (json) {
+        print_replay_json(&report);
+    } else if (report.status == REPLAY_INVALID) {
+        fprintf(stderr, "replay: line %lld: %s\n", report.line, report.error);
+    } else {
+        printf("Replayed %lld events in %.3f s", report.events, seconds);
+        if (seconds > 0) printf(" (%.2f M events/s)", report.events / seconds / 1e6);
+        printf(", %ld full detection%s\n", report.full_detections,
+               report.full_detections == 1 ? "" : "s");
+        if (report.status == REPLAY_SAFE) {
+            printf("The state stayed safe.\n");
+        } else {
+            const ReplayEvent *e = &report.event;
+            printf("UNSAFE at event %lld (line %lld): %s P%d R%d %d\n", report.event_index,
+                   report.line, event_kind_name(e->kind), e->process, e->resource, e->amount);
+            printf("Blocked processes:");
+            for (int i = 0; i < report.num_blocked; i++) {
+                printf(" P%d", report.blocked[i]);
+            }
+            printf("\n");
+        }
+    }
+
+    int status = report.status == REPLAY_SAFE ? 0 : report.status == REPLAY_UNSAFE ? 1 : 2;
+    free_replay_report(&report);
+    return status;
+}
+
 // Main program
-int main(void) {
+int main(int argc, char **argv) {
+    int threads = 1;
+    if (argc > 1 && strcmp(argv[1], "replay") == 0) {
+        return run_replay(argc, argv);
+    }
+    const char *load_path = NULL;
+    for (int a = 1; a < argc; a++) {
+        if (strcmp(argv[a], "--threads") == 0 && a + 1 < argc && atoi(argv[a + 1]) >= 1) {
+            threads = atoi(argv[++a]);
+        } else if (strcmp(argv[a], "--load") == 0 && a + 1 < argc) {
+            load_path = argv[++a];
+        } else {
+            fprintf(stderr, "Usage: %s [--threads N] [--load FILE] | replay [--json] [FILE | -]\n",
+                    argv[0]);
+            return 2;
+        }
+    }
+
     SystemState state;
     RAG rag;
     DetectionResult result;
     int choice;
     bool has_config = false;
     
-    init_system_state(&state);
+    init_system_state(&state, 0, 0);
+    if (load_path) {
+        if (!load_system_config(&state, load_path)) return 1;
+        has_config = true;
+    }
+    init_rag(&rag);
+    init_detection_result(&result);
     
     clear_screen();
     display_banner();
@@ -264,7 +413,7 @@ int main(void) {
                 if (!has_config) {
                     printf("\n  [!] Please enter system configuration first (Option 1 or 6/7).\n");
                 } else {
-                    result = detect_deadlock(&state);
+                    detect_deadlock_parallel(&state, &result, threads);
                     display_result(&result, &state);
                 }
                 press_enter_to_continue();
@@ -285,7 +434,7 @@ int main(void) {
                 if (!has_config) {
                     printf("\n  [!] Please enter system configuration first (Option 1 or 6/7).\n");
                 } else {
-                    result = detect_deadlock(&state);
+                    detect_deadlock_parallel(&state, &result, threads);
                     if (result.is_deadlocked) {
                         resolve_deadlock(&state, &result);
                     } else {
@@ -324,5 +473,8 @@ int main(void) {
         
     } while (choice != 0);
     
+    free_rag(&rag);
+    free_detection_result(&result);
+    free_system_state(&state);
     return 0;
 }
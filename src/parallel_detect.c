@@ -0,0 +1,240 @@
+/*
+ * Deadlock Detection System
+ * Round-based multithreaded detection
+ */
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include "parallel_detect.h"
+#include "simd_kernels.h"
+#include "stats.h"
+
+typedef struct ParallelScan ParallelScan;
+
+// One thread's share of a round
+typedef struct {
+    ParallelScan *scan;
+    int index;
+    int *released;          // [row_stride] allocations it released this round
+    int lo;                 // its slice of pending: [lo, hi)
+    int num_finished;       // finished this round, stored at finished[lo..]
+    int num_kept;           // still pending, compacted to pending[lo..]
+    bool negative;          // saw a negative allocation in its rows
+} ScanThread;
+
+struct ParallelScan {
+    SystemState *state;
+    int threads;
+    int *work;              // read-only while threads scan
+    int *pending;           // unfinished processes, ascending
+    int num_pending;
+    int *finished;          // per-slice finishers of the current round
+    DetectionResult *result;
+    bool done;
+    ScanThread *slots;
+    bool started;           // threads is final; set once every thread is up
+
+    // Reusable barrier
+    pthread_mutex_t lock;
+    pthread_cond_t turn;
+    int arrived;
+    unsigned generation;
+};
+
+static void barrier_wait(ParallelScan *s) {
+    pthread_mutex_lock(&s->lock);
+    unsigned generation = s->generation;
+    if (++s->arrived == s->threads) {
+        s->arrived = 0;
+        s->generation++;
+        pthread_cond_broadcast(&s->turn);
+    } else {
+        while (generation == s->generation) {
+            pthread_cond_wait(&s->turn, &s->lock);
+        }
+    }
+    pthread_mutex_unlock(&s->lock);
+}
+
+// Split [0, n) into threads near-equal parts; part t starts here
+static int split(int n, int threads, int t) {
+    return (int)((long long)n * t / threads);
+}
+
+// Thread 0, between barriers: append the round's finishers in slice order
+// (so by index) and close the gaps left in pending
+static void merge_round(ParallelScan *s) {
+    DetectionResult *result = s->result;
+    int kept = 0;
+    int finished = 0;
+    for (int t = 0; t < s->threads; t++) {
+        const ScanThread *slot = &s->slots[t];
+        memcpy(result->safe_sequence + result->safe_sequence_length,
+               s->finished + slot->lo, (size_t)slot->num_finished * sizeof(int));
+        result->safe_sequence_length += slot->num_finished;
+        finished += slot->num_finished;
+        memmove(s->pending + kept, s->pending + slot->lo, (size_t)slot->num_kept * sizeof(int));
+        kept += slot->num_kept;
+    }
+    STATS_ADD(passes, 1);
+    STATS_ADD(comparisons, finished + kept);
+    s->num_pending = kept;
+    s->done = finished == 0 || kept == 0;
+}
+
+static void *scan_thread(void *arg) {
+    ScanThread *self = arg;
+    ParallelScan *s = self->scan;
+    SystemState *state = s->state;
+    int stride = state->row_stride;
+    int t = self->index;
+    STATS_START(start);
+
+    // The slices depend on how many threads could be started
+    pthread_mutex_lock(&s->lock);
+    while (!s->started) {
+        pthread_cond_wait(&s->turn, &s->lock);
+    }
+    pthread_mutex_unlock(&s->lock);
+
+    // Need for this thread's rows (rows are contiguous)
+    size_t first = (size_t)split(state->num_processes, s->threads, t) * stride;
+    size_t last = (size_t)split(state->num_processes, s->threads, t + 1) * stride;
+    if (state->num_processes > 0) {
+        const int *max_need = state->max_need[0];
+        const int *allocation = state->allocation[0];
+        int *need = state->need[0];
+        for (size_t k = first; k < last; k++) {
+            need[k] = max_need[k] - allocation[k];
+            if (allocation[k] < 0) self->negative = true;
+        }
+    }
+    barrier_wait(s);
+    for (int u = 0; u < s->threads; u++) {
+        if (s->slots[u].negative) return NULL;
+    }
+    // Thread 0 is the caller, whose counters the stats report
+    if (t == 0) {
+        STATS_STOP(STAT_NEED, start);
+        start = stats_enabled ? stats_now_ns() : 0;
+    }
+
+    // Resource columns this thread reduces, in whole vector blocks
+    int blocks = stride / ROW_ALIGN_INTS;
+    int c0 = split(blocks, s->threads, t) * ROW_ALIGN_INTS;
+    int c1 = split(blocks, s->threads, t + 1) * ROW_ALIGN_INTS;
+
+    while (!s->done) {
+        // Scan: test the slice against the shared Work, compacting in place
+        int lo = split(s->num_pending, s->threads, t);
+        int hi = split(s->num_pending, s->threads, t + 1);
+        self->lo = lo;
+        self->num_finished = 0;
+        self->num_kept = 0;
+        for (int k = lo; k < hi; k++) {
+            int q = s->pending[k];
+            if (vec_all_le(state->need[q], s->work, stride)) {
+                vec_add(self->released, state->allocation[q], stride);
+                s->finished[lo + self->num_finished++] = q;
+            } else {
+                s->pending[lo + self->num_kept++] = q;
+            }
+        }
+        barrier_wait(s);
+
+        // Reduce: Work += every thread's released units, by column block
+        for (int u = 0; u < s->threads; u++) {
+            int *released = s->slots[u].released;
+            for (int c = c0; c < c1; c++) {
+                s->work[c] += released[c];
+                released[c] = 0;
+            }
+        }
+        if (t == 0) merge_round(s);
+        barrier_wait(s);
+    }
+    if (t == 0) STATS_STOP(STAT_DETECT, start);
+    return NULL;
+}
+
+void detect_deadlock_parallel(SystemState *state, DetectionResult *result, int threads) {
+    if (threads <= 1) {
+        detect_deadlock(state, result);
+        return;
+    }
+    int np = state->num_processes;
+    int stride = state->row_stride;
+    if (threads > np / PARALLEL_MIN_ROWS) threads = np / PARALLEL_MIN_ROWS;
+    if (threads < 1) threads = 1;
+
+    ParallelScan s;
+    memset(&s, 0, sizeof(s));
+    s.state = state;
+    s.threads = threads;
+    s.result = result;
+    s.work = checked_malloc((size_t)stride * sizeof(int));
+    memcpy(s.work, state->available, (size_t)stride * sizeof(int));
+    s.pending = checked_malloc(((size_t)np + 1) * sizeof(int));
+    s.finished = checked_malloc(((size_t)np + 1) * sizeof(int));
+    for (int i = 0; i < np; i++) {
+        s.pending[i] = i;
+    }
+    s.num_pending = np;
+    s.slots = checked_calloc((size_t)threads, sizeof(ScanThread));
+    pthread_mutex_init(&s.lock, NULL);
+    pthread_cond_init(&s.turn, NULL);
+
+    free_detection_result(result);
+    result->safe_sequence = checked_malloc(((size_t)np + 1) * sizeof(int));
+    result->deadlocked_processes = checked_malloc(((size_t)np + 1) * sizeof(int));
+    result->capacity = np;
+
+    pthread_t *pool = checked_malloc((size_t)threads * sizeof(pthread_t));
+    for (int t = 0; t < threads; t++) {
+        s.slots[t].scan = &s;
+        s.slots[t].index = t;
+        s.slots[t].released = checked_calloc((size_t)stride, sizeof(int));
+    }
+    // If a thread cannot be started, the ones that were share the rows
+    // (the calling thread alone, if none was)
+    int started = 1;
+    while (started < threads &&
+           pthread_create(&pool[started], NULL, scan_thread, &s.slots[started]) == 0) {
+        started++;
+    }
+    pthread_mutex_lock(&s.lock);
+    s.threads = started;
+    s.started = true;
+    pthread_cond_broadcast(&s.turn);
+    pthread_mutex_unlock(&s.lock);
+    scan_thread(&s.slots[0]);
+    for (int t = 1; t < started; t++) {
+        pthread_join(pool[t], NULL);
+    }
+
+    bool negative = false;
+    for (int t = 0; t < threads; t++) {
+        negative = negative || s.slots[t].negative;
+        free(s.slots[t].released);
+    }
+    free(pool);
+    free(s.slots);
+    free(s.work);
+    free(s.finished);
+    pthread_mutex_destroy(&s.lock);
+    pthread_cond_destroy(&s.turn);
+
+    if (negative) {
+        // Work may shrink with negative allocations; only the rescan handles that
+        free(s.pending);
+        detect_deadlock_rescan(state, result);
+        return;
+    }
+
+    // What is still pending is deadlocked, already in index order
+    memcpy(result->deadlocked_processes, s.pending, (size_t)s.num_pending * sizeof(int));
+    result->num_deadlocked = s.num_pending;
+    result->is_deadlocked = s.num_pending > 0;
+    free(s.pending);
+}
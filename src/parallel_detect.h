@@ -0,0 +1,36 @@
+/*
+ * Deadlock Detection System
+ * Multithreaded detection for a single large state
+ */
+
+#ifndef PARALLEL_DETECT_H
+#define PARALLEL_DETECT_H
+
+#include "deadlock_detector.h"
+
+// Fewest processes per thread; larger thread counts are reduced to fit
+#define PARALLEL_MIN_ROWS 1024
+
+/**
+ * Detect deadlock with the pending processes split across threads
+ * The scan runs in rounds. In each round every thread tests its share of
+ * the unfinished processes against the same read-only Work. Everyone that
+ * fits finishes in that round, since Work only grows. The allocations they
+ * release are summed per thread and reduced by resource column, and the
+ * rounds repeat until one finishes nobody. The need matrix is computed by
+ * the same threads.
+ *
+ * The safe sequence lists the rounds in order and each round by process
+ * index. It is valid and identical for every thread count >= 2, but it is
+ * generally not the order of detect_deadlock(). With threads <= 1, or
+ * with negative allocations (Work could shrink within a round), this is
+ * detect_deadlock().
+ *
+ * @param state Pointer to SystemState structure (need is recalculated)
+ * @param result Receives deadlock status and safe sequence
+ * @param threads Number of threads, including the calling one (fewer run
+ *        if the system cannot start them all)
+ */
+void detect_deadlock_parallel(SystemState *state, DetectionResult *result, int threads);
+
+#endif // PARALLEL_DETECT_H
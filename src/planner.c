@@ -0,0 +1,218 @@
+/*
+ * Deadlock Detection System
+ * Multi-victim resolution planner
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "planner.h"
+#include "worklist.h"
+
+typedef struct {
+    long long cost;
+    int process;
+} Candidate;
+
+long long cost_units_held(const SystemState *state, int process, const void *ctx) {
+    (void)ctx;
+    long long total = 0;
+    for (int j = 0; j < state->num_resources; j++) {
+        total += state->allocation[process][j];
+    }
+    return total;
+}
+
+long long cost_priority(const SystemState *state, int process, const void *ctx) {
+    (void)state;
+    return ctx ? ((const int *)ctx)[process] : 0;
+}
+
+long long cost_work_lost(const SystemState *state, int process, const void *ctx) {
+    (void)ctx;
+    long long held = 0;
+    long long max = 0;
+    for (int j = 0; j < state->num_resources; j++) {
+        held += state->allocation[process][j];
+        max += state->max_need[process][j];
+    }
+    return max > 0 ? held * 1000 / max : 0;
+}
+
+static int compare_candidates(const void *a, const void *b) {
+    const Candidate *x = a;
+    const Candidate *y = b;
+    if (x->cost != y->cost) return x->cost < y->cost ? -1 : 1;
+    return (x->process > y->process) - (x->process < y->process);
+}
+
+/* Continue from the worklist's current point with the plan's steps from
+ * `from` on that are not dropped. With `record`, the steps that still
+ * terminate a process are compacted from `from` on, with their unblocked
+ * counts. */
+static void replay_steps(Worklist *wl, ResolutionPlan *plan, const bool *dropped,
+                         int from, bool record) {
+    int kept = from;
+    for (int s = from; s < plan->num_steps; s++) {
+        int v = plan->steps[s].process;
+        if (dropped[s] || wl->finish[v]) continue;
+        int before = wl->sequence_length;
+        worklist_terminate(wl, v);
+        worklist_run(wl);
+        if (record) {
+            plan->steps[kept] = plan->steps[s];
+            plan->steps[kept].unblocked = wl->sequence_length - before - 1;
+            kept++;
+        }
+    }
+    if (record) plan->num_steps = kept;
+}
+
+void init_resolution_plan(ResolutionPlan *plan) {
+    memset(plan, 0, sizeof(*plan));
+}
+
+void free_resolution_plan(ResolutionPlan *plan) {
+    free(plan->steps);
+    memset(plan, 0, sizeof(*plan));
+}
+
+bool plan_resolution(SystemState *state, const PlanOptions *options,
+                     ResolutionPlan *plan, DetectionResult *result) {
+    int np = state->num_processes;
+    VictimCost cost = options->cost ? options->cost : cost_units_held;
+    int max_candidates = options->max_candidates < 1 ? 1 : options->max_candidates;
+    // Width 1 keeps every greedy victim, as repeated RESOLVE does
+    bool prune = max_candidates > 1;
+
+    free_resolution_plan(plan);
+    calculate_need_matrix(state);
+    if (!worklist_applicable(state)) {
+        return false;
+    }
+
+    Worklist wl;
+    Worklist trial;
+    memset(&trial, 0, sizeof(trial));
+    worklist_init(&wl, state);
+    worklist_run(&wl);
+
+    // Costs depend only on the input state: rank the deadlocked processes once
+    int count = 0;
+    Candidate *candidates = checked_malloc((size_t)np * sizeof(Candidate));
+    for (int i = 0; i < np; i++) {
+        if (!wl.finish[i]) {
+            candidates[count].cost = cost(state, i, options->cost_ctx);
+            candidates[count].process = i;
+            count++;
+        }
+    }
+    qsort(candidates, (size_t)count, sizeof(Candidate), compare_candidates);
+    if (max_candidates > count) max_candidates = count > 0 ? count : 1;
+    int *tried = checked_malloc((size_t)max_candidates * sizeof(int));
+    plan->steps = checked_malloc((size_t)(count ? count : 1) * sizeof(PlanStep));
+    WorklistMark *marks = prune ? checked_malloc((size_t)(count + 1) * sizeof(WorklistMark)) : NULL;
+
+    int first = 0;
+    while (wl.sequence_length < np) {
+        // The cheapest processes still deadlocked, in rank order
+        while (wl.finish[candidates[first].process]) first++;
+        int width = 0;
+        for (int c = first; c < count && width < max_candidates; c++) {
+            if (!wl.finish[candidates[c].process]) tried[width++] = c;
+        }
+
+        // Try each on a copy; least cost per finished process wins, but a
+        // victim that lets no other process finish only if none does
+        int best = tried[0];
+        if (width > 1) {
+            double best_score = 0.0;
+            bool best_idle = true;
+            for (int t = 0; t < width; t++) {
+                const Candidate *cand = &candidates[tried[t]];
+                worklist_copy(&trial, &wl);
+                worklist_terminate(&trial, cand->process);
+                worklist_run(&trial);
+                int finished = trial.sequence_length - wl.sequence_length;
+                bool idle = finished == 1;
+                double score = (double)cand->cost / (double)finished;
+                if (t == 0 || (best_idle && !idle) ||
+                    (idle == best_idle && score < best_score)) {
+                    best = tried[t];
+                    best_score = score;
+                    best_idle = idle;
+                }
+            }
+        }
+
+        // Mark the point before each step so pruning can replay from it
+        if (prune) worklist_save(&marks[plan->num_steps], &wl);
+        PlanStep *step = &plan->steps[plan->num_steps++];
+        step->process = candidates[best].process;
+        step->cost = candidates[best].cost;
+        int before = wl.sequence_length;
+        worklist_terminate(&wl, step->process);
+        worklist_run(&wl);
+        step->unblocked = wl.sequence_length - before - 1;
+    }
+
+    // Later victims can make earlier ones unnecessary: from the last, drop
+    // each victim without which the others still end the deadlock. The steps
+    // before a dropped one are untouched, so each check replays from the mark
+    // taken before it.
+    int num_marks = prune ? plan->num_steps : 0;
+    if (prune && plan->num_steps > 1) {
+        int num_steps = plan->num_steps;
+        worklist_save(&marks[num_marks++], &wl);
+        int *sequence = checked_malloc((size_t)np * sizeof(int));
+        memcpy(sequence, wl.sequence, (size_t)np * sizeof(int));
+        bool *dropped = checked_calloc((size_t)num_steps, sizeof(bool));
+        for (int s = num_steps - 1; s >= 0; s--) {
+            dropped[s] = true;
+            worklist_restore(&wl, &marks[s]);
+            replay_steps(&wl, plan, dropped, s, false);
+            if (wl.sequence_length < np) dropped[s] = false;
+        }
+
+        // Rebuild the kept steps from the first dropped one (the checks
+        // overwrote the sequence past the marks they restored)
+        int from = 0;
+        while (from < num_steps && !dropped[from]) from++;
+        memcpy(wl.sequence, sequence, (size_t)marks[from].sequence_length * sizeof(int));
+        worklist_restore(&wl, &marks[from]);
+        replay_steps(&wl, plan, dropped, from, true);
+        free(dropped);
+        free(sequence);
+    }
+    for (int s = 0; s < num_marks; s++) {
+        worklist_mark_free(&marks[s]);
+    }
+    free(marks);
+    for (int s = 0; s < plan->num_steps; s++) {
+        plan->total_cost += plan->steps[s].cost;
+    }
+
+    // Final state: the victims hold and need nothing
+    for (int s = 0; s < plan->num_steps; s++) {
+        int v = plan->steps[s].process;
+        for (int j = 0; j < state->num_resources; j++) {
+            state->available[j] += state->allocation[v][j];
+            state->allocation[v][j] = 0;
+            state->max_need[v][j] = 0;
+        }
+    }
+    calculate_need_matrix(state);
+
+    // Every process finished, so the worklist's order is the safe sequence
+    free_detection_result(result);
+    result->deadlocked_processes = checked_malloc((size_t)np * sizeof(int));
+    result->safe_sequence = checked_malloc((size_t)np * sizeof(int));
+    result->capacity = np;
+    memcpy(result->safe_sequence, wl.sequence, (size_t)np * sizeof(int));
+    result->safe_sequence_length = np;
+
+    free(candidates);
+    free(tried);
+    if (trial.state) worklist_free(&trial);
+    worklist_free(&wl);
+    return true;
+}
@@ -0,0 +1,86 @@
+/*
+ * Deadlock Detection System
+ * Multi-victim resolution planner
+ */
+
+#ifndef PLANNER_H
+#define PLANNER_H
+
+#include <stdbool.h>
+#include "deadlock_detector.h"
+
+// Built-in victim costs (lower is terminated first)
+typedef enum {
+    COST_UNITS_HELD = 0,    // total units held (the RESOLVE rule)
+    COST_PRIORITY = 1,      // caller-supplied priority per process
+    COST_WORK_LOST = 2      // progress towards max need, in per mille
+} CostModel;
+
+// Cost of terminating a process; ctx is PlanOptions.cost_ctx
+typedef long long (*VictimCost)(const SystemState *state, int process, const void *ctx);
+
+typedef struct {
+    VictimCost cost;        // NULL: cost_units_held
+    const void *cost_ctx;
+    int max_candidates;     // cheapest deadlocked processes tried per step (>= 1)
+} PlanOptions;
+
+// One termination of the plan
+typedef struct {
+    int process;
+    long long cost;
+    int unblocked;          // processes that could finish because of it
+} PlanStep;
+
+typedef struct {
+    PlanStep *steps;
+    int num_steps;
+    long long total_cost;
+} ResolutionPlan;
+
+/**
+ * Plan the terminations that end every deadlock
+ * The greedy steps share one detection: each termination releases the victim's
+ * allocation into the stalled worklist and the run continues from there.
+ * At each step the max_candidates cheapest deadlocked processes are tried
+ * on a copy and the one with the least cost per process it lets finish is
+ * taken (ties: cheaper, then lower index); a victim that lets no other
+ * process finish is taken only if no candidate does. Once the state is safe
+ * and max_candidates > 1, victims that later ones made unnecessary are
+ * dropped, last first, so no victim can be left out; each check restores the
+ * worklist saved before the dropped step (O(n + m) per step to save) and
+ * replays only the steps after it. With max_candidates = 1 nothing is
+ * dropped, and with the default cost the steps repeat RESOLVE until the
+ * state is safe.
+ * @param state System state; on success the victims are applied to it
+ *        (allocation returned to available, max need cleared)
+ * @param options Cost function and search width
+ * @param plan Output; previous contents are released
+ * @param result Detection result of the final state (its safe sequence
+ *        lists each victim where it was terminated)
+ * @return false if an allocation is negative (the state is left unchanged)
+ */
+bool plan_resolution(SystemState *state, const PlanOptions *options,
+                     ResolutionPlan *plan, DetectionResult *result);
+
+/**
+ * Initialize an empty plan
+ * @param plan Pointer to ResolutionPlan
+ */
+void init_resolution_plan(ResolutionPlan *plan);
+
+/**
+ * Release memory owned by a plan
+ * @param plan Pointer to ResolutionPlan
+ */
+void free_resolution_plan(ResolutionPlan *plan);
+
+/**
+ * Built-in cost functions (see CostModel); cost_priority takes ctx as a
+ * const int array with one priority per process
+ */
+long long cost_units_held(const SystemState *state, int process, const void *ctx);
+long long cost_priority(const SystemState *state, int process, const void *ctx);
+long long cost_work_lost(const SystemState *state, int process, const void *ctx);
+
+#endif // PLANNER_H
@@ -4,90 +4,269 @@
  */
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <stdbool.h>
 #include "rag.h"
+#include "stats.h"
+
+// Initialize an empty RAG
+void init_rag(RAG *rag) {
+    memset(rag, 0, sizeof(*rag));
+}
+
+// Release memory owned by a RAG
+void free_rag(RAG *rag) {
+    free(rag->edges);
+    free(rag->adj_offsets);
+    free(rag->adj_targets);
+    memset(rag, 0, sizeof(*rag));
+}
 
 // Build RAG from system state
 void build_rag(SystemState *state, RAG *rag) {
+    STATS_START(start);
+    free_rag(rag);
     rag->num_processes = state->num_processes;
     rag->num_resources = state->num_resources;
     rag->num_edges = 0;
     
     int total_nodes = state->num_processes + state->num_resources;
     
-    // Initialize adjacency matrix
-    for (int i = 0; i < total_nodes; i++) {
-        for (int j = 0; j < total_nodes; j++) {
-            rag->adj_matrix[i][j] = 0;
+    // Process nodes: 0 to num_processes-1
+    // Resource nodes: num_processes to num_processes+num_resources-1
+    
+    // First pass: count out-degree of every node so storage is exact
+    rag->adj_offsets = checked_calloc((size_t)total_nodes + 1, sizeof(int));
+    int *degree = rag->adj_offsets + 1;
+    for (int i = 0; i < state->num_processes; i++) {
+        for (int j = 0; j < state->num_resources; j++) {
+            if (state->allocation[i][j] > 0) {
+                degree[state->num_processes + j]++;
+                rag->num_edges++;
+            }
+            if (state->need[i][j] > 0) {
+                degree[i]++;
+                rag->num_edges++;
+            }
         }
     }
+    for (int v = 0; v < total_nodes; v++) {
+        rag->adj_offsets[v + 1] += rag->adj_offsets[v];
+    }
     
-    // Process nodes: 0 to num_processes-1
-    // Resource nodes: num_processes to num_processes+num_resources-1
+    rag->edges = checked_malloc((size_t)rag->num_edges * sizeof(Edge));
+    rag->adj_targets = checked_malloc((size_t)rag->num_edges * sizeof(int));
+    int *fill = checked_malloc((size_t)total_nodes * sizeof(int));
+    memcpy(fill, rag->adj_offsets, (size_t)total_nodes * sizeof(int));
     
+    // Second pass: emit edges in row order and scatter them into CSR
+    int e = 0;
     for (int i = 0; i < state->num_processes; i++) {
         for (int j = 0; j < state->num_resources; j++) {
             int resource_node = state->num_processes + j;
             
             // Assignment edges: Resource → Process (allocation > 0)
             if (state->allocation[i][j] > 0) {
-                rag->edges[rag->num_edges].from = resource_node;
-                rag->edges[rag->num_edges].to = i;
-                rag->edges[rag->num_edges].type = ASSIGNMENT;
-                rag->adj_matrix[resource_node][i] = 2;  // Assignment
-                rag->num_edges++;
+                rag->edges[e].from = resource_node;
+                rag->edges[e].to = i;
+                rag->edges[e].type = ASSIGNMENT;
+                rag->adj_targets[fill[resource_node]++] = i;
+                e++;
             }
             
             // Request edges: Process → Resource (need > 0 and not fully allocated)
             if (state->need[i][j] > 0) {
-                rag->edges[rag->num_edges].from = i;
-                rag->edges[rag->num_edges].to = resource_node;
-                rag->edges[rag->num_edges].type = REQUEST;
-                rag->adj_matrix[i][resource_node] = 1;  // Request
-                rag->num_edges++;
+                rag->edges[e].from = i;
+                rag->edges[e].to = resource_node;
+                rag->edges[e].type = REQUEST;
+                rag->adj_targets[fill[i]++] = resource_node;
+                e++;
             }
         }
     }
+    free(fill);
+    STATS_ADD(edges, rag->num_edges);
+    STATS_STOP(STAT_RAG, start);
 }
 
-// DFS helper for cycle detection
-bool dfs_cycle(RAG *rag, int node, bool visited[], bool rec_stack[]) {
-    visited[node] = true;
-    rec_stack[node] = true;
+// Iterative DFS from root; returns true on a back edge.
+// frame_node/frame_edge form the explicit stack: the node on each level and
+// the next CSR slot to examine. A node is pushed only while WHITE, so the
+// stack never holds more than total_nodes frames.
+bool dfs_cycle(RAG *rag, int root, unsigned char colour[], int frame_node[], int frame_edge[]) {
+    int depth = 0;
+    colour[root] = GREY;
+    frame_node[0] = root;
+    frame_edge[0] = rag->adj_offsets[root];
     
-    int total_nodes = rag->num_processes + rag->num_resources;
-    
-    for (int i = 0; i < total_nodes; i++) {
-        if (rag->adj_matrix[node][i] != 0) {  // There's an edge
-            if (!visited[i]) {
-                if (dfs_cycle(rag, i, visited, rec_stack)) {
-                    return true;
-                }
-            } else if (rec_stack[i]) {
-                return true;  // Back edge found
-            }
+    while (depth >= 0) {
+        int node = frame_node[depth];
+        int k = frame_edge[depth];
+        if (k == rag->adj_offsets[node + 1]) {
+            colour[node] = BLACK;  // All descendants explored
+            depth--;
+            continue;
+        }
+        frame_edge[depth] = k + 1;
+        
+        int next = rag->adj_targets[k];
+        if (colour[next] == GREY) {
+            return true;  // Back edge found
+        }
+        if (colour[next] == WHITE) {
+            colour[next] = GREY;
+            depth++;
+            frame_node[depth] = next;
+            frame_edge[depth] = rag->adj_offsets[next];
         }
     }
-    
-    rec_stack[node] = false;
     return false;
 }
 
-// Detect cycle in RAG
+// Detect cycle in RAG in O(V + E)
 bool detect_cycle_rag(RAG *rag) {
     int total_nodes = rag->num_processes + rag->num_resources;
-    bool visited[MAX_PROCESSES + MAX_RESOURCES] = {false};
-    bool rec_stack[MAX_PROCESSES + MAX_RESOURCES] = {false};
+    unsigned char *colour = checked_calloc((size_t)total_nodes + 1, sizeof(unsigned char));
+    int *frame_node = checked_malloc(((size_t)total_nodes + 1) * sizeof(int));
+    int *frame_edge = checked_malloc(((size_t)total_nodes + 1) * sizeof(int));
+    bool cycle = false;
     
-    for (int i = 0; i < total_nodes; i++) {
-        if (!visited[i]) {
-            if (dfs_cycle(rag, i, visited, rec_stack)) {
-                return true;
+    for (int i = 0; i < total_nodes && !cycle; i++) {
+        if (colour[i] == WHITE) {
+            cycle = dfs_cycle(rag, i, colour, frame_node, frame_edge);
+        }
+    }
+    free(colour);
+    free(frame_node);
+    free(frame_edge);
+    return cycle;
+}
+
+// Initialize an empty cycle list
+void init_rag_cycles(RagCycles *cycles) {
+    memset(cycles, 0, sizeof(*cycles));
+}
+
+// Release memory owned by a cycle list
+void free_rag_cycles(RagCycles *cycles) {
+    free(cycles->offsets);
+    free(cycles->nodes);
+    memset(cycles, 0, sizeof(*cycles));
+}
+
+// Tarjan's SCC algorithm without recursion: frame_node/frame_edge are the
+// DFS call stack, scc_stack holds visited nodes not yet assigned a component
+void find_rag_cycles(RAG *rag, RagCycles *cycles) {
+    free_rag_cycles(cycles);
+    int total_nodes = rag->num_processes + rag->num_resources;
+    size_t slots = (size_t)total_nodes + 1;
+    
+    int *index = checked_malloc(slots * sizeof(int));      // -1 = unvisited
+    int *low = checked_malloc(slots * sizeof(int));
+    int *component = checked_malloc(slots * sizeof(int));  // -1 = open
+    int *frame_node = checked_malloc(slots * sizeof(int));
+    int *frame_edge = checked_malloc(slots * sizeof(int));
+    int *scc_stack = checked_malloc(slots * sizeof(int));
+    int *component_size = checked_malloc(slots * sizeof(int));
+    int next_index = 0, scc_top = 0, num_components = 0;
+    
+    for (int v = 0; v < total_nodes; v++) {
+        index[v] = -1;
+        component[v] = -1;
+    }
+    
+    for (int root = 0; root < total_nodes; root++) {
+        if (index[root] >= 0) continue;
+        
+        int depth = 0;
+        frame_node[0] = root;
+        frame_edge[0] = rag->adj_offsets[root];
+        index[root] = low[root] = next_index++;
+        scc_stack[scc_top++] = root;
+        
+        while (depth >= 0) {
+            int node = frame_node[depth];
+            int k = frame_edge[depth];
+            
+            if (k < rag->adj_offsets[node + 1]) {
+                frame_edge[depth] = k + 1;
+                int next = rag->adj_targets[k];
+                if (index[next] < 0) {
+                    // Tree edge: descend
+                    depth++;
+                    frame_node[depth] = next;
+                    frame_edge[depth] = rag->adj_offsets[next];
+                    index[next] = low[next] = next_index++;
+                    scc_stack[scc_top++] = next;
+                } else if (component[next] < 0 && index[next] < low[node]) {
+                    // Edge back into the open part of the DFS tree
+                    low[node] = index[next];
+                }
+                continue;
+            }
+            
+            // All edges of node done: pop a component if node is its root
+            if (low[node] == index[node]) {
+                int size = 0;
+                int member;
+                do {
+                    member = scc_stack[--scc_top];
+                    component[member] = num_components;
+                    size++;
+                } while (member != node);
+                component_size[num_components++] = size;
+            }
+            depth--;
+            if (depth >= 0 && low[node] < low[frame_node[depth]]) {
+                low[frame_node[depth]] = low[node];
             }
         }
     }
-    return false;
+    
+    // Number the non-trivial components by first (lowest) node id, which is
+    // always a process since the graph is bipartite; renumber[] reuses low[]
+    int *renumber = low;
+    int member_count = 0;
+    for (int c = 0; c < num_components; c++) {
+        renumber[c] = -1;
+    }
+    for (int v = 0; v < total_nodes; v++) {
+        int c = component[v];
+        if (component_size[c] > 1 && renumber[c] < 0) {
+            renumber[c] = cycles->num_cycles++;
+            member_count += component_size[c];
+        }
+    }
+    
+    // Counting sort of members by cycle; scanning v upwards keeps each
+    // cycle's processes before its resources, both ascending
+    cycles->offsets = checked_calloc((size_t)cycles->num_cycles + 1, sizeof(int));
+    cycles->nodes = checked_malloc(((size_t)member_count + 1) * sizeof(int));
+    for (int c = 0; c < num_components; c++) {
+        if (renumber[c] >= 0) {
+            cycles->offsets[renumber[c] + 1] = component_size[c];
+        }
+    }
+    for (int c = 0; c < cycles->num_cycles; c++) {
+        cycles->offsets[c + 1] += cycles->offsets[c];
+    }
+    int *fill = frame_edge;
+    memcpy(fill, cycles->offsets, (size_t)cycles->num_cycles * sizeof(int));
+    for (int v = 0; v < total_nodes; v++) {
+        int c = renumber[component[v]];
+        if (c >= 0) {
+            cycles->nodes[fill[c]++] = v;
+        }
+    }
+    
+    free(index);
+    free(low);
+    free(component);
+    free(frame_node);
+    free(frame_edge);
+    free(scc_stack);
+    free(component_size);
 }
 
 // Display RAG in ASCII format
@@ -153,6 +332,23 @@ void display_rag(RAG *rag, SystemState *state) {
         printf("    ✓  NO CYCLE - Graph is acyclic\n");
     }
     
+    RagCycles cycles;
+    init_rag_cycles(&cycles);
+    find_rag_cycles(rag, &cycles);
+    for (int c = 0; c < cycles.num_cycles; c++) {
+        printf("    Cycle %d:", c + 1);
+        for (int k = cycles.offsets[c]; k < cycles.offsets[c + 1]; k++) {
+            int v = cycles.nodes[k];
+            if (v < state->num_processes) {
+                printf(" [%s]", state->process_names[v]);
+            } else {
+                printf(" (%s)", state->resource_names[v - state->num_processes]);
+            }
+        }
+        printf("\n");
+    }
+    free_rag_cycles(&cycles);
+    
     // Visual representation
     printf("\n  Visual Representation:\n");
     printf("  ───────────────────────\n\n");
@@ -164,15 +360,17 @@ void display_rag(RAG *rag, SystemState *state) {
     }
     printf("\n");
     
+    // Edges mirror the matrices: request iff need > 0, assignment iff allocation > 0
     for (int i = 0; i < state->num_processes; i++) {
         printf("  [%s]", state->process_names[i]);
         for (int j = 0; j < state->num_resources; j++) {
-            int rnode = state->num_processes + j;
-            if (rag->adj_matrix[i][rnode] == 1 && rag->adj_matrix[rnode][i] == 2) {
+            bool request = state->need[i][j] > 0;
+            bool assigned = state->allocation[i][j] > 0;
+            if (request && assigned) {
                 printf("  <──>   ");  // Both directions
-            } else if (rag->adj_matrix[i][rnode] == 1) {
+            } else if (request) {
                 printf("  ───>   ");  // Request
-            } else if (rag->adj_matrix[rnode][i] == 2) {
+            } else if (assigned) {
                 printf("  <───   ");  // Assignment
             } else {
                 printf("         ");
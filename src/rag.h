@@ -22,32 +22,85 @@ typedef struct {
     EdgeType type;
 } Edge;
 
+// DFS node colours: unvisited, on the current path, fully explored
+enum {
+    WHITE = 0,
+    GREY,
+    BLACK
+};
+
 // Resource Allocation Graph structure
+// Nodes 0..num_processes-1 are processes, the rest are resources.
+// Out-edges of node v are adj_targets[adj_offsets[v] .. adj_offsets[v + 1]).
 typedef struct {
     int num_processes;
     int num_resources;
     int num_edges;
-    Edge edges[MAX_PROCESSES * MAX_RESOURCES * 2];
-    // Adjacency matrix: 0 = no edge, 1 = request, 2 = assignment
-    int adj_matrix[MAX_PROCESSES + MAX_RESOURCES][MAX_PROCESSES + MAX_RESOURCES];
+    Edge *edges;        // edge list in build order
+    int *adj_offsets;   // num_processes + num_resources + 1 entries
+    int *adj_targets;   // num_edges entries
 } RAG;
 
+// Cycles of a RAG: its non-trivial strongly connected components.
+// Because every resource node only forwards a waiter to the holders, the
+// process members of an SCC are exactly an SCC of the collapsed wait-for
+// graph, and the resource members are the resources linking them.
+// Component c is nodes[offsets[c] .. offsets[c + 1]): process ids ascending,
+// then resource node ids ascending. Components are ordered by their lowest
+// process id. With single-instance resources every component is a deadlock.
+typedef struct {
+    int num_cycles;
+    int *offsets;       // num_cycles + 1 entries
+    int *nodes;         // node ids, offsets[num_cycles] entries
+} RagCycles;
+
 // Function Prototypes
 
 /**
- * Build RAG from system state
+ * Initialize an empty RAG
+ * @param rag Pointer to RAG structure
+ */
+void init_rag(RAG *rag);
+
+/**
+ * Release memory owned by a RAG
+ * @param rag Pointer to RAG structure
+ */
+void free_rag(RAG *rag);
+
+/**
+ * Build RAG from system state (replaces any previous contents)
  * @param state Pointer to SystemState
  * @param rag Pointer to RAG structure
  */
 void build_rag(SystemState *state, RAG *rag);
 
 /**
- * Detect cycle in RAG using DFS
+ * Detect cycle in RAG using an iterative DFS, O(V + E)
  * @param rag Pointer to RAG structure
  * @return true if cycle exists (deadlock)
  */
 bool detect_cycle_rag(RAG *rag);
 
+/**
+ * Find every cycle in the RAG with one iterative Tarjan SCC pass, O(V + E)
+ * @param rag Pointer to RAG structure
+ * @param cycles Output; previous contents are released
+ */
+void find_rag_cycles(RAG *rag, RagCycles *cycles);
+
+/**
+ * Initialize an empty cycle list
+ * @param cycles Pointer to RagCycles
+ */
+void init_rag_cycles(RagCycles *cycles);
+
+/**
+ * Release memory owned by a cycle list
+ * @param cycles Pointer to RagCycles
+ */
+void free_rag_cycles(RagCycles *cycles);
+
 /**
  * Display RAG in ASCII format
  * @param rag Pointer to RAG structure
@@ -56,8 +109,14 @@ bool detect_cycle_rag(RAG *rag);
 void display_rag(RAG *rag, SystemState *state);
 
 /**
- * Helper DFS function for cycle detection
+ * Helper DFS function for cycle detection (explicit stack, no recursion)
+ * @param rag Pointer to RAG structure
+ * @param root Node to start from; must be WHITE
+ * @param colour Per-node WHITE/GREY/BLACK, updated in place
+ * @param frame_node Scratch stack, one entry per node
+ * @param frame_edge Scratch stack, one entry per node
+ * @return true if a back edge (cycle) is reachable from root
  */
-bool dfs_cycle(RAG *rag, int node, bool visited[], bool rec_stack[]);
+bool dfs_cycle(RAG *rag, int root, unsigned char colour[], int frame_node[], int frame_edge[]);
 
 #endif // RAG_H
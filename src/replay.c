@@ -0,0 +1,302 @@
+/*
+ * Deadlock Detection System
+ * Trace replay on top of the incremental detector
+ */
+
+#define _POSIX_C_SOURCE 200809L  /* fileno, mmap */
+
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include "replay.h"
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+// Stream buffer; a line longer than this is rejected
+#define REPLAY_CHUNK (1 << 20)
+
+typedef struct {
+    const char *word;
+    size_t length;
+    EventKind kind;
+} EventWord;
+
+static const EventWord event_words[] = {
+    { "alloc", 5, EVENT_ALLOCATE },
+    { "A", 1, EVENT_ALLOCATE },
+    { "release", 7, EVENT_RELEASE },
+    { "R", 1, EVENT_RELEASE },
+    { "request", 7, EVENT_REQUEST },
+    { "Q", 1, EVENT_REQUEST },
+    { "max", 3, EVENT_MAX },
+    { "M", 1, EVENT_MAX },
+};
+
+// Parser state carried across chunks
+typedef struct {
+    IncrementalDetector det;
+    bool started;           // header complete, detector initialized
+    int dims[2];            // num_processes, num_resources
+    int *available;         // header values read so far
+    int header_count;
+    bool done;
+    ReplayReport *report;
+} Replay;
+
+const char *event_kind_name(EventKind kind) {
+    switch (kind) {
+        case EVENT_ALLOCATE: return "alloc";
+        case EVENT_RELEASE:  return "release";
+        case EVENT_REQUEST:  return "request";
+        default:             return "max";
+    }
+}
+
+bool replay_apply(IncrementalDetector *det, const ReplayEvent *event) {
+    SystemState *state = &det->state;
+    int p = event->process;
+    int r = event->resource;
+    int k = event->amount;
+    if (p < 0 || p >= state->num_processes || r < 0 || r >= state->num_resources) {
+        return false;
+    }
+
+    switch (event->kind) {
+        case EVENT_ALLOCATE:
+            if (k <= 0 || k > state->available[r]) return false;
+            if (k > state->need[p][r] &&
+                !incremental_set_max(det, p, r, state->allocation[p][r] + k)) {
+                return false;
+            }
+            return incremental_allocate(det, p, r, k);
+        case EVENT_RELEASE:
+            return incremental_release(det, p, r, k);
+        case EVENT_REQUEST:
+            if (k <= 0 || k > INT_MAX - state->allocation[p][r]) return false;
+            if (k > state->need[p][r]) {
+                return incremental_set_max(det, p, r, state->allocation[p][r] + k);
+            }
+            return true;
+        default:
+            return incremental_set_max(det, p, r, k);
+    }
+}
+
+static const char *skip_blanks(const char *s, const char *end) {
+    while (s < end && (*s == ' ' || *s == '\t' || *s == '\r')) s++;
+    return s;
+}
+
+// Optional '-' then digits; false on a missing number or overflow
+static bool parse_int(const char **cursor, const char *end, int *out) {
+    const char *s = skip_blanks(*cursor, end);
+    bool negative = s < end && *s == '-';
+    if (negative) s++;
+    if (s >= end || *s < '0' || *s > '9') return false;
+    long long value = 0;
+    while (s < end && *s >= '0' && *s <= '9') {
+        value = value * 10 + (*s++ - '0');
+        if (value > INT_MAX) return false;
+    }
+    *out = (int)(negative ? -value : value);
+    *cursor = s;
+    return true;
+}
+
+static bool line_ends(const char *s, const char *end) {
+    s = skip_blanks(s, end);
+    return s == end || *s == '#';
+}
+
+static void fail(Replay *rp, const char *error) {
+    rp->report->status = REPLAY_INVALID;
+    rp->report->error = error;
+    rp->done = true;
+}
+
+// Header values (dimensions, then Available) may span several lines
+static void header_line(Replay *rp, const char *s, const char *end) {
+    while (!line_ends(s, end)) {
+        int value;
+        if (!parse_int(&s, end, &value)) {
+            fail(rp, rp->header_count < 2 ? "expected the process and resource counts"
+                                          : "expected the available units");
+            return;
+        }
+        if (rp->header_count < 2) {
+            rp->dims[rp->header_count++] = value;
+            if (rp->header_count == 2) {
+                if (value < 1 || value > MAX_RESOURCES ||
+                    rp->dims[0] < 1 || rp->dims[0] > MAX_PROCESSES) {
+                    fail(rp, "invalid dimensions");
+                    return;
+                }
+                rp->available = checked_malloc((size_t)value * sizeof(int));
+            }
+        } else {
+            if (value < 0) {
+                fail(rp, "available units must be non-negative");
+                return;
+            }
+            rp->available[rp->header_count++ - 2] = value;
+        }
+
+        if (rp->header_count == 2 + rp->dims[1]) {
+            if (!line_ends(s, end)) {
+                fail(rp, "unexpected text after the available units");
+                return;
+            }
+            SystemState initial;
+            if (!init_system_state(&initial, rp->dims[0], rp->dims[1])) {
+                fail(rp, "out of memory");
+                return;
+            }
+            memcpy(initial.available, rp->available, (size_t)rp->dims[1] * sizeof(int));
+            bool ok = incremental_init(&rp->det, &initial);
+            free_system_state(&initial);
+            if (!ok) {
+                fail(rp, "out of memory");
+                return;
+            }
+            rp->started = true;
+            return;
+        }
+    }
+}
+
+bool event_kind_parse(const char *word, size_t length, EventKind *kind) {
+    size_t count = sizeof(event_words) / sizeof(event_words[0]);
+    for (size_t w = 0; w < count; w++) {
+        if (event_words[w].length == length && memcmp(event_words[w].word, word, length) == 0) {
+            *kind = event_words[w].kind;
+            return true;
+        }
+    }
+    return false;
+}
+
+static void event_line(Replay *rp, const char *s, const char *end) {
+    ReplayReport *report = rp->report;
+    const char *word = s;
+    while (s < end && ((*s >= 'a' && *s <= 'z') || (*s >= 'A' && *s <= 'Z'))) s++;
+
+    ReplayEvent event;
+    report->event_index = report->events;
+    if (!event_kind_parse(word, (size_t)(s - word), &event.kind)) {
+        fail(rp, "unknown event (expected alloc, release, request or max)");
+        return;
+    }
+    if (!parse_int(&s, end, &event.process) || !parse_int(&s, end, &event.resource) ||
+        !parse_int(&s, end, &event.amount) || !line_ends(s, end)) {
+        fail(rp, "expected <event> <process> <resource> <amount>");
+        return;
+    }
+    if (!replay_apply(&rp->det, &event)) {
+        fail(rp, "event does not fit the current state");
+        return;
+    }
+    report->events++;
+
+    // Clean means the last safe sequence is still a witness: no detection
+    if (rp->det.dirty) {
+        const DetectionResult *result = incremental_query(&rp->det);
+        if (result->is_deadlocked) {
+            report->status = REPLAY_UNSAFE;
+            report->event = event;
+            report->num_blocked = result->num_deadlocked;
+            report->blocked = checked_malloc(((size_t)result->num_deadlocked + 1) * sizeof(int));
+            memcpy(report->blocked, result->deadlocked_processes,
+                   (size_t)result->num_deadlocked * sizeof(int));
+            rp->done = true;
+        }
+    }
+}
+
+// Handle the complete lines in [data, data + length); at the end of the
+// input the last line needs no newline. Returns the bytes consumed.
+static size_t replay_feed(Replay *rp, const char *data, size_t length, bool at_end) {
+    const char *s = data;
+    const char *end = data + length;
+    while (s < end && !rp->done) {
+        const char *newline = memchr(s, '\n', (size_t)(end - s));
+        if (!newline && !at_end) break;
+        const char *line_end = newline ? newline : end;
+
+        rp->report->line++;
+        const char *t = skip_blanks(s, line_end);
+        if (t < line_end && *t != '#') {
+            if (rp->started) event_line(rp, t, line_end);
+            else header_line(rp, t, line_end);
+        }
+        s = newline ? newline + 1 : end;
+    }
+    return (size_t)(s - data);
+}
+
+static void replay_stream(Replay *rp, FILE *in) {
+    char *buffer = checked_malloc(REPLAY_CHUNK);
+    size_t kept = 0;
+    while (!rp->done) {
+        size_t n = fread(buffer + kept, 1, REPLAY_CHUNK - kept, in);
+        bool at_end = n == 0;
+        size_t length = kept + n;
+        size_t used = replay_feed(rp, buffer, length, at_end);
+        if (at_end) break;
+        kept = length - used;
+        if (kept == REPLAY_CHUNK) {
+            rp->report->line++;
+            fail(rp, "line too long");
+            break;
+        }
+        memmove(buffer, buffer + used, kept);
+    }
+    free(buffer);
+}
+
+ReplayStatus replay_file(FILE *in, ReplayReport *report) {
+    Replay rp;
+    memset(&rp, 0, sizeof(rp));
+    memset(report, 0, sizeof(*report));
+    report->event_index = -1;
+    rp.report = report;
+
+    bool mapped = false;
+#ifndef _WIN32
+    struct stat st;
+    int fd = fileno(in);
+    if (fd >= 0 && fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+        size_t size = (size_t)st.st_size;
+        void *map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map != MAP_FAILED) {
+            posix_madvise(map, size, POSIX_MADV_SEQUENTIAL);
+            replay_feed(&rp, map, size, true);
+            munmap(map, size);
+            mapped = true;
+        }
+    }
+#endif
+    if (!mapped) {
+        replay_stream(&rp, in);
+    }
+
+    if (!rp.done && !rp.started) {
+        fail(&rp, "incomplete header");
+    }
+    if (report->status != REPLAY_INVALID && report->status != REPLAY_UNSAFE) {
+        report->event_index = -1;
+        report->line = 0;
+    }
+    report->full_detections = rp.det.full_runs;
+    if (rp.started) incremental_free(&rp.det);
+    free(rp.available);
+    return report->status;
+}
+
+void free_replay_report(ReplayReport *report) {
+    free(report->blocked);
+    report->blocked = NULL;
+    report->num_blocked = 0;
+}
@@ -0,0 +1,91 @@
+/*
+ * Deadlock Detection System
+ * Trace replay: apply allocation events and stop at the first unsafe state
+ */
+
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <stdbool.h>
+#include <stdio.h>
+#include "incremental.h"
+
+// Trace format (text, one item per line, '#' starts a comment):
+//   num_processes num_resources
+//   available[0] ... available[nr-1]      (free units at the start)
+//   then one event per line: <kind> <process> <resource> <amount>
+// Every process starts holding and claiming nothing.
+typedef enum {
+    EVENT_ALLOCATE,     // "alloc" / "A": grant units (the claim grows to fit)
+    EVENT_RELEASE,      // "release" / "R": return held units (the claim stays)
+    EVENT_REQUEST,      // "request" / "Q": need at least amount more units
+    EVENT_MAX           // "max" / "M": set the maximum claim
+} EventKind;
+
+typedef struct {
+    EventKind kind;
+    int process;
+    int resource;
+    int amount;
+} ReplayEvent;
+
+typedef enum {
+    REPLAY_SAFE,        // every event applied, the state stayed safe
+    REPLAY_UNSAFE,      // an event left no safe sequence
+    REPLAY_INVALID      // malformed trace or an event the state cannot take
+} ReplayStatus;
+
+typedef struct {
+    ReplayStatus status;
+    long long events;           // events applied (UNSAFE: including the last one)
+    long long event_index;      // UNSAFE/INVALID: 0-based index of that event (-1 in the header)
+    long long line;             // UNSAFE/INVALID: 1-based line number
+    ReplayEvent event;          // UNSAFE: the event that made the state unsafe
+    const char *error;          // INVALID: what was wrong
+    int *blocked;               // UNSAFE: processes that cannot finish
+    int num_blocked;
+    long full_detections;       // full detections run, including the initial one
+} ReplayReport;
+
+/**
+ * Apply one event to the detector
+ * @param det Pointer to IncrementalDetector
+ * @param event Event to apply
+ * @return false (state unchanged) if the event is out of range or
+ *         impossible (granting more than is available, releasing more
+ *         than is held, a claim below the allocation)
+ */
+bool replay_apply(IncrementalDetector *det, const ReplayEvent *event);
+
+/**
+ * Replay a trace until it ends or the state becomes unsafe
+ * Regular files are mapped into memory; anything else (stdin, pipes) is
+ * read in chunks. Each event costs one incremental update; a full
+ * detection only runs when the last safe sequence stops being a witness.
+ * @param in Trace to read, positioned at its start
+ * @param report Output; release with free_replay_report()
+ * @return report->status
+ */
+ReplayStatus replay_file(FILE *in, ReplayReport *report);
+
+/**
+ * Release memory owned by a report
+ * @param report Pointer to ReplayReport
+ */
+void free_replay_report(ReplayReport *report);
+
+/**
+ * Name of an event kind as written in traces ("alloc", "release", ...)
+ */
+const char *event_kind_name(EventKind kind);
+
+/**
+ * Event kind for a word as written in traces (long or short form)
+ * @param word Start of the word (need not be terminated)
+ * @param length Length of the word
+ * @param kind Receives the kind
+ * @return false if the word is not an event kind
+ */
+bool event_kind_parse(const char *word, size_t length, EventKind *kind);
+
+#endif // REPLAY_H
@@ -0,0 +1,196 @@
+/*
+ * Deadlock Detection System
+ * Vector kernels for the detector's inner loops (runtime CPU dispatch)
+ */
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include "simd_kernels.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SIMD_X86 1
+#include <immintrin.h>
+#endif
+
+// Scalar fallback
+static bool all_le_scalar(const int *a, const int *b, int n) {
+    for (int j = 0; j < n; j++) {
+        if (a[j] > b[j]) return false;
+    }
+    return true;
+}
+
+static void add_scalar(int *dst, const int *src, int n) {
+    for (int j = 0; j < n; j++) {
+        dst[j] += src[j];
+    }
+}
+
+static int count_gt_scalar(const int *a, const int *b, int n) {
+    int count = 0;
+    for (int j = 0; j < n; j++) {
+        count += a[j] > b[j];
+    }
+    return count;
+}
+
+#ifdef SIMD_X86
+
+// SSE2: four lanes per register, one 16-lane block per iteration
+__attribute__((target("sse2")))
+static bool all_le_sse2(const int *a, const int *b, int n) {
+    for (int j = 0; j < n; j += 16) {
+        __m128i gt = _mm_cmpgt_epi32(_mm_loadu_si128((const __m128i *)(a + j)),
+                                     _mm_loadu_si128((const __m128i *)(b + j)));
+        gt = _mm_or_si128(gt, _mm_cmpgt_epi32(_mm_loadu_si128((const __m128i *)(a + j + 4)),
+                                              _mm_loadu_si128((const __m128i *)(b + j + 4))));
+        gt = _mm_or_si128(gt, _mm_cmpgt_epi32(_mm_loadu_si128((const __m128i *)(a + j + 8)),
+                                              _mm_loadu_si128((const __m128i *)(b + j + 8))));
+        gt = _mm_or_si128(gt, _mm_cmpgt_epi32(_mm_loadu_si128((const __m128i *)(a + j + 12)),
+                                              _mm_loadu_si128((const __m128i *)(b + j + 12))));
+        if (_mm_movemask_epi8(gt)) return false;
+    }
+    return true;
+}
+
+__attribute__((target("sse2")))
+static void add_sse2(int *dst, const int *src, int n) {
+    for (int j = 0; j < n; j += 4) {
+        __m128i d = _mm_loadu_si128((const __m128i *)(dst + j));
+        __m128i s = _mm_loadu_si128((const __m128i *)(src + j));
+        _mm_storeu_si128((__m128i *)(dst + j), _mm_add_epi32(d, s));
+    }
+}
+
+__attribute__((target("sse2")))
+static int count_gt_sse2(const int *a, const int *b, int n) {
+    __m128i acc = _mm_setzero_si128();
+    for (int j = 0; j < n; j += 4) {
+        // Comparison lanes are -1 where a > b; subtracting counts them
+        acc = _mm_sub_epi32(acc, _mm_cmpgt_epi32(_mm_loadu_si128((const __m128i *)(a + j)),
+                                                 _mm_loadu_si128((const __m128i *)(b + j))));
+    }
+    int lanes[4];
+    _mm_storeu_si128((__m128i *)lanes, acc);
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3];
+}
+
+// AVX2: eight lanes per register, one 16-lane block per iteration
+__attribute__((target("avx2")))
+static bool all_le_avx2(const int *a, const int *b, int n) {
+    for (int j = 0; j < n; j += 16) {
+        __m256i gt0 = _mm256_cmpgt_epi32(_mm256_loadu_si256((const __m256i *)(a + j)),
+                                         _mm256_loadu_si256((const __m256i *)(b + j)));
+        __m256i gt1 = _mm256_cmpgt_epi32(_mm256_loadu_si256((const __m256i *)(a + j + 8)),
+                                         _mm256_loadu_si256((const __m256i *)(b + j + 8)));
+        if (!_mm256_testz_si256(_mm256_or_si256(gt0, gt1), _mm256_set1_epi32(-1))) return false;
+    }
+    return true;
+}
+
+__attribute__((target("avx2")))
+static void add_avx2(int *dst, const int *src, int n) {
+    for (int j = 0; j < n; j += 8) {
+        __m256i d = _mm256_loadu_si256((const __m256i *)(dst + j));
+        __m256i s = _mm256_loadu_si256((const __m256i *)(src + j));
+        _mm256_storeu_si256((__m256i *)(dst + j), _mm256_add_epi32(d, s));
+    }
+}
+
+__attribute__((target("avx2")))
+static int count_gt_avx2(const int *a, const int *b, int n) {
+    __m256i acc = _mm256_setzero_si256();
+    for (int j = 0; j < n; j += 8) {
+        acc = _mm256_sub_epi32(acc, _mm256_cmpgt_epi32(_mm256_loadu_si256((const __m256i *)(a + j)),
+                                                       _mm256_loadu_si256((const __m256i *)(b + j))));
+    }
+    __m128i sum = _mm_add_epi32(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0x4e));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0xb1));
+    return _mm_cvtsi128_si32(sum);
+}
+
+// AVX-512: one 16-lane block per register, comparisons yield a bit mask
+__attribute__((target("avx512f")))
+static bool all_le_avx512(const int *a, const int *b, int n) {
+    for (int j = 0; j < n; j += 16) {
+        if (_mm512_cmpgt_epi32_mask(_mm512_loadu_si512(a + j), _mm512_loadu_si512(b + j))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+__attribute__((target("avx512f")))
+static void add_avx512(int *dst, const int *src, int n) {
+    for (int j = 0; j < n; j += 16) {
+        _mm512_storeu_si512(dst + j, _mm512_add_epi32(_mm512_loadu_si512(dst + j),
+                                                      _mm512_loadu_si512(src + j)));
+    }
+}
+
+__attribute__((target("avx512f")))
+static int count_gt_avx512(const int *a, const int *b, int n) {
+    int count = 0;
+    for (int j = 0; j < n; j += 16) {
+        count += __builtin_popcount(_mm512_cmpgt_epi32_mask(_mm512_loadu_si512(a + j),
+                                                            _mm512_loadu_si512(b + j)));
+    }
+    return count;
+}
+
+#endif // SIMD_X86
+
+static bool (*all_le_impl)(const int *, const int *, int) = all_le_scalar;
+static void (*add_impl)(int *, const int *, int) = add_scalar;
+static int (*count_gt_impl)(const int *, const int *, int) = count_gt_scalar;
+static const char *level_name = "scalar";
+
+// Pick the widest kernel set the CPU supports, before main() runs.
+// DEADLOCK_SIMD=scalar|sse2|avx2 caps the choice (for benchmarking).
+__attribute__((constructor))
+static void select_kernels(void) {
+#ifdef SIMD_X86
+    const char *cap = getenv("DEADLOCK_SIMD");
+    int max_level = 3;
+    if (cap) {
+        if (strcmp(cap, "scalar") == 0) max_level = -1;
+        else if (strcmp(cap, "sse2") == 0) max_level = 1;
+        else if (strcmp(cap, "avx2") == 0) max_level = 2;
+    }
+    __builtin_cpu_init();
+    if (max_level >= 3 && __builtin_cpu_supports("avx512f")) {
+        all_le_impl = all_le_avx512;
+        add_impl = add_avx512;
+        count_gt_impl = count_gt_avx512;
+        level_name = "avx512";
+    } else if (max_level >= 2 && __builtin_cpu_supports("avx2")) {
+        all_le_impl = all_le_avx2;
+        add_impl = add_avx2;
+        count_gt_impl = count_gt_avx2;
+        level_name = "avx2";
+    } else if (max_level >= 1 && __builtin_cpu_supports("sse2")) {
+        all_le_impl = all_le_sse2;
+        add_impl = add_sse2;
+        count_gt_impl = count_gt_sse2;
+        level_name = "sse2";
+    }
+#endif
+}
+
+bool vec_all_le(const int *a, const int *b, int n) {
+    return all_le_impl(a, b, n);
+}
+
+void vec_add(int *dst, const int *src, int n) {
+    add_impl(dst, src, n);
+}
+
+int vec_count_gt(const int *a, const int *b, int n) {
+    return count_gt_impl(a, b, n);
+}
+
+const char *simd_level(void) {
+    return level_name;
+}
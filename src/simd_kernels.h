@@ -0,0 +1,36 @@
+/*
+ * Deadlock Detection System
+ * Vector kernels for the detector's inner loops (runtime CPU dispatch)
+ */
+
+#ifndef SIMD_KERNELS_H
+#define SIMD_KERNELS_H
+
+#include <stdbool.h>
+
+// All kernels take n as a multiple of ROW_ALIGN_INTS (16); SystemState rows
+// and available are padded to row_stride with zeros, so they can be passed
+// straight through. The implementation (AVX-512, AVX2, SSE2 or scalar) is
+// chosen once at program start from cpuid.
+
+/**
+ * Vector compare with early exit: a[j] <= b[j] for every j < n
+ */
+bool vec_all_le(const int *a, const int *b, int n);
+
+/**
+ * Vector add: dst[j] += src[j] for j < n
+ */
+void vec_add(int *dst, const int *src, int n);
+
+/**
+ * Number of lanes j < n with a[j] > b[j]
+ */
+int vec_count_gt(const int *a, const int *b, int n);
+
+/**
+ * Name of the selected kernel set ("avx512", "avx2", "sse2" or "scalar")
+ */
+const char *simd_level(void);
+
+#endif // SIMD_KERNELS_H
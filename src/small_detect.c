@@ -0,0 +1,254 @@
+/*
+ * Deadlock Detection System
+ * Detection kernels specialized for small fixed dimensions
+ */
+
+#include <stdint.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#include "small_detect.h"
+#include "stats.h"
+
+// Lane layouts: 8-bit lanes in one word; 16-bit lanes in one word (up to
+// 4 resources) or two
+enum { LAYOUT_B8, LAYOUT_H4, LAYOUT_H8, NUM_LAYOUTS };
+
+// Largest resource total a lane holds below its spare top bit; Need may
+// reach one more
+#define LANE8_LIMIT 126
+#define LANE16_LIMIT 32766
+#define LANE16_MASK 0x7FFF
+
+#define LANES8_HIGH  0x8080808080808080ULL
+#define LANES16_HIGH 0x8000800080008000ULL
+
+// need <= work in every lane, with both below the top bit: no lane borrows
+// from the next, and a lane's top bit survives exactly when it fits
+#define SWAR_LE(need, work, high) (((((work) | (high)) - (need)) & (high)) == (high))
+
+typedef struct {
+    uint64_t need[SMALL_MAX_PROCESSES][2];
+    uint64_t allocation[SMALL_MAX_PROCESSES][2];
+    uint64_t work[2];
+} PackedState;
+
+// Runs passes until one finishes nobody; returns the unfinished bits
+typedef uint32_t (*SmallKernel)(const PackedState *ps, uint32_t pending, int *sequence,
+                                int *length, int *passes, int *checks);
+
+// Process i of an unrolled pass. NP and WORDS are constants, so the bucket
+// and second-word tests fold away.
+#define SMALL_TRY(i)                                                    \
+    if ((i) < NP && (pending >> (i) & 1u)) {                            \
+        checks++;                                                       \
+        if (SWAR_LE(ps->need[i][0], w0, HIGH) &&                        \
+            (WORDS == 1 || SWAR_LE(ps->need[i][1], w1, HIGH))) {        \
+            w0 += ps->allocation[i][0];                                 \
+            if (WORDS == 2) w1 += ps->allocation[i][1];                 \
+            pending &= ~(1u << (i));                                    \
+            sequence[n++] = (i);                                        \
+        }                                                               \
+    }
+
+// A pass that empties pending ends the loop; the rescan would make one
+// more pass (with no checks) before stopping, which passes counts
+#define DEFINE_SMALL_KERNEL(name, np, words, high)                      \
+    static uint32_t name(const PackedState *ps, uint32_t pending,       \
+                         int *sequence, int *length, int *passes,       \
+                         int *checks_out) {                             \
+        enum { NP = np, WORDS = words };                                \
+        const uint64_t HIGH = high;                                     \
+        uint64_t w0 = ps->work[0];                                      \
+        uint64_t w1 = ps->work[1];                                      \
+        int n = 0;                                                      \
+        int p = 0;                                                      \
+        int checks = 0;                                                 \
+        uint32_t before;                                                \
+        do {                                                            \
+            before = pending;                                           \
+            p++;                                                        \
+            SMALL_TRY(0) SMALL_TRY(1) SMALL_TRY(2) SMALL_TRY(3)         \
+            SMALL_TRY(4) SMALL_TRY(5) SMALL_TRY(6) SMALL_TRY(7)         \
+            SMALL_TRY(8) SMALL_TRY(9) SMALL_TRY(10) SMALL_TRY(11)       \
+            SMALL_TRY(12) SMALL_TRY(13) SMALL_TRY(14) SMALL_TRY(15)     \
+        } while (pending != before && pending != 0);                    \
+        (void)w1;                                                       \
+        *length = n;                                                    \
+        *passes = p + (pending != before);                              \
+        *checks_out = checks;                                           \
+        return pending;                                                 \
+    }
+
+DEFINE_SMALL_KERNEL(small_p4_b8, 4, 1, LANES8_HIGH)
+DEFINE_SMALL_KERNEL(small_p8_b8, 8, 1, LANES8_HIGH)
+DEFINE_SMALL_KERNEL(small_p16_b8, 16, 1, LANES8_HIGH)
+DEFINE_SMALL_KERNEL(small_p4_h4, 4, 1, LANES16_HIGH)
+DEFINE_SMALL_KERNEL(small_p8_h4, 8, 1, LANES16_HIGH)
+DEFINE_SMALL_KERNEL(small_p16_h4, 16, 1, LANES16_HIGH)
+DEFINE_SMALL_KERNEL(small_p4_h8, 4, 2, LANES16_HIGH)
+DEFINE_SMALL_KERNEL(small_p8_h8, 8, 2, LANES16_HIGH)
+DEFINE_SMALL_KERNEL(small_p16_h8, 16, 2, LANES16_HIGH)
+
+// [layout][process bucket: up to 4, 8, 16]
+static const SmallKernel kernels[NUM_LAYOUTS][3] = {
+    { small_p4_b8, small_p8_b8, small_p16_b8 },
+    { small_p4_h4, small_p8_h4, small_p16_h4 },
+    { small_p4_h8, small_p8_h8, small_p16_h8 },
+};
+
+// Pack two words of 16-bit lanes (each below 128) into one of 8-bit lanes
+static inline uint64_t narrow_lanes(const uint64_t *words) {
+    uint64_t packed[2];
+    for (int w = 0; w < 2; w++) {
+        uint64_t x = words[w];
+        x = (x | x >> 8) & 0x0000FFFF0000FFFFULL;
+        x = (x | x >> 16) & 0x00000000FFFFFFFFULL;
+        packed[w] = x;
+    }
+    return packed[0] | packed[1] << 32;
+}
+
+// Calculate Need and pack every row's Need and Allocation into 16-bit
+// lanes, summing each resource's total. Need is clamped to [0, 32767],
+// which changes no comparison with a Work of at most 32766. Returns every
+// available and allocation value or-ed together (sign and high bits).
+#ifdef __SSE2__
+
+// Rows are padded with zeros to 16 ints, so all 8 lanes load unconditionally
+static int pack_rows(SystemState *state, PackedState *ps, int *total) {
+    __m128i total_lo = _mm_loadu_si128((const __m128i *)state->available);
+    __m128i total_hi = _mm_loadu_si128((const __m128i *)(state->available + 4));
+    __m128i seen = _mm_or_si128(total_lo, total_hi);
+    __m128i zero = _mm_setzero_si128();
+    for (int i = 0; i < state->num_processes; i++) {
+        const int *allocation = state->allocation[i];
+        const int *max_need = state->max_need[i];
+        int *need = state->need[i];
+        __m128i a_lo = _mm_loadu_si128((const __m128i *)allocation);
+        __m128i a_hi = _mm_loadu_si128((const __m128i *)(allocation + 4));
+        __m128i d_lo = _mm_sub_epi32(_mm_loadu_si128((const __m128i *)max_need), a_lo);
+        __m128i d_hi = _mm_sub_epi32(_mm_loadu_si128((const __m128i *)(max_need + 4)), a_hi);
+        _mm_storeu_si128((__m128i *)need, d_lo);
+        _mm_storeu_si128((__m128i *)(need + 4), d_hi);
+        seen = _mm_or_si128(seen, _mm_or_si128(a_lo, a_hi));
+        total_lo = _mm_add_epi32(total_lo, a_lo);
+        total_hi = _mm_add_epi32(total_hi, a_hi);
+        // Signed saturation to 16 bits, then Need's floor of 0
+        _mm_storeu_si128((__m128i *)ps->need[i], _mm_max_epi16(_mm_packs_epi32(d_lo, d_hi), zero));
+        _mm_storeu_si128((__m128i *)ps->allocation[i], _mm_packs_epi32(a_lo, a_hi));
+    }
+    _mm_storeu_si128((__m128i *)total, total_lo);
+    _mm_storeu_si128((__m128i *)(total + 4), total_hi);
+    seen = _mm_or_si128(seen, _mm_srli_si128(seen, 8));
+    seen = _mm_or_si128(seen, _mm_srli_si128(seen, 4));
+    return _mm_cvtsi128_si32(seen);
+}
+
+#else
+
+// Resource j of a row, unrolled so the packed words stay in registers
+#define PACK_LANE(j, need_word, allocation_word)                        \
+    if ((j) < nr) {                                                     \
+        int a = allocation[j];                                          \
+        int d = max_need[j] - a;                                        \
+        need[j] = d;                                                    \
+        seen |= a;                                                      \
+        total[j] += a & LANE16_MASK;                                    \
+        uint64_t lane = (uint64_t)(d < 0 ? 0 : d > LANE16_MASK ? LANE16_MASK : d); \
+        need_word |= lane << ((j) % 4 * 16);                            \
+        allocation_word |= (uint64_t)(a & LANE16_MASK) << ((j) % 4 * 16); \
+    }
+
+static int pack_rows(SystemState *state, PackedState *ps, int *total) {
+    int nr = state->num_resources;
+    int seen = 0;
+    for (int j = 0; j < nr; j++) {
+        total[j] = state->available[j];
+        seen |= state->available[j];
+    }
+    for (int i = 0; i < state->num_processes; i++) {
+        const int *allocation = state->allocation[i];
+        const int *max_need = state->max_need[i];
+        int *need = state->need[i];
+        uint64_t need0 = 0, need1 = 0, allocation0 = 0, allocation1 = 0;
+        PACK_LANE(0, need0, allocation0) PACK_LANE(1, need0, allocation0)
+        PACK_LANE(2, need0, allocation0) PACK_LANE(3, need0, allocation0)
+        PACK_LANE(4, need1, allocation1) PACK_LANE(5, need1, allocation1)
+        PACK_LANE(6, need1, allocation1) PACK_LANE(7, need1, allocation1)
+        ps->need[i][0] = need0;
+        ps->need[i][1] = need1;
+        ps->allocation[i][0] = allocation0;
+        ps->allocation[i][1] = allocation1;
+    }
+    return seen;
+}
+
+#endif
+
+bool detect_deadlock_small(SystemState *state, DetectionResult *result) {
+    int np = state->num_processes;
+    int nr = state->num_resources;
+    if (np > SMALL_MAX_PROCESSES || nr > SMALL_MAX_RESOURCES) return false;
+    STATS_START(start);
+
+    PackedState ps;
+    int total[SMALL_MAX_RESOURCES];
+    int seen = pack_rows(state, &ps, total);
+    // Work never exceeds a resource's total, so the totals pick the lanes
+    if (seen & ~LANE16_MASK) return false;
+    int largest = 0;
+    uint64_t packed_total[2] = { 0, 0 };
+    uint64_t work[2] = { 0, 0 };
+    for (int j = 0; j < nr; j++) {
+        if (total[j] > LANE16_LIMIT) return false;
+        if (total[j] > largest) largest = total[j];
+        packed_total[j >> 2] |= (uint64_t)total[j] << ((j & 3) * 16);
+        work[j >> 2] |= (uint64_t)state->available[j] << ((j & 3) * 16);
+    }
+
+    // A process needing more than a total can never finish: it stays out of
+    // the kernel, which then only meets Need up to the total
+    uint32_t all = (1u << np) - 1u;
+    uint32_t candidates = 0;
+    for (int i = 0; i < np; i++) {
+        if (SWAR_LE(ps.need[i][0], packed_total[0], LANES16_HIGH) &&
+            SWAR_LE(ps.need[i][1], packed_total[1], LANES16_HIGH)) {
+            candidates |= 1u << i;
+        }
+    }
+    int layout;
+    if (largest <= LANE8_LIMIT) {
+        layout = LAYOUT_B8;
+        ps.work[0] = narrow_lanes(work);
+        for (int i = 0; i < np; i++) {
+            ps.need[i][0] = narrow_lanes(ps.need[i]);
+            ps.allocation[i][0] = narrow_lanes(ps.allocation[i]);
+        }
+    } else {
+        layout = nr <= 4 ? LAYOUT_H4 : LAYOUT_H8;
+        ps.work[0] = work[0];
+        ps.work[1] = work[1];
+    }
+
+    int bucket = np <= 4 ? 0 : np <= 8 ? 1 : 2;
+    int length;
+    int passes;
+    int checks;
+    uint32_t pending = kernels[layout][bucket](&ps, candidates, result->safe_sequence,
+                                               &length, &passes, &checks);
+    pending |= all & ~candidates;
+
+    result->safe_sequence_length = length;
+    result->num_deadlocked = 0;
+    for (int i = 0; i < np; i++) {
+        if (pending >> i & 1u) {
+            result->deadlocked_processes[result->num_deadlocked++] = i;
+        }
+    }
+    result->is_deadlocked = result->num_deadlocked > 0;
+    STATS_ADD(passes, passes);
+    STATS_ADD(comparisons, checks);
+    STATS_STOP(STAT_DETECT, start);
+    return true;
+}
@@ -0,0 +1,37 @@
+/*
+ * Deadlock Detection System
+ * Detection kernels specialized for small fixed dimensions
+ */
+
+#ifndef SMALL_DETECT_H
+#define SMALL_DETECT_H
+
+#include <stdbool.h>
+#include "deadlock_detector.h"
+
+// Largest dimensions with a specialized kernel
+#define SMALL_MAX_PROCESSES 16
+#define SMALL_MAX_RESOURCES 8
+
+/**
+ * Detect deadlock with a kernel specialized for the state's dimensions
+ * Each row of Need and Allocation is packed into one or two 64-bit words,
+ * one lane per resource: 8 bits, or 16 when some resource has more than
+ * 126 units in total. Lanes keep their top bit spare, so a single
+ * subtraction, (Work | top bits) - Need, clears a lane's top bit exactly
+ * where Need exceeds Work, and Work stays in registers. Kernels are
+ * generated per process bucket (4, 8, 16) and lane layout, with each pass
+ * over the processes fully unrolled. The result is identical to
+ * detect_deadlock_rescan().
+ *
+ * Need is calculated along the way (as by calculate_need_matrix()), and
+ * result must have room for num_processes entries.
+ * @param state Pointer to SystemState structure (need is recalculated)
+ * @param result Receives deadlock status and safe sequence
+ * @return false, writing nothing, if no kernel fits: more than
+ *   SMALL_MAX_PROCESSES processes or SMALL_MAX_RESOURCES resources, a
+ *   negative available or allocation, or more than 32766 units of a resource
+ */
+bool detect_deadlock_small(SystemState *state, DetectionResult *result);
+
+#endif // SMALL_DETECT_H
@@ -0,0 +1,65 @@
+/*
+ * Deadlock Detection System
+ * Canonical 64-bit hash of a system state
+ */
+
+#include "state_hash.h"
+
+#define ROTL32(x, r) (((x) << (r)) | ((x) >> (32 - (r))))
+
+typedef struct {
+    uint32_t h1;
+    uint32_t h2;
+} HashLanes;
+
+static inline void mix_word(HashLanes *h, uint32_t w) {
+    uint32_t k1 = w * 0xcc9e2d51u;
+    k1 = ROTL32(k1, 15) * 0x1b873593u;
+    h->h1 = ROTL32(h->h1 ^ k1, 13) * 5u + 0xe6546b64u;
+
+    uint32_t k2 = w * 0x85ebca6bu;
+    k2 = ROTL32(k2, 16) * 0xc2b2ae35u;
+    h->h2 = ROTL32(h->h2 ^ k2, 17) * 9u + 0x7feb352du;
+}
+
+static void mix_row(HashLanes *h, const int *row, int n) {
+    for (int j = 0; j < n; j++) {
+        mix_word(h, (uint32_t)row[j]);
+    }
+}
+
+static uint32_t fmix32(uint32_t h) {
+    h ^= h >> 16;
+    h *= 0x85ebca6bu;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35u;
+    h ^= h >> 16;
+    return h;
+}
+
+uint64_t state_hash(const SystemState *state) {
+    int np = state->num_processes;
+    int nr = state->num_resources;
+    HashLanes h = { 0x9e3779b9u, 0x632be5abu };
+    mix_word(&h, (uint32_t)np);
+    mix_word(&h, (uint32_t)nr);
+    mix_row(&h, state->available, nr);
+    for (int i = 0; i < np; i++) {
+        mix_row(&h, state->allocation[i], nr);
+    }
+    for (int i = 0; i < np; i++) {
+        mix_row(&h, state->max_need[i], nr);
+    }
+
+    // Length in words, then the MurmurHash3 x86_128 style finish for two lanes
+    uint32_t words = (uint32_t)(2 + nr + 2 * (uint64_t)np * nr);
+    h.h1 ^= words;
+    h.h2 ^= words;
+    h.h1 += h.h2;
+    h.h2 += h.h1;
+    h.h1 = fmix32(h.h1);
+    h.h2 = fmix32(h.h2);
+    h.h1 += h.h2;
+    h.h2 += h.h1;
+    return ((uint64_t)h.h1 << 32) | h.h2;
+}
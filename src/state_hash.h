@@ -0,0 +1,25 @@
+/*
+ * Deadlock Detection System
+ * Canonical 64-bit hash of a system state
+ */
+
+#ifndef STATE_HASH_H
+#define STATE_HASH_H
+
+#include <stdint.h>
+#include "deadlock_detector.h"
+
+/**
+ * Hash the canonical int32 words of a state
+ * The words are num_processes, num_resources, available[nr], then
+ * allocation and max_need row by row (nr entries each, no padding). Two
+ * 32-bit MurmurHash3-style lanes with different constants run side by side
+ * and are combined at the end; api/src/stateHash.ts computes the same value
+ * with Math.imul, so keys from either side are interchangeable.
+ * Need is not hashed; it follows from the rest.
+ * @param state Pointer to SystemState
+ * @return The hash; printed as %016llx it matches stateHash() in the API
+ */
+uint64_t state_hash(const SystemState *state);
+
+#endif // STATE_HASH_H
@@ -0,0 +1,49 @@
+/*
+ * Deadlock Detection System
+ * Phase timers and work counters
+ */
+
+#define _POSIX_C_SOURCE 200809L  /* clock_gettime */
+
+#include <string.h>
+#include <time.h>
+#include "stats.h"
+
+bool stats_enabled = false;
+STATS_THREAD_LOCAL Stats stats;
+
+long long stats_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+void stats_reset(void) {
+    memset(&stats, 0, sizeof(stats));
+}
+
+void stats_finish(long long execute_ns) {
+    long long timed = stats.phase_ns[STAT_NEED] + stats.phase_ns[STAT_DETECT] +
+                      stats.phase_ns[STAT_RAG];
+    stats.phase_ns[STAT_EMIT] = execute_ns > timed ? execute_ns - timed : 0;
+    stats.total_ns = stats.phase_ns[STAT_PARSE] + execute_ns;
+}
+
+void stats_write_json(JsonWriter *out) {
+    static const char *const names[STAT_NUM_PHASES] = {
+        "{\"parse_ns\":", ",\"need_ns\":", ",\"detect_ns\":", ",\"rag_ns\":", ",\"emit_ns\":"
+    };
+    for (int k = 0; k < STAT_NUM_PHASES; k++) {
+        json_str(out, names[k]);
+        json_ll(out, stats.phase_ns[k]);
+    }
+    json_lit(out, ",\"total_ns\":");
+    json_ll(out, stats.total_ns);
+    json_lit(out, ",\"passes\":");
+    json_ll(out, stats.passes);
+    json_lit(out, ",\"comparisons\":");
+    json_ll(out, stats.comparisons);
+    json_lit(out, ",\"edges\":");
+    json_ll(out, stats.edges);
+    json_char(out, '}');
+}
@@ -0,0 +1,86 @@
+/*
+ * Deadlock Detection System
+ * Phase timers and work counters
+ */
+
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdbool.h>
+#include "json_writer.h"
+
+// Timed phases; each is exclusive of the others
+typedef enum {
+    STAT_PARSE,         // reading the request and its state
+    STAT_NEED,          // calculate_need_matrix()
+    STAT_DETECT,        // detection, after Need
+    STAT_RAG,           // build_rag()
+    STAT_EMIT,          // the rest of the request, mostly writing the response
+    STAT_NUM_PHASES
+} StatPhase;
+
+typedef struct {
+    long long phase_ns[STAT_NUM_PHASES];
+    long long total_ns;
+    long long passes;       // detection passes (rounds for the parallel scan)
+    long long comparisons;  // Need-vs-Work row checks (worklist: rows plus wait-list cells)
+    long long edges;        // RAG edges built
+} Stats;
+
+// Collection is compiled in unless DEADLOCK_NO_STATS is defined
+// (STATS_COMPILED), and off until stats_enabled is set. Counters are per
+// thread: work done on other threads is added by the code that joins them,
+// or not at all.
+#if defined(__GNUC__)
+#define STATS_THREAD_LOCAL __thread
+#else
+#define STATS_THREAD_LOCAL
+#endif
+
+extern bool stats_enabled;
+extern STATS_THREAD_LOCAL Stats stats;
+
+#ifndef DEADLOCK_NO_STATS
+#define STATS_COMPILED true
+#define STATS_START(t) long long t = stats_enabled ? stats_now_ns() : 0
+#define STATS_STOP(phase, t)                                            \
+    do {                                                                \
+        if (stats_enabled) stats.phase_ns[phase] += stats_now_ns() - (t); \
+    } while (0)
+#define STATS_ADD(field, n)                                             \
+    do {                                                                \
+        if (stats_enabled) stats.field += (n);                          \
+    } while (0)
+#else
+#define STATS_COMPILED false
+#define STATS_START(t) long long t = 0
+#define STATS_STOP(phase, t) ((void)(t))
+#define STATS_ADD(field, n) ((void)0)
+#endif
+
+/**
+ * Monotonic clock in nanoseconds
+ */
+long long stats_now_ns(void);
+
+/**
+ * Zero this thread's counters
+ */
+void stats_reset(void);
+
+/**
+ * Close a request: STAT_EMIT becomes the part of execute_ns not covered
+ * by the other execution phases, and total_ns parse plus execution
+ * @param execute_ns Time spent executing the request (after parsing)
+ */
+void stats_finish(long long execute_ns);
+
+/**
+ * Write this thread's counters as one JSON object
+ * {"parse_ns":..,"need_ns":..,"detect_ns":..,"rag_ns":..,"emit_ns":..,
+ *  "total_ns":..,"passes":..,"comparisons":..,"edges":..}
+ * @param out Output buffer
+ */
+void stats_write_json(JsonWriter *out);
+
+#endif // STATS_H
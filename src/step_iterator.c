@@ -0,0 +1,35 @@
+/*
+ * Deadlock Detection System
+ * Resumable step-by-step safety algorithm
+ */
+
+#include <string.h>
+#include "step_iterator.h"
+
+bool step_iterator_init(StepIterator *it, SystemState *state) {
+    memset(it, 0, sizeof(*it));
+    it->state = *state;
+    memset(state, 0, sizeof(*state));
+    it->last = -1;
+    if (!worklist_applicable(&it->state)) return false;
+    calculate_need_matrix(&it->state);
+    worklist_init(&it->wl, &it->state);
+    return true;
+}
+
+StepStatus step_iterator_next(StepIterator *it) {
+    it->last = worklist_step(&it->wl);
+    if (it->last >= 0) {
+        it->status = STEP_FOUND;
+    } else if (it->wl.sequence_length == it->state.num_processes) {
+        it->status = STEP_DONE;
+    } else {
+        it->status = STEP_DEADLOCK;
+    }
+    return it->status;
+}
+
+void step_iterator_free(StepIterator *it) {
+    if (it->wl.state) worklist_free(&it->wl);
+    free_system_state(&it->state);
+}
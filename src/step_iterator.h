@@ -0,0 +1,57 @@
+/*
+ * Deadlock Detection System
+ * Resumable step-by-step safety algorithm
+ */
+
+#ifndef STEP_ITERATOR_H
+#define STEP_ITERATOR_H
+
+#include <stdbool.h>
+#include "deadlock_detector.h"
+#include "worklist.h"
+
+typedef enum {
+    STEP_FOUND,         // a process was finished
+    STEP_DONE,          // every process has finished
+    STEP_DEADLOCK       // the unfinished processes can never run
+} StepStatus;
+
+// Step iterator
+// Each step finishes the lowest-numbered unfinished process whose Need fits
+// Work, like a scan from process 0 would, but on the worklist engine: a
+// step costs the heap operations plus the resources its process releases,
+// not a rescan of every process. Work, the finish set and the sequence so
+// far are wl.work, wl.finish and wl.sequence. The iterator points into
+// itself, so it must not be moved after step_iterator_init().
+typedef struct {
+    SystemState state;
+    Worklist wl;
+    int last;           // process finished by the last step, -1 if none
+    StepStatus status;  // status of the last step
+} StepIterator;
+
+/**
+ * Take over a state and prepare its first step
+ * @param it Pointer to StepIterator
+ * @param state State to take over (need is recalculated); it is zeroed on
+ *        return and owned by the iterator even on failure
+ * @return false if an allocation is negative (Work could shrink, which the
+ *         worklist engine does not model)
+ */
+bool step_iterator_init(StepIterator *it, SystemState *state);
+
+/**
+ * Run one step of the safety algorithm
+ * Once DONE or DEADLOCK is reported, later calls report it again.
+ * @param it Pointer to StepIterator
+ * @return Status of the step; it->last is the process for STEP_FOUND
+ */
+StepStatus step_iterator_next(StepIterator *it);
+
+/**
+ * Release memory owned by an iterator
+ * @param it Pointer to StepIterator
+ */
+void step_iterator_free(StepIterator *it);
+
+#endif // STEP_ITERATOR_H
@@ -0,0 +1,293 @@
+/*
+ * Deadlock Detection System
+ * Fast text input: integers, words and system states
+ */
+
+#define _POSIX_C_SOURCE 200809L  /* mmap, fstat */
+
+#include <fcntl.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "text_reader.h"
+
+// Initial window for line mode; it grows for longer lines
+#define LINE_CHUNK 4096
+
+static void init_window(TextReader *r, const char *data, size_t length) {
+    memset(r, 0, sizeof(*r));
+    r->start = r->pos = data;
+    r->end = data + length;
+    r->line = 1;
+}
+
+void text_reader_init_buffer(TextReader *r, const char *data, size_t length) {
+    init_window(r, data, length);
+}
+
+void text_reader_init_file(TextReader *r, FILE *file, bool lines) {
+    init_window(r, NULL, 0);
+    r->file = file;
+    r->lines = lines;
+}
+
+bool text_reader_open(TextReader *r, const char *path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return false;
+    }
+    size_t length = (size_t)st.st_size;
+    void *map = NULL;
+    if (length > 0) {
+        map = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map == MAP_FAILED) {
+            close(fd);
+            return false;
+        }
+    }
+    close(fd);
+    init_window(r, map, length);
+    r->map = map;
+    r->map_length = length;
+    return true;
+}
+
+void text_reader_free(TextReader *r) {
+    if (r->map) munmap(r->map, r->map_length);
+    free(r->buffer);
+    init_window(r, NULL, 0);
+}
+
+// Stream offset of a byte in the window
+static long long offset_of(const TextReader *r, const char *p) {
+    return r->base + (p - r->start);
+}
+
+// Make room for at least n bytes after the window's contents
+static void reserve_window(TextReader *r, size_t n) {
+    size_t tail = (size_t)(r->end - r->start);
+    if (r->capacity < tail + n + 1) {
+        size_t capacity = r->capacity ? r->capacity : n + 1;
+        while (capacity < tail + n + 1) capacity *= 2;
+        // On failure the old buffer stays owned by the reader, so a handler
+        // that returns to the caller leaves text_reader_free() valid
+        char *buffer = realloc(r->buffer, capacity);
+        if (!buffer) out_of_memory();
+        r->buffer = buffer;
+        r->capacity = capacity;
+    }
+}
+
+// Move the unread tail to the front of the buffer and read more after it.
+// Returns false if the source was already exhausted; otherwise the window
+// has moved (even if nothing new arrived) and callers must rescan from pos.
+static bool refill(TextReader *r) {
+    if (!r->file || r->eof) return false;
+    size_t tail = (size_t)(r->end - r->pos);
+    size_t skip = (size_t)(r->pos - r->start);
+    r->base += (long long)skip;
+    reserve_window(r, r->lines ? LINE_CHUNK : TEXT_READER_CHUNK);
+    // realloc may have moved the buffer, so pos is found again by offset
+    if (tail > 0) memmove(r->buffer, r->buffer + skip, tail);
+    r->start = r->pos = r->buffer;
+    size_t used = tail;
+
+    if (r->lines) {
+        // One line, however long: grow until fgets stops at a newline
+        for (;;) {
+            size_t room = r->capacity - used;
+            if (!fgets(r->buffer + used, (int)(room > INT_MAX ? INT_MAX : room), r->file)) {
+                r->eof = true;
+                break;
+            }
+            used += strlen(r->buffer + used);
+            if (used > 0 && r->buffer[used - 1] == '\n') break;
+            r->end = r->buffer + used;
+            reserve_window(r, r->capacity);
+            r->start = r->pos = r->buffer;
+        }
+    } else {
+        size_t n = fread(r->buffer + used, 1, r->capacity - used - 1, r->file);
+        if (n == 0) r->eof = true;
+        used += n;
+    }
+    r->end = r->buffer + used;
+    return true;
+}
+
+// Skip whitespace and comments; false at the end of input
+static bool skip_space(TextReader *r) {
+    bool comment = false;
+    for (;;) {
+        const char *p = r->pos;
+        const char *end = r->end;
+        while (p < end) {
+            char c = *p;
+            if (c == '\n') {
+                p++;
+                comment = false;
+                r->line++;
+                r->line_offset = offset_of(r, p);
+            } else if (comment || c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f') {
+                p++;
+            } else if (c == '#') {
+                comment = true;
+                p++;
+            } else {
+                r->pos = p;
+                return true;
+            }
+        }
+        r->pos = p;
+        if (!refill(r)) return false;
+    }
+}
+
+static bool is_space(char c) {
+    return c == ' ' || c == '\n' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+bool text_read_int(TextReader *r, int *value) {
+    if (!skip_space(r)) return false;
+    for (;;) {
+        const char *p = r->pos;
+        const char *end = r->end;
+        bool negative = *p == '-';
+        if (*p == '-' || *p == '+') p++;
+        const char *first = p;
+        while (p < end && *p == '0') p++;
+        const char *digits = p;
+        unsigned long long v = 0;
+        while (p < end && (unsigned)(*p - '0') < 10) {
+            v = v * 10 + (unsigned)(*p - '0');
+            p++;
+            if (p - digits > 10) return false;  // beyond any int
+        }
+        // A token that reaches the end of the window may go on in the next read
+        if (p == end && refill(r)) continue;
+        if (p == first) return false;
+        if (v > (negative ? (unsigned long long)INT_MAX + 1 : (unsigned long long)INT_MAX)) {
+            return false;
+        }
+        *value = (int)(negative ? -(long long)v : (long long)v);
+        r->pos = p;
+        return true;
+    }
+}
+
+int text_peek(TextReader *r) {
+    return skip_space(r) ? (unsigned char)*r->pos : EOF;
+}
+
+bool text_read_word(TextReader *r, char *word, size_t size) {
+    if (!skip_space(r)) return false;
+    for (;;) {
+        const char *p = r->pos;
+        while (p < r->end && !is_space(*p)) p++;
+        if (p == r->end && refill(r)) continue;
+        size_t n = (size_t)(p - r->pos);
+        if (n > size - 1) n = size - 1;
+        memcpy(word, r->pos, n);
+        word[n] = '\0';
+        r->pos = p;
+        return true;
+    }
+}
+
+static bool is_label_char(char c) {
+    return (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') ||
+           c == '_' || c == ' ' || c == '\t';
+}
+
+bool text_read_label(TextReader *r, char *name, size_t size) {
+    if (!skip_space(r)) return false;
+    for (;;) {
+        const char *p = r->pos;
+        char c = *p;
+        if (!((c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z'))) return false;
+        while (p < r->end && is_label_char(*p)) p++;
+        if (p == r->end && refill(r)) continue;
+        if (p == r->end || *p != ':') return false;
+        const char *last = p;
+        while (last > r->pos && (last[-1] == ' ' || last[-1] == '\t')) last--;
+        size_t n = (size_t)(last - r->pos);
+        if (n > size - 1) n = size - 1;
+        memcpy(name, r->pos, n);
+        name[n] = '\0';
+        r->pos = p + 1;
+        return true;
+    }
+}
+
+const char *text_reader_error(TextReader *r, const char *what) {
+    snprintf(r->message, sizeof(r->message), "%s at line %lld, column %lld", what, r->line,
+             offset_of(r, r->pos) - r->line_offset + 1);
+    return r->message;
+}
+
+// Why the last text_read_int() failed
+static const char *int_error(TextReader *r) {
+    if (r->pos == r->end) return text_reader_error(r, "truncated state");
+    return text_reader_error(r, "invalid integer");
+}
+
+static const char *read_row(TextReader *r, int *row, int n, bool labelled) {
+    char label[32];
+    if (labelled) text_read_label(r, label, sizeof(label));  // optional "P0:"
+    for (int j = 0; j < n; j++) {
+        if (!text_read_int(r, &row[j])) return int_error(r);
+    }
+    return NULL;
+}
+
+// Read "Name:" where name is one of the accepted spellings (NULL-terminated)
+static const char *expect_label(TextReader *r, const char *const *names, const char *what) {
+    char label[32];
+    if (text_read_label(r, label, sizeof(label))) {
+        for (int k = 0; names[k]; k++) {
+            if (strcmp(label, names[k]) == 0) return NULL;
+        }
+    }
+    return text_reader_error(r, what);
+}
+
+const char *text_read_state(TextReader *r, SystemState *state) {
+    static const char *const processes[] = { "Processes", NULL };
+    static const char *const resources[] = { "Resources", NULL };
+    static const char *const available[] = { "Available", NULL };
+    static const char *const allocation[] = { "Allocation", NULL };
+    static const char *const maximum[] = { "Maximum", "Max", "Max Need", NULL };
+    const char *err;
+    int np, nr;
+
+    // A letter where the dimensions belong means the labelled format
+    bool labelled = skip_space(r) && ((*r->pos >= 'A' && *r->pos <= 'Z') ||
+                                      (*r->pos >= 'a' && *r->pos <= 'z'));
+    if (labelled && (err = expect_label(r, processes, "expected Processes:"))) return err;
+    if (!text_read_int(r, &np)) return text_reader_error(r, "invalid dimensions");
+    if (labelled && (err = expect_label(r, resources, "expected Resources:"))) return err;
+    if (!text_read_int(r, &nr) || np < 1 || nr < 1 || np > MAX_PROCESSES || nr > MAX_RESOURCES) {
+        return text_reader_error(r, "invalid dimensions");
+    }
+    if (!init_system_state(state, np, nr)) {
+        return "out of memory";
+    }
+
+    if (labelled && (err = expect_label(r, available, "expected Available:"))) return err;
+    if ((err = read_row(r, state->available, nr, false))) return err;
+    if (labelled && (err = expect_label(r, allocation, "expected Allocation:"))) return err;
+    for (int i = 0; i < np; i++) {
+        if ((err = read_row(r, state->allocation[i], nr, labelled))) return err;
+    }
+    if (labelled && (err = expect_label(r, maximum, "expected Maximum:"))) return err;
+    for (int i = 0; i < np; i++) {
+        if ((err = read_row(r, state->max_need[i], nr, labelled))) return err;
+    }
+    return NULL;
+}
@@ -0,0 +1,118 @@
+/*
+ * Deadlock Detection System
+ * Fast text input: integers, words and system states header file
+ */
+
+#ifndef TEXT_READER_H
+#define TEXT_READER_H
+
+#include <stdbool.h>
+#include <stdio.h>
+#include "deadlock_detector.h"
+
+// Bytes read per refill when the reader owns the rest of a stream
+#define TEXT_READER_CHUNK (1 << 20)
+
+// Parses integers from a window of bytes with a hand-written loop instead of
+// one scanf() per value. The window is a caller's buffer, an mmap'd file or
+// chunks read from a stream. Whitespace separates tokens, and '#' starts a
+// comment that runs to the end of the line. Line and column are tracked so
+// errors can say where the input went wrong.
+typedef struct {
+    const char *pos;        // next unread byte
+    const char *end;        // end of the bytes available so far
+    const char *start;      // start of the window (offset base)
+    long long base;         // stream offset of start
+    long long line;         // line of pos, from 1
+    long long line_offset;  // stream offset where that line starts
+    FILE *file;             // refill source, or NULL
+    bool lines;             // refill one line at a time (interactive input)
+    bool eof;               // file has no more bytes
+    char *buffer;           // window storage for a file source
+    size_t capacity;
+    void *map;              // mmap'd file, or NULL
+    size_t map_length;
+    char message[128];      // last text_reader_error()
+} TextReader;
+
+/**
+ * Read from a caller-owned buffer (it must outlive the reader)
+ * @param r Pointer to TextReader
+ * @param data Bytes to parse
+ * @param length Number of bytes
+ */
+void text_reader_init_buffer(TextReader *r, const char *data, size_t length);
+
+/**
+ * Read from a stream
+ * In chunk mode the reader may consume the stream to its end; in line mode
+ * it takes one line per refill, so the stream can still be used (e.g. by
+ * scanf) after the values of a line have been parsed.
+ * @param r Pointer to TextReader
+ * @param file Stream to read
+ * @param lines true for line mode, false for TEXT_READER_CHUNK reads
+ */
+void text_reader_init_file(TextReader *r, FILE *file, bool lines);
+
+/**
+ * Map a file into memory and read from it
+ * @param r Pointer to TextReader
+ * @param path File to map
+ * @return false (with errno set) if it cannot be opened or mapped
+ */
+bool text_reader_open(TextReader *r, const char *path);
+
+/**
+ * Release the reader's window or mapping (unread bytes are dropped)
+ * @param r Pointer to TextReader
+ */
+void text_reader_free(TextReader *r);
+
+/**
+ * Parse the next integer ("%d" syntax: optional sign, then digits)
+ * @param r Pointer to TextReader
+ * @param value Receives the integer
+ * @return false, consuming nothing but whitespace, at the end of input, at
+ *   a byte that cannot start an integer, or for a value outside int
+ */
+bool text_read_int(TextReader *r, int *value);
+
+/**
+ * Next byte after whitespace and comments, without consuming it
+ * @return The byte, or EOF at the end of input
+ */
+int text_peek(TextReader *r);
+
+/**
+ * Read the next whitespace-delimited word ("%s" syntax, truncated to size - 1)
+ * @return false at the end of input
+ */
+bool text_read_word(TextReader *r, char *word, size_t size);
+
+/**
+ * Read a "Name:" label if one comes next (a letter, then letters, digits,
+ * spaces or underscores up to a colon on the same line)
+ * @param name Receives the name without the colon (truncated to size - 1)
+ * @return false, consuming nothing but whitespace, if no label comes next
+ */
+bool text_read_label(TextReader *r, char *name, size_t size);
+
+/**
+ * Format "<what> at line L, column C" for the next unread byte
+ * @return r->message, valid until the next call
+ */
+const char *text_reader_error(TextReader *r, const char *what);
+
+/**
+ * Read a system state in either text format
+ * Plain (api_worker): num_processes num_resources, available, then the
+ * allocation and max_need rows. Labelled (the test fixtures): "Processes: n",
+ * "Resources: m", "Available: ...", "Allocation:" and "Maximum:" ("Max:"),
+ * each matrix row optionally labelled ("P0: 0 1 0").
+ * @param r Pointer to TextReader
+ * @param state Receives the state (initialized here; need is not calculated)
+ * @return Error message with its position, or NULL on success
+ */
+const char *text_read_state(TextReader *r, SystemState *state);
+
+#endif // TEXT_READER_H
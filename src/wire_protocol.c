@@ -0,0 +1,129 @@
+/*
+ * Deadlock Detection System
+ * Binary wire protocol between the Node backend and api_worker
+ */
+
+#include <string.h>
+#include "wire_protocol.h"
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define WIRE_SWAP 1
+#endif
+
+static uint32_t le32(uint32_t v) {
+#ifdef WIRE_SWAP
+    return __builtin_bswap32(v);
+#else
+    return v;
+#endif
+}
+
+static void put_u32(JsonWriter *out, uint32_t v) {
+    v = le32(v);
+    json_raw(out, &v, sizeof(v));
+}
+
+bool wire_read_request_header(FILE *in, WireRequestHeader *header) {
+    unsigned char magic[3];
+    uint32_t words[8];
+    if (fread(magic, 1, sizeof(magic), in) != sizeof(magic) ||
+        memcmp(magic, "DLB", 3) != 0 ||
+        fread(words, sizeof(uint32_t), 8, in) != 8) {
+        return false;
+    }
+    header->id = le32(words[0]);
+    header->command = le32(words[1]);
+    header->length = le32(words[2]);
+    header->num_processes = (int32_t)le32(words[3]);
+    header->num_resources = (int32_t)le32(words[4]);
+    for (int k = 0; k < 3; k++) {
+        header->args[k] = (int32_t)le32(words[5 + k]);
+    }
+    return true;
+}
+
+bool wire_read_ints(WireReader *reader, int *dst, size_t n) {
+    if (n > reader->remaining / sizeof(int32_t)) {
+        return false;
+    }
+    size_t got = fread(dst, sizeof(int32_t), n, reader->in);
+    reader->remaining -= got * sizeof(int32_t);
+    if (got != n) {
+        reader->eof = true;
+        return false;
+    }
+#ifdef WIRE_SWAP
+    for (size_t k = 0; k < n; k++) {
+        dst[k] = (int)le32((uint32_t)dst[k]);
+    }
+#endif
+    return true;
+}
+
+const char *wire_read_state(WireReader *reader, int num_processes, int num_resources,
+                            SystemState *state) {
+    if (num_processes < 1 || num_resources < 1 ||
+        num_processes > MAX_PROCESSES || num_resources > MAX_RESOURCES) {
+        return "invalid dimensions";
+    }
+    // Reject a short payload before allocating for it
+    size_t cells = (size_t)num_resources * (2 * (size_t)num_processes + 1);
+    if (cells > reader->remaining / sizeof(int32_t)) {
+        return "truncated state";
+    }
+    if (!init_system_state(state, num_processes, num_resources)) {
+        return "out of memory";
+    }
+
+    // Rows are padded to row_stride, so each one is read separately
+    if (!wire_read_ints(reader, state->available, (size_t)num_resources)) return "truncated state";
+    for (int i = 0; i < num_processes; i++) {
+        if (!wire_read_ints(reader, state->allocation[i], (size_t)num_resources)) return "truncated state";
+    }
+    for (int i = 0; i < num_processes; i++) {
+        if (!wire_read_ints(reader, state->max_need[i], (size_t)num_resources)) return "truncated state";
+    }
+    return NULL;
+}
+
+void wire_skip(WireReader *reader) {
+    char scratch[4096];
+    while (reader->remaining > 0 && !reader->eof) {
+        size_t chunk = reader->remaining < sizeof(scratch) ? reader->remaining : sizeof(scratch);
+        size_t got = fread(scratch, 1, chunk, reader->in);
+        reader->remaining -= got;
+        if (got != chunk) reader->eof = true;
+    }
+}
+
+void wire_write_detect(JsonWriter *out, const DetectionResult *result) {
+    put_u32(out, result->is_deadlocked ? 1u : 0u);
+    put_u32(out, (uint32_t)result->num_deadlocked);
+    put_u32(out, (uint32_t)result->safe_sequence_length);
+#ifdef WIRE_SWAP
+    for (int i = 0; i < result->num_deadlocked; i++) {
+        put_u32(out, (uint32_t)result->deadlocked_processes[i]);
+    }
+    for (int i = 0; i < result->safe_sequence_length; i++) {
+        put_u32(out, (uint32_t)result->safe_sequence[i]);
+    }
+#else
+    json_raw(out, result->deadlocked_processes, (size_t)result->num_deadlocked * sizeof(int32_t));
+    json_raw(out, result->safe_sequence, (size_t)result->safe_sequence_length * sizeof(int32_t));
+#endif
+}
+
+void wire_write_detect_error(JsonWriter *out) {
+    put_u32(out, (uint32_t)-1);
+    put_u32(out, 0);
+    put_u32(out, 0);
+}
+
+void wire_write_reply(JsonWriter *out, uint32_t id, WireReplyKind kind,
+                      const void *payload, size_t length) {
+    json_raw(out, "\x7f" "DLR", 4);
+    put_u32(out, id);
+    put_u32(out, (uint32_t)kind);
+    put_u32(out, (uint32_t)length);
+    json_raw(out, payload, length);
+}
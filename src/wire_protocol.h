@@ -0,0 +1,128 @@
+/*
+ * Deadlock Detection System
+ * Binary wire protocol between the Node backend and api_worker
+ */
+
+#ifndef WIRE_PROTOCOL_H
+#define WIRE_PROTOCOL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "deadlock_detector.h"
+#include "json_writer.h"
+
+// All fields are little-endian 32-bit integers.
+//
+// Request frame: 36-byte header, then `length` payload bytes
+//   magic  0x7F 'D' 'L' 'B'     id  command  length
+//   num_processes  num_resources  arg0  arg1  arg2
+// DETECT / RAG / RESOLVE / SIMULATE / HEADROOM / PLAN / HASH payload:
+//   available[nr], allocation[np * nr], max_need[np * nr]
+//   RESOLVE uses arg0 (victim, -1 for auto); SIMULATE uses arg0..arg2
+//   PLAN uses arg0 (cost model) and arg1 (max candidates); with the priority
+//   cost model, max_need is followed by priorities[np]
+// STEP_START: the DETECT payload
+// STEP / STEP_END: arg0 = session id; no payload, the dimensions are unused
+// BATCH_DETECT: arg0 = number of states; the header dimensions are unused and
+//   the payload is that many (np, nr, available, allocation, max_need) records
+//
+// Response frame: 16-byte header, then `length` payload bytes
+//   magic  0x7F 'D' 'L' 'R'     id  kind  length
+// WIRE_REPLY_DETECT payload: is_deadlocked, num_deadlocked,
+//   safe_sequence_length, deadlocked_processes[], safe_sequence[]
+// WIRE_REPLY_BATCH payload: one DETECT record per state, in order; a state
+//   that could not be read is the record (-1, 0, 0) and ends the batch
+// WIRE_REPLY_JSON: the text protocol's JSON response (RAG, RESOLVE, SIMULATE,
+//   HEADROOM, PLAN, STEP_START, STEP, STEP_END, HASH)
+// WIRE_REPLY_ERROR: an error message (UTF-8, not JSON)
+// WIRE_REPLY_STATS: with api_worker --stats, sent just before the reply with
+//   the same id; the stats JSON object of stats.h
+//
+// 0x7F cannot start a text command or a text frame header, so a reader can
+// tell the two framings apart from the first byte.
+
+#define WIRE_MARKER 0x7F
+#define WIRE_REQUEST_HEADER_SIZE 36
+#define WIRE_RESPONSE_HEADER_SIZE 16
+
+typedef enum {
+    WIRE_CMD_DETECT = 1,
+    WIRE_CMD_RAG = 2,
+    WIRE_CMD_RESOLVE = 3,
+    WIRE_CMD_SIMULATE = 4,
+    WIRE_CMD_BATCH_DETECT = 5,
+    WIRE_CMD_HEADROOM = 6,
+    WIRE_CMD_PLAN = 7,
+    WIRE_CMD_STEP_START = 8,
+    WIRE_CMD_STEP = 9,
+    WIRE_CMD_STEP_END = 10,
+    WIRE_CMD_HASH = 11
+} WireCommand;
+
+typedef enum {
+    WIRE_REPLY_JSON = 0,
+    WIRE_REPLY_DETECT = 1,
+    WIRE_REPLY_BATCH = 2,
+    WIRE_REPLY_ERROR = 3,
+    WIRE_REPLY_STATS = 4
+} WireReplyKind;
+
+typedef struct {
+    uint32_t id;
+    uint32_t command;
+    uint32_t length;
+    int32_t num_processes;
+    int32_t num_resources;
+    int32_t args[3];
+} WireRequestHeader;
+
+// Bounded view of one frame's payload
+typedef struct {
+    FILE *in;
+    size_t remaining;   // payload bytes not read yet
+    bool eof;           // the stream ended inside the frame
+} WireReader;
+
+/**
+ * Read a request header whose marker byte has already been consumed
+ * @return false if the stream ended or the magic does not match
+ */
+bool wire_read_request_header(FILE *in, WireRequestHeader *header);
+
+/**
+ * Read n int32 values from the payload
+ * @return false if the payload is too short (or the stream ended)
+ */
+bool wire_read_ints(WireReader *reader, int *dst, size_t n);
+
+/**
+ * Allocate a state and read available, allocation and max_need into it
+ * @return Error message, or NULL on success
+ */
+const char *wire_read_state(WireReader *reader, int num_processes, int num_resources,
+                            SystemState *state);
+
+/**
+ * Discard the rest of the payload
+ */
+void wire_skip(WireReader *reader);
+
+/**
+ * Append a packed detection record (WIRE_REPLY_DETECT payload)
+ */
+void wire_write_detect(JsonWriter *out, const DetectionResult *result);
+
+/**
+ * Append the record for a batch entry that could not be read
+ */
+void wire_write_detect_error(JsonWriter *out);
+
+/**
+ * Write one response frame
+ */
+void wire_write_reply(JsonWriter *out, uint32_t id, WireReplyKind kind,
+                      const void *payload, size_t length);
+
+#endif // WIRE_PROTOCOL_H
@@ -0,0 +1,303 @@
+/*
+ * Deadlock Detection System
+ * Worklist (Holt-style) detection engine
+ *
+ * Cost is O(n*m) to build the wait lists, O(W log W) to sort the W
+ * blocked (process, resource) pairs and O(n log n) for the ready heaps,
+ * instead of the O(n^2 * m) worst case of rescanning after every pass.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "simd_kernels.h"
+#include "stats.h"
+#include "worklist.h"
+
+// Min-heap of process indices
+static void heap_push(int *heap, int *length, int value) {
+    int i = (*length)++;
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (heap[parent] <= value) break;
+        heap[i] = heap[parent];
+        i = parent;
+    }
+    heap[i] = value;
+}
+
+static int heap_pop(int *heap, int *length) {
+    int top = heap[0];
+    int last = heap[--(*length)];
+    int n = *length;
+    int i = 0;
+    for (;;) {
+        int child = 2 * i + 1;
+        if (child >= n) break;
+        if (child + 1 < n && heap[child + 1] < heap[child]) child++;
+        if (last <= heap[child]) break;
+        heap[i] = heap[child];
+        i = child;
+    }
+    if (n > 0) heap[i] = last;
+    return top;
+}
+
+static int compare_waits(const void *a, const void *b) {
+    const WaitEntry *x = a;
+    const WaitEntry *y = b;
+    if (x->need != y->need) return x->need < y->need ? -1 : 1;
+    return (x->process > y->process) - (x->process < y->process);
+}
+
+bool worklist_applicable(const SystemState *state) {
+    for (int i = 0; i < state->num_processes; i++) {
+        for (int j = 0; j < state->num_resources; j++) {
+            if (state->allocation[i][j] < 0) return false;
+        }
+    }
+    return true;
+}
+
+// Build blocked counts and sorted wait lists
+void worklist_init(Worklist *wl, const SystemState *state) {
+    int np = state->num_processes;
+    int nr = state->num_resources;
+
+    memset(wl, 0, sizeof(*wl));
+    wl->state = state;
+    int stride = state->row_stride;
+    wl->work = checked_malloc((size_t)stride * sizeof(int));
+    wl->blocked = checked_calloc((size_t)np, sizeof(int));
+    wl->finish = checked_calloc((size_t)np, sizeof(bool));
+    wl->wait_offsets = checked_calloc((size_t)nr + 1, sizeof(int));
+    wl->wait_cursor = checked_malloc((size_t)nr * sizeof(int));
+    wl->ready = checked_malloc((size_t)np * sizeof(int));
+    wl->deferred = checked_malloc((size_t)np * sizeof(int));
+    wl->sequence = checked_malloc((size_t)np * sizeof(int));
+    wl->pass_cursor = -1;
+
+    // Work = Available (padded like the matrix rows)
+    memcpy(wl->work, state->available, (size_t)stride * sizeof(int));
+
+    // First pass: count blocked resources per process with the vector
+    // kernel, then per resource only for processes that are blocked at all
+    int *count = wl->wait_offsets + 1;
+    for (int i = 0; i < np; i++) {
+        wl->blocked[i] = vec_count_gt(state->need[i], wl->work, stride);
+        if (wl->blocked[i] == 0) continue;
+        for (int j = 0; j < nr; j++) {
+            if (state->need[i][j] > wl->work[j]) {
+                count[j]++;
+            }
+        }
+    }
+    for (int j = 0; j < nr; j++) {
+        wl->wait_offsets[j + 1] += wl->wait_offsets[j];
+        wl->wait_cursor[j] = wl->wait_offsets[j];
+    }
+
+    // Second pass: scatter waiters, then sort each resource by need
+    wl->waits = checked_malloc((size_t)wl->wait_offsets[nr] * sizeof(WaitEntry));
+    for (int i = 0; i < np; i++) {
+        if (wl->blocked[i] == 0) continue;
+        for (int j = 0; j < nr; j++) {
+            if (state->need[i][j] > wl->work[j]) {
+                WaitEntry *w = &wl->waits[wl->wait_cursor[j]++];
+                w->need = state->need[i][j];
+                w->process = i;
+            }
+        }
+    }
+    for (int j = 0; j < nr; j++) {
+        wl->wait_cursor[j] = wl->wait_offsets[j];
+        qsort(wl->waits + wl->wait_offsets[j],
+              (size_t)(wl->wait_offsets[j + 1] - wl->wait_offsets[j]),
+              sizeof(WaitEntry), compare_waits);
+    }
+
+    // Processes with nothing outstanding are ready; ascending order is a valid heap
+    for (int i = 0; i < np; i++) {
+        if (wl->blocked[i] == 0) {
+            wl->ready[wl->ready_length++] = i;
+        }
+    }
+    STATS_ADD(comparisons, np);
+}
+
+// Mark a process finished and release its allocation into Work
+static void release_process(Worklist *wl, int p) {
+    const SystemState *state = wl->state;
+    wl->finish[p] = true;
+    wl->sequence[wl->sequence_length++] = p;
+    long long checked = 0;
+
+    for (int j = 0; j < state->num_resources; j++) {
+        int amount = state->allocation[p][j];
+        if (amount == 0) continue;
+        wl->work[j] += amount;
+
+        // Waiters on j whose need now fits lose one blocking resource
+        int end = wl->wait_offsets[j + 1];
+        int k = wl->wait_cursor[j];
+        while (k < end && wl->waits[k].need <= wl->work[j]) {
+            int q = wl->waits[k].process;
+            if (--wl->blocked[q] == 0 && !wl->finish[q]) {
+                // A pass-by-pass scan would still reach q in this pass only
+                // if it lies after the process just taken
+                if (q > wl->pass_cursor) {
+                    heap_push(wl->ready, &wl->ready_length, q);
+                } else {
+                    heap_push(wl->deferred, &wl->deferred_length, q);
+                }
+            }
+            k++;
+        }
+        checked += k - wl->wait_cursor[j];
+        wl->wait_cursor[j] = k;
+    }
+    STATS_ADD(comparisons, checked);
+}
+
+// Finish every process that can run
+void worklist_run(Worklist *wl) {
+    long long passes = 1;
+    for (;;) {
+        if (wl->ready_length == 0) {
+            if (wl->deferred_length == 0) break;
+            passes++;
+            // Start the next pass from process 0
+            int *tmp = wl->ready;
+            wl->ready = wl->deferred;
+            wl->deferred = tmp;
+            wl->ready_length = wl->deferred_length;
+            wl->deferred_length = 0;
+            wl->pass_cursor = -1;
+        }
+        int p = heap_pop(wl->ready, &wl->ready_length);
+        wl->pass_cursor = p;
+        release_process(wl, p);
+    }
+    STATS_ADD(passes, passes);
+}
+
+// Finish the lowest-numbered process that can run
+int worklist_step(Worklist *wl) {
+    // With the cursor before process 0 every process that becomes ready
+    // joins the one heap, so its minimum is what a scan from 0 finds first
+    while (wl->deferred_length > 0) {
+        heap_push(wl->ready, &wl->ready_length, heap_pop(wl->deferred, &wl->deferred_length));
+    }
+    wl->pass_cursor = -1;
+    if (wl->ready_length == 0) return -1;
+    int p = heap_pop(wl->ready, &wl->ready_length);
+    release_process(wl, p);
+    return p;
+}
+
+// Terminate a process that cannot finish: its allocation goes back into
+// Work and a new pass starts from process 0
+void worklist_terminate(Worklist *wl, int p) {
+    wl->pass_cursor = -1;
+    release_process(wl, p);
+}
+
+// Copy a worklist's progress into dst (allocated on first use); dst's
+// sequence is not copied, only its length
+void worklist_copy(Worklist *dst, const Worklist *src) {
+    const SystemState *state = src->state;
+    size_t np = (size_t)state->num_processes;
+    size_t nr = (size_t)state->num_resources;
+    size_t num_waits = (size_t)src->wait_offsets[nr];
+    if (!dst->state) {
+        dst->work = checked_malloc((size_t)state->row_stride * sizeof(int));
+        dst->blocked = checked_malloc(np * sizeof(int));
+        dst->finish = checked_malloc(np * sizeof(bool));
+        dst->wait_offsets = checked_malloc((nr + 1) * sizeof(int));
+        dst->waits = checked_malloc((num_waits ? num_waits : 1) * sizeof(WaitEntry));
+        dst->wait_cursor = checked_malloc(nr * sizeof(int));
+        dst->ready = checked_malloc(np * sizeof(int));
+        dst->deferred = checked_malloc(np * sizeof(int));
+        dst->sequence = checked_malloc(np * sizeof(int));
+        dst->state = state;
+        // The wait lists never change after worklist_init()
+        memcpy(dst->wait_offsets, src->wait_offsets, (nr + 1) * sizeof(int));
+        memcpy(dst->waits, src->waits, num_waits * sizeof(WaitEntry));
+    }
+    memcpy(dst->work, src->work, (size_t)state->row_stride * sizeof(int));
+    memcpy(dst->blocked, src->blocked, np * sizeof(int));
+    memcpy(dst->finish, src->finish, np * sizeof(bool));
+    memcpy(dst->wait_cursor, src->wait_cursor, nr * sizeof(int));
+    memcpy(dst->ready, src->ready, (size_t)src->ready_length * sizeof(int));
+    memcpy(dst->deferred, src->deferred, (size_t)src->deferred_length * sizeof(int));
+    // Only the length of the sequence matters to a copy; entries past it
+    // are written before they are read
+    dst->ready_length = src->ready_length;
+    dst->deferred_length = src->deferred_length;
+    dst->pass_cursor = src->pass_cursor;
+    dst->sequence_length = src->sequence_length;
+}
+
+// Save a worklist's progress; the wait lists are shared with the worklist
+void worklist_save(WorklistMark *mark, const Worklist *wl) {
+    const SystemState *state = wl->state;
+    size_t np = (size_t)state->num_processes;
+    size_t nr = (size_t)state->num_resources;
+    mark->work = checked_malloc((size_t)state->row_stride * sizeof(int));
+    mark->blocked = checked_malloc(np * sizeof(int));
+    mark->finish = checked_malloc(np * sizeof(bool));
+    mark->wait_cursor = checked_malloc(nr * sizeof(int));
+    mark->ready = checked_malloc(((size_t)wl->ready_length + 1) * sizeof(int));
+    mark->deferred = checked_malloc(((size_t)wl->deferred_length + 1) * sizeof(int));
+    memcpy(mark->work, wl->work, (size_t)state->row_stride * sizeof(int));
+    memcpy(mark->blocked, wl->blocked, np * sizeof(int));
+    memcpy(mark->finish, wl->finish, np * sizeof(bool));
+    memcpy(mark->wait_cursor, wl->wait_cursor, nr * sizeof(int));
+    memcpy(mark->ready, wl->ready, (size_t)wl->ready_length * sizeof(int));
+    memcpy(mark->deferred, wl->deferred, (size_t)wl->deferred_length * sizeof(int));
+    mark->ready_length = wl->ready_length;
+    mark->deferred_length = wl->deferred_length;
+    mark->pass_cursor = wl->pass_cursor;
+    mark->sequence_length = wl->sequence_length;
+}
+
+// Return a worklist to a saved point
+void worklist_restore(Worklist *wl, const WorklistMark *mark) {
+    const SystemState *state = wl->state;
+    size_t np = (size_t)state->num_processes;
+    size_t nr = (size_t)state->num_resources;
+    memcpy(wl->work, mark->work, (size_t)state->row_stride * sizeof(int));
+    memcpy(wl->blocked, mark->blocked, np * sizeof(int));
+    memcpy(wl->finish, mark->finish, np * sizeof(bool));
+    memcpy(wl->wait_cursor, mark->wait_cursor, nr * sizeof(int));
+    memcpy(wl->ready, mark->ready, (size_t)mark->ready_length * sizeof(int));
+    memcpy(wl->deferred, mark->deferred, (size_t)mark->deferred_length * sizeof(int));
+    wl->ready_length = mark->ready_length;
+    wl->deferred_length = mark->deferred_length;
+    wl->pass_cursor = mark->pass_cursor;
+    wl->sequence_length = mark->sequence_length;
+}
+
+// Release memory owned by a mark
+void worklist_mark_free(WorklistMark *mark) {
+    free(mark->work);
+    free(mark->blocked);
+    free(mark->finish);
+    free(mark->wait_cursor);
+    free(mark->ready);
+    free(mark->deferred);
+    memset(mark, 0, sizeof(*mark));
+}
+
+// Release memory owned by a worklist
+void worklist_free(Worklist *wl) {
+    free(wl->work);
+    free(wl->blocked);
+    free(wl->finish);
+    free(wl->wait_offsets);
+    free(wl->waits);
+    free(wl->wait_cursor);
+    free(wl->ready);
+    free(wl->deferred);
+    free(wl->sequence);
+    memset(wl, 0, sizeof(*wl));
+}
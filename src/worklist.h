@@ -0,0 +1,132 @@
+/*
+ * Deadlock Detection System
+ * Worklist (Holt-style) detection engine header file
+ */
+
+#ifndef WORKLIST_H
+#define WORKLIST_H
+
+#include <stdbool.h>
+#include "deadlock_detector.h"
+
+// A process waiting on one resource, keyed by its outstanding need
+typedef struct {
+    int need;
+    int process;
+} WaitEntry;
+
+// Worklist detector state
+// Instead of rescanning every unfinished process after each pass, every
+// process keeps a count of resources it is still blocked on, and every
+// resource keeps its waiters sorted by need. Releasing a process's
+// allocation advances a cursor through those sorted lists, so only the
+// processes it actually unblocks are touched.
+typedef struct {
+    const SystemState *state;
+    int *work;              // [num_resources]
+    int *blocked;           // [num_processes] resources with need > work
+    bool *finish;           // [num_processes]
+    int *wait_offsets;      // [num_resources + 1] CSR over waits
+    WaitEntry *waits;       // waiters per resource, sorted by need
+    int *wait_cursor;       // [num_resources] first still-blocked waiter
+    int *ready;             // min-heap of ready processes after the cursor
+    int ready_length;
+    int *deferred;          // min-heap of ready processes for the next pass
+    int deferred_length;
+    int pass_cursor;        // last process taken in the current pass
+    int *sequence;          // [num_processes] processes in finishing order
+    int sequence_length;
+} Worklist;
+
+// A worklist's progress at one point, to go back to it later
+typedef struct {
+    int *work;
+    int *blocked;
+    bool *finish;
+    int *wait_cursor;
+    int *ready;
+    int ready_length;
+    int *deferred;
+    int deferred_length;
+    int pass_cursor;
+    int sequence_length;
+} WorklistMark;
+
+/**
+ * Build blocked counts and sorted wait lists for a state
+ * Need must already be calculated. Requires non-negative allocations
+ * (Work may only grow); see worklist_applicable().
+ * @param wl Pointer to Worklist
+ * @param state Pointer to SystemState (must outlive the worklist)
+ */
+void worklist_init(Worklist *wl, const SystemState *state);
+
+/**
+ * Finish every process that can run, in the same order as the
+ * pass-by-pass scan of detect_deadlock_rescan()
+ * @param wl Pointer to Worklist
+ */
+void worklist_run(Worklist *wl);
+
+/**
+ * Finish one process: the lowest-numbered one that can run, which is the
+ * one a scan from process 0 would find first
+ * @param wl Pointer to Worklist
+ * @return The process finished, or -1 if none can run
+ */
+int worklist_step(Worklist *wl);
+
+/**
+ * Terminate an unfinished process after worklist_run() has stopped: its
+ * allocation is released as if it had finished (it joins the sequence) and
+ * the next worklist_run() continues with a new pass from process 0
+ * @param wl Pointer to Worklist
+ * @param p Process to terminate
+ */
+void worklist_terminate(Worklist *wl, int p);
+
+/**
+ * Copy a worklist's progress, e.g. to try a termination without committing
+ * The copy's sequence entries are not copied, only sequence_length
+ * @param dst Zeroed Worklist on first use, then a previous copy of the same worklist
+ * @param src Worklist to copy
+ */
+void worklist_copy(Worklist *dst, const Worklist *src);
+
+/**
+ * Save a worklist's progress: O(n + m) time and memory, the wait lists are
+ * not copied (they never change after worklist_init())
+ * @param mark Receives the progress; release with worklist_mark_free()
+ * @param wl Worklist to save
+ */
+void worklist_save(WorklistMark *mark, const Worklist *wl);
+
+/**
+ * Return a worklist to a saved point
+ * Sequence entries are not saved: entries before the mark's
+ * sequence_length must still be the ones the worklist had when it was saved.
+ * @param wl Worklist the mark was saved from
+ * @param mark Saved progress
+ */
+void worklist_restore(Worklist *wl, const WorklistMark *mark);
+
+/**
+ * Release memory owned by a mark
+ * @param mark Pointer to WorklistMark
+ */
+void worklist_mark_free(WorklistMark *mark);
+
+/**
+ * Release memory owned by a worklist
+ * @param wl Pointer to Worklist
+ */
+void worklist_free(Worklist *wl);
+
+/**
+ * Check that a state satisfies the worklist's monotonicity assumption
+ * @param state Pointer to SystemState
+ * @return true if no allocation is negative
+ */
+bool worklist_applicable(const SystemState *state);
+
+#endif // WORKLIST_H
@@ -0,0 +1,78 @@
+/*
+ * Deadlock Detection System
+ * Synthetic system states for benchmarks
+ */
+
+#include <stdlib.h>
+#include "workload.h"
+
+// splitmix64: small, fast and identical on every platform
+static uint64_t next_random(uint64_t *s) {
+    uint64_t z = (*s += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+static int random_below(uint64_t *s, int bound) {
+    return (int)(next_random(s) % (uint64_t)bound);
+}
+
+bool generate_workload(SystemState *state, const WorkloadParams *params) {
+    int np = params->num_processes;
+    int nr = params->num_resources;
+    int cycle = 0;
+    if (params->deadlock) {
+        cycle = params->cycle_length < 2 ? 2 : params->cycle_length;
+        if (cycle > np) cycle = np;
+        if (cycle < 2) return false;
+    }
+    if (np < 1 || nr < 1 || !init_system_state(state, np, nr)) {
+        return false;
+    }
+
+    uint64_t rng = params->seed;
+    int *order = checked_malloc((size_t)np * sizeof(int));
+    int *released = checked_calloc((size_t)nr, sizeof(int));
+    for (int i = 0; i < np; i++) order[i] = i;
+    for (int i = np - 1; i > 0; i--) {
+        int k = random_below(&rng, i + 1);
+        int t = order[i];
+        order[i] = order[k];
+        order[k] = t;
+    }
+
+    // The first np - cycle processes of the order finish in that order;
+    // available is raised just enough for each one's need in turn
+    for (int k = 0; k < np - cycle; k++) {
+        int p = order[k];
+        for (int j = 0; j < nr; j++) {
+            int held = random_below(&rng, 4);
+            int extra = random_below(&rng, 100) < params->contention ? 1 + random_below(&rng, 4) : 0;
+            state->allocation[p][j] = held;
+            state->max_need[p][j] = held + extra;
+            if (extra - released[j] > state->available[j]) {
+                state->available[j] = extra - released[j];
+            }
+            released[j] += held;
+        }
+    }
+
+    // The rest form the cycle: member k holds one unit of resource k % nr
+    // and waits for more of member k + 1's resource than the system has
+    for (int k = 0; k < cycle; k++) {
+        state->allocation[order[np - cycle + k]][k % nr] += 1;
+        released[k % nr] += 1;
+    }
+    for (int k = 0; k < cycle; k++) {
+        int p = order[np - cycle + k];
+        int r = (k + 1) % cycle % nr;
+        state->max_need[p][k % nr] = state->allocation[p][k % nr];
+        state->max_need[p][r] = state->allocation[p][r] + state->available[r] + released[r] + 1;
+    }
+
+    calculate_need_matrix(state);
+    free(order);
+    free(released);
+    return true;
+}
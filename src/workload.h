@@ -0,0 +1,34 @@
+/*
+ * Deadlock Detection System
+ * Synthetic system states for benchmarks
+ */
+
+#ifndef WORKLOAD_H
+#define WORKLOAD_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "deadlock_detector.h"
+
+// Knobs for generate_workload()
+typedef struct {
+    int num_processes;
+    int num_resources;
+    int contention;      // 0..100: percent of (process, resource) cells with outstanding need
+    bool deadlock;       // add a wait cycle that can never be satisfied
+    int cycle_length;    // processes in that cycle (2..num_processes)
+    uint64_t seed;
+} WorkloadParams;
+
+/**
+ * Fill a fresh state from the parameters (same seed, same state)
+ * Without a deadlock, available is the least that keeps a random process
+ * order safe, so the detector has to work for every step. With one, the
+ * cycle processes each hold a unit the next one needs more of than exists.
+ * @param state Receives the state; need is calculated
+ * @param params Generator knobs
+ * @return false if the dimensions are out of range or memory is exhausted
+ */
+bool generate_workload(SystemState *state, const WorkloadParams *params);
+
+#endif // WORKLOAD_H